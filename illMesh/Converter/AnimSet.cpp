@@ -5,20 +5,94 @@
 
 #include "illEngine/Logging/logging.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <utility>
+#include <vector>
+
 #include "AnimSet.h"
 
 const uint64_t ANIMSET_MAGIC = 0x494C414E53455430;		//ILANSET0 in 64 bit big endian
+const uint64_t ANIMSET_MAGIC_1 = 0x494C414E53455431;	//ILANSET1 in 64 bit big endian
+
+//reads the version 1 bone names and checks the hash table finds every one of them
+static void loadHashedNames(illFileSystem::File * openFile, uint16_t numBones, BoneRegistry& boneRegistry) {
+    uint16_t numBuckets;
+    openFile->readL16(numBuckets);
+
+    std::vector<uint32_t> seeds(numBuckets);
+
+    for(uint16_t bucket = 0; bucket < numBuckets; bucket++) {
+        openFile->readL32(seeds[bucket]);
+    }
+
+    std::vector<uint16_t> slots(numBones);
+
+    for(uint16_t slot = 0; slot < numBones; slot++) {
+        openFile->readL16(slots[slot]);
+    }
+
+    //padding so the name offsets are 4 byte aligned
+    if(numBones % 2) {
+        openFile->seekAhead(2);
+    }
+
+    std::vector<uint32_t> nameOffsets(numBones + 1);
+
+    //unsigned int so this can't wrap around when there are 65535 bones
+    for(unsigned int bone = 0; bone <= numBones; bone++) {
+        openFile->readL32(nameOffsets[bone]);
+    }
+
+    //the last offset is the size of the name block, every name has to start inside it
+    for(uint16_t bone = 0; bone < numBones; bone++) {
+        if(nameOffsets[bone] >= nameOffsets[numBones]) {
+            LOG_FATAL_ERROR("Animset bone name table is corrupt, name %u starts at %u past the end of the %u byte name block",
+                bone, nameOffsets[bone], nameOffsets[numBones]);
+        }
+    }
+
+    std::vector<char> names(nameOffsets[numBones] + 1, 0);
+
+    if(nameOffsets[numBones] > 0) {
+        openFile->read(&names[0], nameOffsets[numBones]);
+    }
+
+    for(uint16_t bone = 0; bone < numBones; bone++) {
+        const char * name = &names[nameOffsets[bone]];
+
+        if(boneRegistry.find(name) != BoneRegistry::NOT_FOUND) {
+            LOG_FATAL_ERROR("Animset has duplicate bone name %s.  This will cause problems when animating.", name);
+        }
+
+        boneRegistry.insert(name);
+
+        if(numBuckets == 0 || BoneRegistry::findPerfectHash(name, &seeds[0], numBuckets, &slots[0], numBones) != bone) {
+            LOG_FATAL_ERROR("Animset bone name hash table is corrupt, bone %s doesn't hash to its index", name);
+        }
+    }
+}
 
 void AnimSet::load(const char * path) {
     illFileSystem::File * openFile = illFileSystem::fileSystem->openRead(path);
 
     //read magic string
+    unsigned int version;
+
     {
 		uint64_t magic;
         openFile->readB64(magic);
 
-        if(magic != ANIMSET_MAGIC) {
-            LOG_FATAL_ERROR("Not a valid ILANSET0 file.");      //TODO: make this not fatal somehow
+        if(magic == ANIMSET_MAGIC) {
+            version = 0;
+        }
+        else if(magic == ANIMSET_MAGIC_1) {
+            version = 1;
+        }
+        else {
+            LOG_FATAL_ERROR("Not a valid ILANSET0 or ILANSET1 file.");      //TODO: make this not fatal somehow
         }
     }
 
@@ -27,7 +101,10 @@ void AnimSet::load(const char * path) {
 	openFile->readL16(numBones);
 
     //read bone names
-	{
+    if(version >= 1) {
+        loadHashedNames(openFile, numBones, m_boneRegistry);
+    }
+    else {
 		Array<char> strBuffer;
 
 		for(unsigned int bone = 0; bone < numBones; bone++) {
@@ -35,11 +112,11 @@ void AnimSet::load(const char * path) {
 			strBuffer.reserve(stringBufferLength);
 			openFile->readString(&strBuffer[0], stringBufferLength);
 
-			if(m_boneNameMap.find(&strBuffer[0]) != m_boneNameMap.end()) {
+			if(m_boneRegistry.find(&strBuffer[0]) != BoneRegistry::NOT_FOUND) {
 				LOG_FATAL_ERROR("Animset has duplicate bone name %s.  This will cause problems when animating.", &strBuffer[0]);
 			}
 			else {
-				m_boneNameMap[&strBuffer[0]] = bone;
+				m_boneRegistry.insert(&strBuffer[0]);
 			}
 		}
 	}
@@ -49,103 +126,513 @@ void AnimSet::load(const char * path) {
     delete openFile;
 }
 
+const aiNode * AnimSet::SceneBoneData::findNode(const char * name) const {
+    auto iter = m_nameNodes.find(name);
+
+    return iter == m_nameNodes.end()
+        ? NULL
+        : iter->second;
+}
+
 void AnimSet::findBones(const aiScene * scene) {
-    SceneBoneData& sceneBoneData = m_sceneBoneData[scene];
+    SceneBoneData sceneBoneData;
+
+    gatherBones(scene, sceneBoneData);
+    mergeBones(scene, sceneBoneData);
+}
+
+void AnimSet::gatherBones(const aiScene * scene, SceneBoneData& sceneBoneData) {
+    //index all the nodes by name once instead of searching the tree for every bone
+    {
+        std::vector<const aiNode *> nodeStack(1, scene->mRootNode);
+
+        while(!nodeStack.empty()) {
+            const aiNode * currNode = nodeStack.back();
+            nodeStack.pop_back();
 
-    //it would be possible to abort recursing on bones already found,
-    //this may make other scenes not get all of the bones in
-    //look up all meshes and their bones
+            sceneBoneData.m_nameNodes.insert(std::make_pair(std::string(currNode->mName.data), currNode));
 
-    //LOG_DEBUG("Beginning to add bones from scene with %u meshes\n", scene->mNumMeshes);
+            for(unsigned int child = currNode->mNumChildren; child > 0; child--) {
+                nodeStack.push_back(currNode->mChildren[child - 1]);
+            }
+        }
+    }
+
+    //look up all meshes and their bones, then all their parent nodes, stopping at a node that was already found
+    std::map<const aiNode *, size_t> foundIndeces;
 
     for(unsigned int mesh = 0; mesh < scene->mNumMeshes; mesh++) {
         const aiMesh* currMesh = scene->mMeshes[mesh];
 
-        //LOG_DEBUG("Processing mesh %d with name %s with %d bones\n", mesh, currMesh->mName.data, currMesh->mNumBones);
-
         for(unsigned int bone = 0; bone < currMesh->mNumBones; bone++) {
-            const aiBone* currBone = currMesh->mBones[bone];
-               
-            //LOG_DEBUG("Processing bone %d with name %s", bone, currBone->mName.data);
+            const aiNode * currNode = sceneBoneData.findNode(currMesh->mBones[bone]->mName.data);
 
-            uint16_t currentBoneIndex;
+            if(!currNode) {
+                sceneBoneData.m_missingNodes.push_back(currMesh->mBones[bone]->mName.data);
+                continue;
+            }
 
-            //look up bone index
+            //the node may have been found as an ancestor of an earlier bone, it's still a mesh bone
             {
-                auto iter = m_boneNameMap.find(currBone->mName.data);
+                auto iter = foundIndeces.find(currNode);
 
-                if(iter == m_boneNameMap.end()) {
-                    if(!m_creating) {
-                        LOG_FATAL_ERROR("Imported animset doesn't have bone with name %s. Just generate a new animset and start everything from scratch.", currBone->mName.data);
-                    }
+                if(iter != foundIndeces.end()) {
+                    sceneBoneData.m_meshBones[iter->second] = true;
+                    continue;
+                }
+            }
 
-                    currentBoneIndex = m_boneNameMap.size();
-                    m_boneNameMap[currBone->mName.data] = currentBoneIndex;
+            bool meshBone = true;
 
-                    //LOG_DEBUG("New bone given index %u", currentBoneIndex);
-                }
-                else {
-                    currentBoneIndex = iter->second;
+            while(currNode && foundIndeces.insert(std::make_pair(currNode, sceneBoneData.m_foundNodes.size())).second) {
+                sceneBoneData.m_foundNodes.push_back(currNode);
+                sceneBoneData.m_meshBones.push_back(meshBone);
 
-                    //LOG_DEBUG("Bone is index %u", currentBoneIndex);
+                currNode = currNode->mParent;
+                meshBone = false;
+            }
+        }
+    }
+}
+
+void AnimSet::mergeBones(const aiScene * scene, SceneBoneData& gatheredData) {
+    if(!gatheredData.m_missingNodes.empty()) {
+        LOG_FATAL_ERROR("Mesh bone %s has no node in the scene", gatheredData.m_missingNodes.front().c_str());
+    }
+
+    SceneBoneData& sceneBoneData = m_sceneBoneData[scene];
+    sceneBoneData = std::move(gatheredData);
+
+    //new bones get their indices in the order they were found
+    for(size_t found = 0; found < sceneBoneData.m_foundNodes.size(); found++) {
+        const aiNode * currNode = sceneBoneData.m_foundNodes[found];
+        uint16_t boneIndex = m_boneRegistry.find(currNode->mName.data);
+
+        if(boneIndex == BoneRegistry::NOT_FOUND) {
+            if(!m_creating) {
+                if(sceneBoneData.m_meshBones[found]) {
+                    LOG_FATAL_ERROR("Imported animset doesn't have bone with name %s. Just generate a new animset and start everything from scratch.", currNode->mName.data);
                 }
+
+                //a loaded animset may have had this node pruned
+                continue;
             }
-            
-            //look up all parent nodes for the node with this name and add them too
-            aiNode * currNode = scene->mRootNode->FindNode(currBone->mName);
-            sceneBoneData.m_boneIndexNodes[currentBoneIndex] = currNode;
 
-            uint16_t prevBoneIndex = currentBoneIndex;
-            
-            //recursively look up parents of the node
-            while(currNode->mParent) {
-                currNode = currNode->mParent;
+            boneIndex = m_boneRegistry.insert(currNode->mName.data);
+        }
 
-                //look up bone index
-                {
-                    auto iter = m_boneNameMap.find(currNode->mName.data);
+        sceneBoneData.m_boneIndexNodes[boneIndex] = currNode;
+    }
 
-                    //LOG_DEBUG("Found bone with name %s", currNode->mName.data);
+    //the parent is the closest ancestor that's a bone, the first scene to link a bone decides its parent
+    for(auto iter = sceneBoneData.m_boneIndexNodes.cbegin(); iter != sceneBoneData.m_boneIndexNodes.end(); iter++) {
+        for(const aiNode * currNode = iter->second->mParent; currNode; currNode = currNode->mParent) {
+            uint16_t parentIndex = m_boneRegistry.find(currNode->mName.data);
 
-                    if(iter == m_boneNameMap.end()) {
-                        if(!m_creating) {
-                            LOG_FATAL_ERROR("Imported animset doesn't have bone with name %s. Just generate a new animset and start everything from scratch.", currNode->mName.data);
-                        }
+            if(parentIndex == BoneRegistry::NOT_FOUND) {
+                continue;
+            }
 
-                        currentBoneIndex = m_boneNameMap.size();
-                        m_boneNameMap[currNode->mName.data] = currentBoneIndex;
+            auto parentIter = m_boneParentIndeces.insert(std::make_pair(iter->first, parentIndex)).first;
 
-                        //LOG_DEBUG("New bone given index %u", currentBoneIndex);
-                    }
-                    else {
-                        currentBoneIndex = iter->second;
+            if(parentIter->second != parentIndex) {
+                LOG_INFO("Warning: bone %s has parent %s in one file and %s in another, keeping %s",
+                    iter->second->mName.data,
+                    m_boneRegistry.getName(parentIter->second).c_str(),
+                    currNode->mName.data,
+                    m_boneRegistry.getName(parentIter->second).c_str());
+            }
 
-                        //LOG_DEBUG("Bone is index %u", currentBoneIndex);
-                    }
+            break;
+        }
+    }
+}
+
+/**
+How many LODs keep each bone.  A bone is dropped from the first LOD whose max depth it's deeper than
+or the LOD it's listed for in the drop list, whichever comes first.  Children never stay in more LODs than their parent.
+@param depthOrder The bones with parents before their children.
+*/
+std::vector<uint8_t> computeBoneNumLods(const AnimSet& animset, size_t numLods, const std::vector<int>& depths, const std::vector<uint16_t>& depthOrder) {
+    std::vector<uint8_t> boneNumLods(depths.size(), (uint8_t) numLods);
+
+    for(size_t bone = 0; bone < depths.size(); bone++) {
+        for(size_t lod = 0; lod < animset.m_lodMaxDepths.size(); lod++) {
+            if(depths[bone] > (int) animset.m_lodMaxDepths[lod]) {
+                boneNumLods[bone] = (uint8_t) (lod + 1);
+                break;
+            }
+        }
+    }
+
+    for(auto iter = animset.m_lodDropBones.cbegin(); iter != animset.m_lodDropBones.end(); iter++) {
+        uint16_t bone = animset.m_boneRegistry.find(iter->first.c_str());
+
+        if(bone == BoneRegistry::NOT_FOUND) {
+            LOG_INFO("Warning: bone %s to drop from LOD %u isn't in any of the imported scenes", iter->first.c_str(), iter->second);
+        }
+        else {
+            boneNumLods[bone] = std::min(boneNumLods[bone], (uint8_t) iter->second);
+        }
+    }
+
+    for(auto iter = depthOrder.cbegin(); iter != depthOrder.end(); iter++) {
+        auto parentIter = animset.m_boneParentIndeces.find(*iter);
+
+        if(parentIter != animset.m_boneParentIndeces.end() && parentIter->second != *iter) {
+            boneNumLods[*iter] = std::min(boneNumLods[*iter], boneNumLods[parentIter->second]);
+        }
+    }
+
+    return boneNumLods;
+}
+
+void AnimSet::sortBones() {
+    if(!m_creating) {
+        if(!m_lodMaxDepths.empty() || !m_lodDropBones.empty()) {
+            LOG_INFO("Warning: bone LODs can only be made when creating a new animset, the loaded animset's bone order is already in use");
+        }
+
+        return;
+    }
+
+    uint16_t numBones = (uint16_t) m_boneRegistry.size();
+
+    //depth of each bone, walking up only as far as a bone whose depth is already known
+    std::vector<int> depths(numBones, -1);
+    std::vector<uint16_t> chain;
+
+    for(uint16_t bone = 0; bone < numBones; bone++) {
+        uint16_t currBone = bone;
+        chain.clear();
+
+        while(depths[currBone] < 0) {
+            chain.push_back(currBone);
+
+            auto parentIter = m_boneParentIndeces.find(currBone);
+
+            if(parentIter == m_boneParentIndeces.end() || parentIter->second == currBone) {
+                break;
+            }
+
+            currBone = parentIter->second;
+        }
+
+        int depth = depths[currBone] < 0 ? -1 : depths[currBone];
+
+        for(auto iter = chain.rbegin(); iter != chain.rend(); iter++) {
+            depths[*iter] = ++depth;
+        }
+    }
+
+    //stable so bones at the same depth keep the order they were found in
+    std::vector<uint16_t> order(numBones);
+
+    for(uint16_t bone = 0; bone < numBones; bone++) {
+        order[bone] = bone;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&depths] (uint16_t left, uint16_t right) {
+        return depths[left] < depths[right];
+    });
+
+    //the bones a LOD drops go after the ones it keeps, still by depth among themselves
+    size_t numLods = 1;
+    std::vector<uint8_t> boneNumLods;
+
+    if(!m_lodMaxDepths.empty() || !m_lodDropBones.empty()) {
+        numLods = m_lodMaxDepths.size() + 1;
+
+        for(auto iter = m_lodDropBones.cbegin(); iter != m_lodDropBones.end(); iter++) {
+            numLods = std::max(numLods, (size_t) iter->second + 1);
+        }
+
+        if(numLods > 0xFF) {
+            LOG_FATAL_ERROR("%u bone LODs, at most 255 are supported", (unsigned int) numLods);
+        }
+
+        boneNumLods = computeBoneNumLods(*this, numLods, depths, order);
+
+        std::stable_sort(order.begin(), order.end(), [&boneNumLods] (uint16_t left, uint16_t right) {
+            return boneNumLods[left] > boneNumLods[right];
+        });
+    }
+
+    std::vector<uint16_t> remap(numBones);
+
+    for(uint16_t bone = 0; bone < numBones; bone++) {
+        remap[order[bone]] = bone;
+    }
+
+    //apply the new indices everywhere
+    m_boneRegistry.remap(remap);
+
+    {
+        std::map<uint16_t, uint16_t> boneParentIndeces;
+
+        for(auto iter = m_boneParentIndeces.cbegin(); iter != m_boneParentIndeces.end(); iter++) {
+            boneParentIndeces[remap[iter->first]] = remap[iter->second];
+        }
+
+        m_boneParentIndeces.swap(boneParentIndeces);
+    }
+
+    for(auto sceneIter = m_sceneBoneData.begin(); sceneIter != m_sceneBoneData.end(); sceneIter++) {
+        std::map<uint16_t, const aiNode*> boneIndexNodes;
+
+        for(auto iter = sceneIter->second.m_boneIndexNodes.cbegin(); iter != sceneIter->second.m_boneIndexNodes.end(); iter++) {
+            boneIndexNodes[remap[iter->first]] = iter->second;
+        }
+
+        sceneIter->second.m_boneIndexNodes.swap(boneIndexNodes);
+    }
+
+    if(!boneNumLods.empty()) {
+        m_boneNumLods.resize(numBones);
+        m_lodNumBones.assign(numLods, 0);
+
+        for(uint16_t bone = 0; bone < numBones; bone++) {
+            m_boneNumLods[remap[bone]] = boneNumLods[bone];
+
+            for(uint8_t lod = 0; lod < boneNumLods[bone]; lod++) {
+                m_lodNumBones[lod]++;
+            }
+        }
+
+        for(size_t lod = 0; lod < numLods; lod++) {
+            LOG_INFO("Bone LOD %u has %u of %u bones", (unsigned int) lod, m_lodNumBones[lod], numBones);
+        }
+    }
+}
+
+void AnimSet::loadLodFile(const char * path) {
+    illFileSystem::File * openFile = illFileSystem::fileSystem->openRead(path);
+
+    std::string text(openFile->getSize(), '\0');
+
+    if(!text.empty()) {
+        openFile->read(&text[0], text.size());
+    }
+
+    delete openFile;
+
+    std::istringstream textStream(text);
+    std::string line;
+    unsigned int lineNumber = 0;
+
+    while(std::getline(textStream, line)) {
+        lineNumber++;
+
+        //skip empty lines and comments
+        size_t start = line.find_first_not_of(" \t\r");
+
+        if(start == std::string::npos || line[start] == '#') {
+            continue;
+        }
+
+        char * nameStart;
+        unsigned long lod = strtoul(line.c_str() + start, &nameStart, 10);
+
+        //the name is the rest of the line since bone names can have spaces
+        std::string name(nameStart);
+        size_t nameBegin = name.find_first_not_of(" \t");
+        size_t nameEnd = name.find_last_not_of(" \t\r");
+
+        if(lod == 0 || nameStart == line.c_str() + start || nameBegin == std::string::npos) {
+            LOG_FATAL_ERROR("Line %u of bone LOD file %s should be a LOD number above 0 followed by a bone name", lineNumber, path);
+        }
+
+        name = name.substr(nameBegin, nameEnd - nameBegin + 1);
+
+        //a bone listed more than once is dropped at the first LOD it's listed for
+        auto insertIter = m_lodDropBones.insert(std::make_pair(name, (unsigned int) lod)).first;
+        insertIter->second = std::min(insertIter->second, (unsigned int) lod);
+    }
+}
+
+std::vector<uint16_t> AnimSet::computeLodBoneRemap(unsigned int lod) const {
+    uint16_t numBones = (uint16_t) m_boneRegistry.size();
+    std::vector<uint16_t> remap(numBones);
+
+    //parents come before their children so a dropped bone's parent is already remapped
+    for(uint16_t bone = 0; bone < numBones; bone++) {
+        auto parentIter = m_boneParentIndeces.find(bone);
+
+        if(m_boneNumLods.empty() || m_boneNumLods[bone] > lod
+                || parentIter == m_boneParentIndeces.end() || parentIter->second == bone) {
+            remap[bone] = bone;
+        }
+        else {
+            remap[bone] = remap[parentIter->second];
+        }
+    }
+
+    return remap;
+}
+
+//how far a bind pose channel key can be from the bind pose
+const float BIND_POSITION_EPSILON = 1e-4f;
+const float BIND_ROTATION_EPSILON = 1e-6f;     //1 - dot of the quaternions
+const float BIND_SCALE_EPSILON = 1e-4f;
+
+bool AnimSet::isBindPoseChannel(const aiNodeAnim * channel, const aiNode * node) {
+    aiVector3D bindScale;
+    aiQuaternion bindRotation;
+    aiVector3D bindPosition;
+
+    node->mTransformation.Decompose(bindScale, bindRotation, bindPosition);
+
+    for(unsigned int key = 0; key < channel->mNumPositionKeys; key++) {
+        const aiVector3D& value = channel->mPositionKeys[key].mValue;
+
+        if(fabs(value.x - bindPosition.x) > BIND_POSITION_EPSILON
+                || fabs(value.y - bindPosition.y) > BIND_POSITION_EPSILON
+                || fabs(value.z - bindPosition.z) > BIND_POSITION_EPSILON) {
+            return false;
+        }
+    }
+
+    for(unsigned int key = 0; key < channel->mNumRotationKeys; key++) {
+        const aiQuaternion& value = channel->mRotationKeys[key].mValue;
+
+        //q and -q are the same rotation
+        float dot = value.x * bindRotation.x + value.y * bindRotation.y + value.z * bindRotation.z + value.w * bindRotation.w;
+
+        if(1.0f - fabs(dot) > BIND_ROTATION_EPSILON) {
+            return false;
+        }
+    }
+
+    for(unsigned int key = 0; key < channel->mNumScalingKeys; key++) {
+        const aiVector3D& value = channel->mScalingKeys[key].mValue;
+
+        if(fabs(value.x - bindScale.x) > BIND_SCALE_EPSILON
+                || fabs(value.y - bindScale.y) > BIND_SCALE_EPSILON
+                || fabs(value.z - bindScale.z) > BIND_SCALE_EPSILON) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void AnimSet::pruneBones() {
+    if(!m_creating) {
+        LOG_INFO("Warning: bones can only be pruned when creating a new animset, not pruning");
+        return;
+    }
+
+    uint16_t numBones = (uint16_t) m_boneRegistry.size();
+    std::vector<bool> used(numBones, false);
+
+    for(auto sceneIter = m_sceneBoneData.cbegin(); sceneIter != m_sceneBoneData.end(); sceneIter++) {
+        const aiScene * scene = sceneIter->first;
+
+        //bones meshes are weighted to
+        for(unsigned int mesh = 0; mesh < scene->mNumMeshes; mesh++) {
+            for(unsigned int bone = 0; bone < scene->mMeshes[mesh]->mNumBones; bone++) {
+                used[m_boneRegistry.at(scene->mMeshes[mesh]->mBones[bone]->mName.data)] = true;
+            }
+        }
+
+        //bones that get animated away from their bind pose
+        for(unsigned int animation = 0; animation < scene->mNumAnimations; animation++) {
+            const aiAnimation * currAnimation = scene->mAnimations[animation];
+
+            for(unsigned int channel = 0; channel < currAnimation->mNumChannels; channel++) {
+                const aiNodeAnim * currChannel = currAnimation->mChannels[channel];
+                uint16_t boneIndex = m_boneRegistry.find(currChannel->mNodeName.data);
+
+                if(boneIndex == BoneRegistry::NOT_FOUND || used[boneIndex]) {
+                    continue;
                 }
 
-                //LOG_DEBUG("Assigned bone %u as child of bone %u", prevBoneIndex, currentBoneIndex);
+                const aiNode * node = sceneIter->second.findNode(currChannel->mNodeName.data);
 
-                m_boneParentIndeces[prevBoneIndex] = currentBoneIndex;      //mark the parent
-                sceneBoneData.m_boneIndexNodes[currentBoneIndex] = currNode;
+                if(!node || !isBindPoseChannel(currChannel, node)) {
+                    used[boneIndex] = true;
+                }
+            }
+        }
+    }
+
+    for(auto iter = m_keepBones.cbegin(); iter != m_keepBones.end(); iter++) {
+        uint16_t boneIndex = m_boneRegistry.find(iter->c_str());
+
+        if(boneIndex == BoneRegistry::NOT_FOUND) {
+            LOG_INFO("Warning: bone %s to keep isn't in any of the imported scenes", iter->c_str());
+        }
+        else {
+            used[boneIndex] = true;
+        }
+    }
+
+    //pack the kept bones down in the same order
+    std::vector<uint16_t> remap(numBones, BoneRegistry::NOT_FOUND);
+    uint16_t numKept = 0;
+
+    for(uint16_t bone = 0; bone < numBones; bone++) {
+        if(used[bone]) {
+            remap[bone] = numKept++;
+        }
+    }
+
+    if(numKept == numBones) {
+        LOG_INFO("No bones to prune");
+        return;
+    }
+
+    m_boneRegistry.remap(remap);
 
-                prevBoneIndex = currentBoneIndex;
+    //kept bones get the closest kept ancestor as their parent
+    {
+        std::map<uint16_t, uint16_t> boneParentIndeces;
+
+        for(uint16_t bone = 0; bone < numBones; bone++) {
+            if(!used[bone]) {
+                continue;
             }
 
-            //LOG_DEBUG("Reached root node of heirarchy.\n");
+            uint16_t currBone = bone;
+
+            for(auto parentIter = m_boneParentIndeces.find(currBone);
+                    parentIter != m_boneParentIndeces.end() && parentIter->second != currBone;
+                    parentIter = m_boneParentIndeces.find(currBone)) {
+                currBone = parentIter->second;
+
+                if(used[currBone]) {
+                    boneParentIndeces[remap[bone]] = remap[currBone];
+                    break;
+                }
+            }
         }
 
-        //LOG_DEBUG("Done adding mesh nodes.\n");
+        m_boneParentIndeces.swap(boneParentIndeces);
     }
 
-    //LOG_DEBUG("Done adding scene bones.\n");
+    for(auto sceneIter = m_sceneBoneData.begin(); sceneIter != m_sceneBoneData.end(); sceneIter++) {
+        std::map<uint16_t, const aiNode*> boneIndexNodes;
 
-    //debug consistency check to make sure the structures are correct
-    /*for(unsigned int bone = 0; bone < m_boneNodes.size(); bone++) {
-        if(m_boneIndeces.at(m_boneNodes.at(bone)->mName.data) != bone) {
-            throw std::runtime_error("Bone consistency check problem.  The programmer isn't 1337 enough!");
+        for(auto iter = sceneIter->second.m_boneIndexNodes.cbegin(); iter != sceneIter->second.m_boneIndexNodes.end(); iter++) {
+            if(used[iter->first]) {
+                boneIndexNodes[remap[iter->first]] = iter->second;
+            }
         }
-    }*/
+
+        sceneIter->second.m_boneIndexNodes.swap(boneIndexNodes);
+    }
+
+    LOG_INFO("Pruned %u of %u bones that had no mesh weights and no animation", numBones - numKept, numBones);
+}
+
+aiMatrix4x4 AnimSet::computeCollapsedTransform(const aiNode * node) const {
+    aiMatrix4x4 transform;      //starts as identity
+
+    for(const aiNode * currNode = node->mParent; currNode && m_boneRegistry.find(currNode->mName.data) == BoneRegistry::NOT_FOUND; currNode = currNode->mParent) {
+        transform = currNode->mTransformation * transform;
+    }
+
+    return transform;
 }
 
 /*void AnimSet::computeHeirarchies() {
@@ -205,23 +692,55 @@ void AnimSet::findBones(const aiScene * scene) {
 void AnimSet::save(const char * path) const {
     illFileSystem::File * openFile = illFileSystem::fileSystem->openWrite(path);
 
+    uint16_t numBones = (uint16_t) m_boneRegistry.size();
+
     //write magic number
-    openFile->writeB64(ANIMSET_MAGIC);
+    openFile->writeB64(m_version >= 1 ? ANIMSET_MAGIC_1 : ANIMSET_MAGIC);
 
     //number of bones
-    openFile->writeL16(m_boneNameMap.size());
-
-    //reverse the name to index map
-    Array<const char *> reverseMap;
-    reverseMap.resize(m_boneNameMap.size());
+    openFile->writeL16(numBones);
 
-    for(auto iter = m_boneNameMap.cbegin(); iter != m_boneNameMap.end(); iter++) {
-        reverseMap[iter->second] = iter->first.c_str();
+    if(m_version == 0) {
+        //the bone names in order of index
+        for(uint16_t bone = 0; bone < numBones; bone++) {
+            openFile->writeString(m_boneRegistry.getName(bone).c_str());
+        }
     }
+    else {
+        //perfect hash table of the bone names
+        std::vector<uint32_t> seeds;
+        std::vector<uint16_t> slots;
+        m_boneRegistry.buildPerfectHash(seeds, slots);
+
+        openFile->writeL16((uint16_t) seeds.size());
+
+        for(auto iter = seeds.cbegin(); iter != seeds.end(); iter++) {
+            openFile->writeL32(*iter);
+        }
+
+        for(auto iter = slots.cbegin(); iter != slots.end(); iter++) {
+            openFile->writeL16(*iter);
+        }
 
-    //now print the bone names in order of index
-    for(uint16_t bone = 0; bone < reverseMap.size(); bone++) {
-        openFile->writeString(reverseMap[bone]);
+        //padding so the name offsets are 4 byte aligned
+        if(numBones % 2) {
+            openFile->writeL16(0);
+        }
+
+        //where each null terminated name starts in the names that follow, one extra at the end for the total size
+        uint32_t nameOffset = 0;
+
+        for(uint16_t bone = 0; bone < numBones; bone++) {
+            openFile->writeL32(nameOffset);
+            nameOffset += (uint32_t) m_boneRegistry.getName(bone).size() + 1;
+        }
+
+        openFile->writeL32(nameOffset);
+
+        for(uint16_t bone = 0; bone < numBones; bone++) {
+            const std::string& name = m_boneRegistry.getName(bone);
+            openFile->write(name.c_str(), name.size() + 1);
+        }
     }
 
     delete openFile;
@@ -5,31 +5,114 @@
 #include <stdint.h>
 #include <string>
 #include <map>
+#include <set>
+#include <unordered_map>
+#include <vector>
 
 #include <assimp/scene.h>
 
+#include "BoneRegistry.h"
+
 class AnimSet {
 public:
     AnimSet()
-        : m_creating(true)
+        : m_creating(true),
+        m_version(0),
+        m_pruneBones(false)
     {}
 
     struct SceneBoneData {
-        std::map<uint16_t, const aiNode*> m_boneIndexNodes;                 //bone index to node map
+        //node with the name, NULL if it's not in the scene
+        const aiNode * findNode(const char * name) const;
+
+        std::map<uint16_t, const aiNode*> m_boneIndexNodes;                 //bone index to node map, filled in by mergeBones
+
+        std::unordered_map<std::string, const aiNode*> m_nameNodes;         //every node in the scene by name
+        std::vector<const aiNode*> m_foundNodes;    //bone nodes in the order they were found, each mesh bone followed by its ancestors that weren't found yet
+        std::vector<bool> m_meshBones;              //whether each of m_foundNodes is a bone of a mesh
+        std::vector<std::string> m_missingNodes;    //mesh bones that have no node in the scene
     };
 
     std::map<uint16_t, uint16_t> m_boneParentIndeces;                 //bone index to parent index map
 
     void load(const char * path);
 
+    //gathers and merges the bones of a scene, same as calling gatherBones and mergeBones
     void findBones(const aiScene * scene);
     //void computeHeirarchies();
 
+    /**
+    Finds the bone nodes of a scene in one pass, each node is only visited once.
+    Doesn't touch the animset so scenes can be gathered on separate threads.
+    */
+    static void gatherBones(const aiScene * scene, SceneBoneData& sceneBoneData);
+
+    /**
+    Adds the bones gathered from a scene to the animset and links up their parents.
+    Merging scenes in the same order always gives the same bone indices no matter how the gathering was done.
+    The data gets moved into m_sceneBoneData.
+    */
+    void mergeBones(const aiScene * scene, SceneBoneData& sceneBoneData);
+
+    /**
+    Renumbers the bones so every bone comes after its parent, ordered by depth in the heirarchy.
+    With bone LODs the bones each LOD drops go after the ones it keeps, so every LOD is the first m_lodNumBones[lod] bones.
+    Only does anything while creating the animset, a loaded animset already has its bone indices in use.
+    Call this after all findBones calls and before anything else uses the bone indices.
+    */
+    void sortBones();
+
+    //reads bone LOD drops from a text file, each line is a LOD number followed by the name of a bone dropped from that LOD on
+    void loadLodFile(const char * path);
+
+    //1 if there are no bone LODs
+    inline unsigned int getNumLods() const {
+        return m_lodNumBones.empty() ? 1 : (unsigned int) m_lodNumBones.size();
+    }
+
+    //for each bone the bone that takes over its weights in a LOD, which is itself or its closest ancestor the LOD keeps
+    std::vector<uint16_t> computeLodBoneRemap(unsigned int lod) const;
+
+    /**
+    Removes bones that no mesh is weighted to and no animation moves away from the bind pose, unless they're in m_keepBones.
+    Their bind transforms get collapsed into their children, see computeCollapsedTransform.
+    Only does anything while creating the animset.  Call this after all findBones calls and before sortBones.
+    */
+    void pruneBones();
+
+    /**
+    The combined bind transforms of the nodes between a node and the closest ancestor that's a bone, which are the pruned nodes.
+    The node's own transform isn't included.  Identity if the parent is a bone or there's no parent.
+    */
+    aiMatrix4x4 computeCollapsedTransform(const aiNode * node) const;
+
+    //true if every key of the channel is at the node's bind pose
+    static bool isBindPoseChannel(const aiNodeAnim * channel, const aiNode * node);
+
+    /**
+    Saves the bone names.
+    Version 1 adds a minimal perfect hash table of the names so bones can be looked up by name straight from the file, see BoneRegistry::buildPerfectHash.
+    */
     void save(const char * path) const;
     
     bool m_creating;
+    unsigned int m_version;     //animset file version to save as
+
+    bool m_pruneBones;
+    std::set<std::string> m_keepBones;      //bones that are never pruned, like attachment points
+
+    /**
+    Bone LODs, LOD 0 has all the bones and every LOD after that drops more, along with everything under the dropped bones.
+    LOD n + 1 drops the bones deeper than m_lodMaxDepths[n], the roots are at depth 0.
+    m_lodDropBones has bones dropped by name, mapped to the first LOD that drops them.
+    */
+    std::vector<unsigned int> m_lodMaxDepths;
+    std::map<std::string, unsigned int> m_lodDropBones;
+
+    std::vector<uint8_t> m_boneNumLods;         //how many LODs keep each bone, filled in by sortBones
+    std::vector<uint16_t> m_lodNumBones;        //how many bones each LOD keeps, empty if there are no bone LODs
 
-    std::map<std::string, uint16_t> m_boneNameMap;       //bone name to bone index map
+    BoneRegistry m_boneRegistry;        //bone names and indices
     
     std::map<const aiScene *, SceneBoneData> m_sceneBoneData;
 };
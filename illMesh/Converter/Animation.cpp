@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
 #include "Animation.h"
 #include "Skeleton.h"
 #include "AnimSet.h"
@@ -7,136 +11,1456 @@
 
 #include "illEngine/Logging/logging.h"
 
+#include "../Runtime/AnimationCodec.h"
+#include "../Runtime/ResampledAnimation.h"
+
 const uint64_t ANIM_MAGIC = 0x494C4C414E494D30;		//ILLANIM0 in 64 bit big endian
+const uint64_t ANIM_MAGIC_1 = 0x494C4C414E494D31;		//ILLANIM1 in 64 bit big endian
+const uint64_t ANIM_MAGIC_2 = 0x494C4C414E494D32;		//ILLANIM2 in 64 bit big endian
+const uint64_t ANIM_MAGIC_3 = 0x494C4C414E494D33;		//ILLANIM3 in 64 bit big endian
+
+//version 1, 2, and 3 header flags
+const uint8_t ANIM_FLAG_BIND_RELATIVE = 1 << 0;
+
+//version 1 key times are frame indices at this rate and version 2 is sampled at it if the source doesn't have one
+const float DEFAULT_FRAME_RATE = 30.0f;
+
+//version 3 segment length in seconds if none is given
+const float DEFAULT_SEGMENT_LENGTH = 1.0f;
+
+/**
+Sorts the keys that were just added at the end of a channel by time, keeping only the last key for any repeated time.
+The keys from assimp are almost always sorted already so that's checked first.
+@return The number of keys left.
+*/
+template <typename Value>
+uint32_t sortNewKeys(std::vector<float>& times, std::vector<Value>& values, size_t beginKey) {
+    bool sorted = true;
+
+    for(size_t key = beginKey + 1; key < times.size() && sorted; key++) {
+        sorted = times[key - 1] < times[key];
+    }
+
+    if(!sorted) {
+        std::vector<size_t> order(times.size() - beginKey);
+        std::iota(order.begin(), order.end(), beginKey);
+
+        std::stable_sort(order.begin(), order.end(), [&times] (size_t left, size_t right) {
+            return times[left] < times[right];
+        });
+
+        std::vector<float> sortedTimes;
+        std::vector<Value> sortedValues;
+
+        for(auto iter = order.cbegin(); iter != order.end(); iter++) {
+            if(!sortedTimes.empty() && sortedTimes.back() == times[*iter]) {
+                sortedValues.back() = values[*iter];
+            }
+            else {
+                sortedTimes.push_back(times[*iter]);
+                sortedValues.push_back(values[*iter]);
+            }
+        }
+
+        times.resize(beginKey);
+        values.resize(beginKey);
 
-void Animation::import(const aiAnimation* animation, const Skeleton * skeleton, const AnimSet * animset) {
+        times.insert(times.end(), sortedTimes.begin(), sortedTimes.end());
+        values.insert(values.end(), sortedValues.begin(), sortedValues.end());
+    }
+
+    return (uint32_t) (times.size() - beginKey);
+}
+
+void Animation::import(const aiAnimation* animation, const aiScene * scene, const AnimSet * animset) {
     m_animation = animation;
 
     //compute duration
     m_duration = (float) (m_animation->mDuration / m_animation->mTicksPerSecond);
 
     //compute bone transforms for each key frame relative to the bind pose
-    for(uint16_t bone = 0; bone < (uint16_t) m_animation->mNumChannels; bone++) {
-        aiNodeAnim* currAnim = m_animation->mChannels[bone];
-        
-        uint16_t boneIndex;
+    const AnimSet::SceneBoneData& sceneBoneData = animset->m_sceneBoneData.at(scene);
 
-        {
-            auto iter = animset->m_boneNameMap.find(currAnim->mNodeName.data);
+    //find the bone of each channel and put them in bone order
+    std::vector<std::pair<uint16_t, unsigned int> > boneChannels;
+    size_t numKeys[NUM_CHANNELS] = {0, 0, 0};
+
+    for(unsigned int channel = 0; channel < m_animation->mNumChannels; channel++) {
+        aiNodeAnim* currAnim = m_animation->mChannels[channel];
+
+        uint16_t boneIndex = animset->m_boneRegistry.find(currAnim->mNodeName.data);
+
+        if(boneIndex == BoneRegistry::NOT_FOUND) {
+            //pruned bones only ever had bind pose channels, nothing to export
+            const aiNode * node = sceneBoneData.findNode(currAnim->mNodeName.data);
 
-            if(iter == animset->m_boneNameMap.end()) {
-                LOG_FATAL_ERROR("Exporting animations failed.  Found a bone with name %s which isn't in the animset.  This is really weird.", currAnim->mNodeName.data);
+            if(node && AnimSet::isBindPoseChannel(currAnim, node)) {
+                continue;
             }
 
-            boneIndex = iter->second;
+            LOG_FATAL_ERROR("Exporting animations failed.  Found a bone with name %s which isn't in the animset.  This is really weird.", currAnim->mNodeName.data);
         }
 
-        assert(m_boneAnimation.find(boneIndex) == m_boneAnimation.end());
+        boneChannels.push_back(std::make_pair(boneIndex, channel));
 
-        AnimData& animData = m_boneAnimation[boneIndex];
-        
-        //decompose the bind pose
-        glm::vec3 bindPosInverse = -getTransformPosition(skeleton->m_bones[boneIndex].m_relativeTransform);
-        glm::quat bindRotInverse;
-        glm::vec3 bindScaleInverse;
+        numKeys[CHANNEL_POSITION] += currAnim->mNumPositionKeys;
+        numKeys[CHANNEL_ROTATION] += currAnim->mNumRotationKeys;
+        numKeys[CHANNEL_SCALE] += currAnim->mNumScalingKeys;
+    }
 
-        getTransformRotationScale(skeleton->m_bones[boneIndex].m_relativeTransform, bindRotInverse, bindScaleInverse);
-        bindRotInverse = glm::inverse(bindRotInverse);
-        bindScaleInverse = 1.0f / bindScaleInverse;
+    std::sort(boneChannels.begin(), boneChannels.end());
+
+    //allocate everything up front so filling in the keys doesn't reallocate
+    m_tracks.clear();
+    m_tracks.reserve(boneChannels.size());
+
+    for(unsigned int channel = 0; channel < NUM_CHANNELS; channel++) {
+        m_times[channel].clear();
+        m_times[channel].reserve(numKeys[channel]);
+    }
+
+    m_positions.clear();
+    m_positions.reserve(numKeys[CHANNEL_POSITION]);
+    m_rotations.clear();
+    m_rotations.reserve(numKeys[CHANNEL_ROTATION]);
+    m_scales.clear();
+    m_scales.reserve(numKeys[CHANNEL_SCALE]);
+
+    for(auto channelIter = boneChannels.cbegin(); channelIter != boneChannels.end(); channelIter++) {
+        uint16_t boneIndex = channelIter->first;
+        aiNodeAnim* currAnim = m_animation->mChannels[channelIter->second];
+
+        assert(m_tracks.empty() || m_tracks.back().m_bone != boneIndex);
+
+        Track track;
+        track.m_bone = boneIndex;
+
+        //the keys are relative to the node's parent, if nodes between this bone and its parent bone were pruned they get folded in like the skeleton bind pose
+        bool collapsed = false;
+        glm::vec3 collapsedPos;
+        glm::quat collapsedRot;
+        glm::vec3 collapsedScale;
+
+        {
+            const aiNode * node = sceneBoneData.findNode(currAnim->mNodeName.data);
+
+            if(node) {
+                aiMatrix4x4 collapsedTransform = animset->computeCollapsedTransform(node);
+
+                if(!collapsedTransform.IsIdentity()) {
+                    aiVector3D scale;
+                    aiQuaternion rotation;
+                    aiVector3D position;
+
+                    //pruned helper nodes are pivots and offsets, their scale is assumed to be uniform
+                    collapsedTransform.Decompose(scale, rotation, position);
+
+                    collapsed = true;
+                    collapsedPos = glm::vec3(position.x, position.y, position.z);
+                    collapsedRot = glm::quat(rotation.w, rotation.x, rotation.y, rotation.z);
+                    collapsedScale = glm::vec3(scale.x, scale.y, scale.z);
+                }
+            }
+        }
+
+        //for each position key
+        track.m_beginKey[CHANNEL_POSITION] = (uint32_t) m_positions.size();
 
-        //for each position key, get the position relative to the bind pose instead
         for(unsigned int key = 0; key < currAnim->mNumPositionKeys; key++) {
             float time = (float) (currAnim->mPositionKeys[key].mTime / m_animation->mTicksPerSecond);
-            
-            //get the relative position offset
-            animData.m_positionKeys[time] = glm::vec3(currAnim->mPositionKeys[key].mValue.x,
+
+            glm::vec3 position = glm::vec3(currAnim->mPositionKeys[key].mValue.x,
                 currAnim->mPositionKeys[key].mValue.y,
-                currAnim->mPositionKeys[key].mValue.z) /*+ bindPosInverse*/;
+                currAnim->mPositionKeys[key].mValue.z);
+
+            if(collapsed) {
+                position = collapsedPos + collapsedRot * (collapsedScale * position);
+            }
+
+            m_times[CHANNEL_POSITION].push_back(time);
+            m_positions.push_back(position);
         }
 
-        //for each rotation key, get the rotation relative to the bind pose instead
+        track.m_numKeys[CHANNEL_POSITION] = sortNewKeys(m_times[CHANNEL_POSITION], m_positions, track.m_beginKey[CHANNEL_POSITION]);
+
+        //for each rotation key
+        track.m_beginKey[CHANNEL_ROTATION] = (uint32_t) m_rotations.size();
+
         for(unsigned int key = 0; key < currAnim->mNumRotationKeys; key++) {
             float time = (float) (currAnim->mRotationKeys[key].mTime / m_animation->mTicksPerSecond);
 
-            animData.m_rotationKeys[time] = /*bindRotInverse **/ glm::quat(currAnim->mRotationKeys[key].mValue.w, 
+            glm::quat rotation = glm::quat(currAnim->mRotationKeys[key].mValue.w,
                 currAnim->mRotationKeys[key].mValue.x,
                 currAnim->mRotationKeys[key].mValue.y,
                 currAnim->mRotationKeys[key].mValue.z);
+
+            if(collapsed) {
+                rotation = collapsedRot * rotation;
+            }
+
+            m_times[CHANNEL_ROTATION].push_back(time);
+            m_rotations.push_back(rotation);
         }
 
-        //for each scale key, get the scale relative to the bind pose instead
+        track.m_numKeys[CHANNEL_ROTATION] = sortNewKeys(m_times[CHANNEL_ROTATION], m_rotations, track.m_beginKey[CHANNEL_ROTATION]);
+
+        //for each scale key
+        track.m_beginKey[CHANNEL_SCALE] = (uint32_t) m_scales.size();
+
         for(unsigned int key = 0; key < currAnim->mNumScalingKeys; key++) {
             float time = (float) (currAnim->mScalingKeys[key].mTime / m_animation->mTicksPerSecond);
 
-            //get the relative position offset
-            animData.m_scalingKeys[time] = glm::vec3(currAnim->mScalingKeys[key].mValue.x,
+            glm::vec3 scale = glm::vec3(currAnim->mScalingKeys[key].mValue.x,
                 currAnim->mScalingKeys[key].mValue.y,
-                currAnim->mScalingKeys[key].mValue.z)
-                /** bindScaleInverse*/;
+                currAnim->mScalingKeys[key].mValue.z);
+
+            if(collapsed) {
+                scale = collapsedScale * scale;
+            }
+
+            m_times[CHANNEL_SCALE].push_back(time);
+            m_scales.push_back(scale);
         }
+
+        track.m_numKeys[CHANNEL_SCALE] = sortNewKeys(m_times[CHANNEL_SCALE], m_scales, track.m_beginKey[CHANNEL_SCALE]);
+
+        m_tracks.push_back(track);
     }
 }
 
-void Animation::save(const char * path) {
-    illFileSystem::File * openFile = illFileSystem::fileSystem->openWrite(path);
+/**
+Copies the keys of one channel of the kept tracks into new arrays so dropped keys don't take up space.
+*/
+template <typename Value>
+void compactChannel(std::vector<Animation::Track>& tracks, Animation::Channel channel, std::vector<float>& times, std::vector<Value>& values) {
+    std::vector<float> keptTimes;
+    std::vector<Value> keptValues;
 
-    //write magic number
-    openFile->writeB64(ANIM_MAGIC);
+    for(auto iter = tracks.begin(); iter != tracks.end(); iter++) {
+        uint32_t beginKey = iter->m_beginKey[channel];
+        iter->m_beginKey[channel] = (uint32_t) keptTimes.size();
 
-    //write duration in seconds
-    openFile->writeLF(m_duration);
+        keptTimes.insert(keptTimes.end(), times.begin() + beginKey, times.begin() + beginKey + iter->m_numKeys[channel]);
+        keptValues.insert(keptValues.end(), values.begin() + beginKey, values.begin() + beginKey + iter->m_numKeys[channel]);
+    }
 
-    //write number of bones
-    openFile->writeL16((uint16_t) m_boneAnimation.size());
+    times.swap(keptTimes);
+    values.swap(keptValues);
+}
 
-    //the bones
-    for(auto boneIter = m_boneAnimation.cbegin(); boneIter != m_boneAnimation.end(); boneIter++) {
-        //bone index
-        openFile->writeL16(boneIter->first);
+void Animation::makeBindRelative(const Skeleton& skeleton, float positionTolerance, float rotationTolerance, float scaleTolerance, const char * name) {
+    if(m_bindRelative) {
+        return;
+    }
 
-        //number of position keys
-        openFile->writeL16((uint16_t) boneIter->second.m_positionKeys.size());
+    //compare the sine of half the angle so small rotations don't get lost in acos
+    float rotationSinTolerance = (float) sin(rotationTolerance * 3.14159265f / 180.0f * 0.5f);
 
-        //position keys
-        for(auto keyIter = boneIter->second.m_positionKeys.cbegin(); keyIter != boneIter->second.m_positionKeys.end(); keyIter++) {
-            //write time stamp
-            openFile->writeLF(keyIter->first);
+    size_t numTracks = m_tracks.size();
+    unsigned int numChannels = 0;
+    unsigned int numDroppedChannels = 0;
 
-            //write the position
-            openFile->writeLF(keyIter->second.x);
-            openFile->writeLF(keyIter->second.y);
-            openFile->writeLF(keyIter->second.z);
+    for(auto iter = m_tracks.begin(); iter != m_tracks.end(); iter++) {
+        //decompose the bind pose
+        glm::vec3 bindPosInverse = -getTransformPosition(skeleton.m_bones[iter->m_bone].m_relativeTransform);
+        glm::quat bindRotInverse;
+        glm::vec3 bindScaleInverse;
+
+        getTransformRotationScale(skeleton.m_bones[iter->m_bone].m_relativeTransform, bindRotInverse, bindScaleInverse);
+        bindRotInverse = glm::inverse(bindRotInverse);
+        bindScaleInverse = 1.0f / bindScaleInverse;
+
+        bool identity[NUM_CHANNELS] = {true, true, true};
+
+        for(uint32_t key = iter->m_beginKey[CHANNEL_POSITION]; key < iter->m_beginKey[CHANNEL_POSITION] + iter->m_numKeys[CHANNEL_POSITION]; key++) {
+            m_positions[key] += bindPosInverse;
+            identity[CHANNEL_POSITION] = identity[CHANNEL_POSITION] && glm::length(m_positions[key]) <= positionTolerance;
         }
 
-        //number of rotation keys
-        openFile->writeL16((uint16_t) boneIter->second.m_rotationKeys.size());
+        for(uint32_t key = iter->m_beginKey[CHANNEL_ROTATION]; key < iter->m_beginKey[CHANNEL_ROTATION] + iter->m_numKeys[CHANNEL_ROTATION]; key++) {
+            glm::quat& rotation = m_rotations[key];
+            rotation = bindRotInverse * rotation;
 
-        //rotation keys
-        for(auto keyIter = boneIter->second.m_rotationKeys.cbegin(); keyIter != boneIter->second.m_rotationKeys.end(); keyIter++) {
-            //write time stamp
-            openFile->writeLF(keyIter->first);
+            identity[CHANNEL_ROTATION] = identity[CHANNEL_ROTATION]
+                && sqrt(rotation.x * rotation.x + rotation.y * rotation.y + rotation.z * rotation.z) <= rotationSinTolerance;
+        }
 
-            //write the position
-            openFile->writeLF(keyIter->second.x);
-            openFile->writeLF(keyIter->second.y);
-            openFile->writeLF(keyIter->second.z);
-            openFile->writeLF(keyIter->second.w);
+        for(uint32_t key = iter->m_beginKey[CHANNEL_SCALE]; key < iter->m_beginKey[CHANNEL_SCALE] + iter->m_numKeys[CHANNEL_SCALE]; key++) {
+            m_scales[key] = m_scales[key] * bindScaleInverse;
+            identity[CHANNEL_SCALE] = identity[CHANNEL_SCALE] && glm::length(m_scales[key] - glm::vec3(1.0f)) <= scaleTolerance;
         }
 
-        //number of scaling keys
-        openFile->writeL16((uint16_t) boneIter->second.m_scalingKeys.size());
+        //the runtime uses the bind values for channels with no keys
+        for(unsigned int channel = 0; channel < NUM_CHANNELS; channel++) {
+            if(iter->m_numKeys[channel] == 0) {
+                continue;
+            }
 
-        //scaling keys
-        for(auto keyIter = boneIter->second.m_scalingKeys.cbegin(); keyIter != boneIter->second.m_scalingKeys.end(); keyIter++) {
-            //write time stamp
-            openFile->writeLF(keyIter->first);
+            numChannels++;
 
-            //write the position
-            openFile->writeLF(keyIter->second.x);
-            openFile->writeLF(keyIter->second.y);
-            openFile->writeLF(keyIter->second.z);
+            if(identity[channel]) {
+                iter->m_numKeys[channel] = 0;
+                numDroppedChannels++;
+            }
         }
     }
 
-    delete openFile;
+    m_tracks.erase(std::remove_if(m_tracks.begin(), m_tracks.end(), [] (const Track& track) {
+        return track.m_numKeys[CHANNEL_POSITION] == 0 && track.m_numKeys[CHANNEL_ROTATION] == 0 && track.m_numKeys[CHANNEL_SCALE] == 0;
+    }), m_tracks.end());
+
+    compactChannel(m_tracks, CHANNEL_POSITION, m_times[CHANNEL_POSITION], m_positions);
+    compactChannel(m_tracks, CHANNEL_ROTATION, m_times[CHANNEL_ROTATION], m_rotations);
+    compactChannel(m_tracks, CHANNEL_SCALE, m_times[CHANNEL_SCALE], m_scales);
+
+    m_bindRelative = true;
+
+    LOG_INFO("Animation %s made relative to the bind pose, dropped %u of %u channels and %u of %u tracks that stay at the bind pose",
+        name, numDroppedChannels, numChannels, (unsigned int) (numTracks - m_tracks.size()), (unsigned int) numTracks);
+}
+
+/**
+The value of a channel at a time, interpolating between the keys around it and holding the first and last keys outside of them.
+@param defaultValue What a channel with no keys has.
+*/
+template <typename Value, typename Interpolate>
+Value sampleKeys(const float * times, const Value * values, uint32_t numKeys, float time, const Value& defaultValue, Interpolate interpolate) {
+    if(numKeys == 0) {
+        return defaultValue;
+    }
+
+    uint32_t next = (uint32_t) (std::upper_bound(times, times + numKeys, time) - times);
+
+    if(next == 0) {
+        return values[0];
+    }
+
+    if(next == numKeys) {
+        return values[numKeys - 1];
+    }
+
+    float weight = (time - times[next - 1]) / (times[next] - times[next - 1]);
+
+    return interpolate(values[next - 1], values[next], weight);
+}
+
+glm::vec3 lerpKeys(const glm::vec3& from, const glm::vec3& to, float weight) {
+    return glm::mix(from, to, weight);
+}
+
+glm::quat slerpKeys(const glm::quat& from, glm::quat to, float weight) {
+    //q and -q are the same rotation, go the short way around
+    if(glm::dot(from, to) < 0.0f) {
+        to = -to;
+    }
+
+    return glm::slerp(from, to, weight);
+}
+
+//the component of a bone's transform that a version 2 frame channel holds
+float * frameValue(glm::vec3& position, glm::quat& rotation, glm::vec3& scale, unsigned int channel) {
+    switch(channel) {
+    case ResampledAnimation::ROTATION_X:
+        return &rotation.x;
+    case ResampledAnimation::ROTATION_Y:
+        return &rotation.y;
+    case ResampledAnimation::ROTATION_Z:
+        return &rotation.z;
+    case ResampledAnimation::ROTATION_W:
+        return &rotation.w;
+    case ResampledAnimation::TRANSLATION_X:
+        return &position.x;
+    case ResampledAnimation::TRANSLATION_Y:
+        return &position.y;
+    case ResampledAnimation::TRANSLATION_Z:
+        return &position.z;
+    case ResampledAnimation::SCALE_X:
+        return &scale.x;
+    case ResampledAnimation::SCALE_Y:
+        return &scale.y;
+    default:
+        return &scale.z;
+    }
+}
+
+uint32_t Animation::computeNumFrames() const {
+    //a frame at the start and one at the end, which can be closer than 1 / frame rate to the frame before it
+    return (uint32_t) ceil(m_duration * getSaveFrameRate() - 0.001f) + 1;
+}
+
+void Animation::resample(const Skeleton& skeleton, const char * name) {
+    float frameRate = getSaveFrameRate();
+    uint32_t numFrames = computeNumFrames();
+    uint16_t numBones = (uint16_t) skeleton.m_bones.size();
+
+    std::vector<Track> tracks(numBones);
+    std::vector<float> frameTimes(numFrames);
+    std::vector<glm::vec3> positions(numBones * numFrames);
+    std::vector<glm::quat> rotations(numBones * numFrames);
+    std::vector<glm::vec3> scales(numBones * numFrames);
+
+    //the last frame lands on the duration, ResampledAnimation::sample weights the shorter interval before it by its real length
+    for(uint32_t frame = 0; frame < numFrames; frame++) {
+        frameTimes[frame] = std::min((float) frame / frameRate, m_duration);
+    }
+
+    for(uint16_t bone = 0; bone < numBones; bone++) {
+        Track& track = tracks[bone];
+        track.m_bone = bone;
+
+        for(unsigned int channel = 0; channel < NUM_CHANNELS; channel++) {
+            track.m_beginKey[channel] = bone * numFrames;
+            track.m_numKeys[channel] = numFrames;
+        }
+
+        //what bones and channels with no keys stay at
+        glm::vec3 bindPosition;
+        glm::quat bindRotation;
+        glm::vec3 bindScale(1.0f);
+
+        if(!m_bindRelative) {
+            bindPosition = getTransformPosition(skeleton.m_bones[bone].m_relativeTransform);
+            getTransformRotationScale(skeleton.m_bones[bone].m_relativeTransform, bindRotation, bindScale);
+        }
+
+        const Track * source = findTrack(bone);
+        Track empty = {bone, {0, 0, 0}, {0, 0, 0}};
+
+        if(!source) {
+            source = &empty;
+        }
+
+        for(uint32_t frame = 0; frame < numFrames; frame++) {
+            uint32_t key = bone * numFrames + frame;
+
+            positions[key] = sampleKeys(getTimes(*source, CHANNEL_POSITION), getPositions(*source), source->m_numKeys[CHANNEL_POSITION],
+                frameTimes[frame], bindPosition, lerpKeys);
+            rotations[key] = glm::normalize(sampleKeys(getTimes(*source, CHANNEL_ROTATION), getRotations(*source), source->m_numKeys[CHANNEL_ROTATION],
+                frameTimes[frame], bindRotation, slerpKeys));
+            scales[key] = sampleKeys(getTimes(*source, CHANNEL_SCALE), getScales(*source), source->m_numKeys[CHANNEL_SCALE],
+                frameTimes[frame], bindScale, lerpKeys);
+
+            if(frame > 0 && glm::dot(rotations[key - 1], rotations[key]) < 0.0f) {
+                rotations[key] = -rotations[key];
+            }
+        }
+    }
+
+    size_t numKeys = m_positions.size() + m_rotations.size() + m_scales.size();
+
+    m_tracks.swap(tracks);
+    m_positions.swap(positions);
+    m_rotations.swap(rotations);
+    m_scales.swap(scales);
+
+    for(unsigned int channel = 0; channel < NUM_CHANNELS; channel++) {
+        m_times[channel].clear();
+
+        for(uint16_t bone = 0; bone < numBones; bone++) {
+            m_times[channel].insert(m_times[channel].end(), frameTimes.begin(), frameTimes.end());
+        }
+    }
+
+    LOG_INFO("Resampled animation %s from %u keys to %u frames of %u bones at %f frames per second",
+        name, (unsigned int) numKeys, numFrames, (unsigned int) numBones, frameRate);
+}
+
+void computeKeyFrames(const float * times, uint32_t numKeys, float frameRate, std::vector<uint16_t>& frames, std::vector<uint32_t>& keys) {
+    frames.clear();
+    keys.clear();
+
+    for(uint32_t key = 0; key < numKeys; key++) {
+        float frame = floor(times[key] * frameRate + 0.5f);
+
+        if(frame < 0.0f || frame > 65535.0f) {
+            LOG_FATAL_ERROR("Animation key at %f seconds is past the last frame version 1 can hold at %f frames per second, use a lower -animframerate", times[key], frameRate);
+        }
+
+        if(!frames.empty() && frames.back() == (uint16_t) frame) {
+            continue;
+        }
+
+        frames.push_back((uint16_t) frame);
+        keys.push_back(key);
+    }
+}
+
+/**
+Writes the key count and the quantized keys of a position or scale channel.
+@param maxError Set to the largest distance between a key and what it decodes to.
+@return How many keys were dropped for landing on the same frame.
+*/
+uint32_t writeQuantizedVectors(illFileSystem::File * openFile, const float * times, const glm::vec3 * values, uint32_t numKeys, float frameRate, float& maxError) {
+    std::vector<uint16_t> frames;
+    std::vector<uint32_t> keys;
+    computeKeyFrames(times, numKeys, frameRate, frames, keys);
+
+    uint16_t numSaved = (uint16_t) keys.size();
+    openFile->writeL16(numSaved);
+
+    maxError = 0.0f;
+
+    if(numSaved == 0) {
+        return 0;
+    }
+
+    //the range
+    glm::vec3 min = values[keys[0]];
+    glm::vec3 max = values[keys[0]];
+
+    for(uint16_t key = 1; key < numSaved; key++) {
+        min = glm::min(min, values[keys[key]]);
+        max = glm::max(max, values[keys[key]]);
+    }
+
+    glm::vec3 extent = max - min;
+
+    for(unsigned int component = 0; component < 3; component++) {
+        openFile->writeLF(min[component]);
+    }
+
+    for(unsigned int component = 0; component < 3; component++) {
+        openFile->writeLF(extent[component]);
+    }
+
+    for(uint16_t key = 0; key < numSaved; key++) {
+        openFile->writeL16(frames[key]);
+    }
+
+    //each component for all the keys, then the next, decoded back the way the runtime does to get the error
+    std::vector<uint16_t> quantized(numSaved);
+    std::vector<float> decodeBuffer(simdRoundUp(numSaved) + SIMD_WIDTH);
+    float * decoded = simdAlign(&decodeBuffer[0]);
+    std::vector<glm::vec3> errors(numSaved);
+
+    for(unsigned int component = 0; component < 3; component++) {
+        for(uint16_t key = 0; key < numSaved; key++) {
+            quantized[key] = encodeRange(values[keys[key]][component], min[component], extent[component]);
+            openFile->writeL16(quantized[key]);
+        }
+
+        decodeRange(&quantized[0], numSaved, min[component], extent[component], decoded);
+
+        for(uint16_t key = 0; key < numSaved; key++) {
+            errors[key][component] = decoded[key] - values[keys[key]][component];
+        }
+    }
+
+    for(uint16_t key = 0; key < numSaved; key++) {
+        maxError = std::max(maxError, glm::length(errors[key]));
+    }
+
+    return numKeys - numSaved;
+}
+
+/**
+Writes the key count and the smallest three keys of a rotation channel.
+@param maxError Set to the largest angle in radians between a key and what it decodes to.
+@return How many keys were dropped for landing on the same frame.
+*/
+uint32_t writeQuantizedRotations(illFileSystem::File * openFile, const float * times, const glm::quat * values, uint32_t numKeys, float frameRate, float& maxError) {
+    std::vector<uint16_t> frames;
+    std::vector<uint32_t> keys;
+    computeKeyFrames(times, numKeys, frameRate, frames, keys);
+
+    uint16_t numSaved = (uint16_t) keys.size();
+    openFile->writeL16(numSaved);
+
+    maxError = 0.0f;
+
+    if(numSaved == 0) {
+        return 0;
+    }
+
+    for(uint16_t key = 0; key < numSaved; key++) {
+        openFile->writeL16(frames[key]);
+    }
+
+    std::vector<uint16_t> components(numSaved * 3);
+
+    for(uint16_t key = 0; key < numSaved; key++) {
+        glm::quat rotation = glm::normalize(values[keys[key]]);
+        float xyzw[4] = {rotation.x, rotation.y, rotation.z, rotation.w};
+        uint16_t words[3];
+
+        encodeSmallestThree(xyzw, words);
+
+        for(unsigned int word = 0; word < 3; word++) {
+            components[word * numSaved + key] = words[word];
+        }
+    }
+
+    for(auto iter = components.cbegin(); iter != components.end(); iter++) {
+        openFile->writeL16(*iter);
+    }
+
+    //decode back the way the runtime does to get the error
+    size_t stride = simdRoundUp(numSaved);
+    std::vector<float> decodeBuffer(stride * 4 + SIMD_WIDTH);
+    float * decoded = simdAlign(&decodeBuffer[0]);
+
+    decodeSmallestThree(&components[0], numSaved, decoded);
+
+    for(uint16_t key = 0; key < numSaved; key++) {
+        glm::quat rotation = glm::normalize(values[keys[key]]);
+        float sign = rotation.x * decoded[key] + rotation.y * decoded[stride + key]
+            + rotation.z * decoded[2 * stride + key] + rotation.w * decoded[3 * stride + key] < 0.0f ? -1.0f : 1.0f;
+
+        //the angle from the distance between the quaternions, acos of the dot product loses small angles to float precision
+        float distanceSquared = 0.0f;
+
+        for(unsigned int component = 0; component < 4; component++) {
+            float difference = rotation[component] - sign * decoded[component * stride + key];
+            distanceSquared += difference * difference;
+        }
+
+        maxError = std::max(maxError, 4.0f * (float) asin(std::min((float) sqrt(distanceSquared) * 0.5f, 1.0f)));
+    }
+
+    return numKeys - numSaved;
+}
+
+//reads a channel written by writeQuantizedVectors
+uint32_t readQuantizedVectors(illFileSystem::File * openFile, float frameRate, std::vector<float>& times, std::vector<glm::vec3>& values) {
+    uint16_t numKeys;
+    openFile->readL16(numKeys);
+
+    if(numKeys == 0) {
+        return 0;
+    }
+
+    glm::vec3 min;
+    glm::vec3 extent;
+
+    for(unsigned int component = 0; component < 3; component++) {
+        openFile->readLF(min[component]);
+    }
+
+    for(unsigned int component = 0; component < 3; component++) {
+        openFile->readLF(extent[component]);
+    }
+
+    for(uint16_t key = 0; key < numKeys; key++) {
+        uint16_t frame;
+        openFile->readL16(frame);
+
+        times.push_back(frame / frameRate);
+    }
+
+    size_t beginKey = values.size();
+    values.resize(beginKey + numKeys);
+
+    std::vector<uint16_t> quantized(numKeys);
+    std::vector<float> decodeBuffer(simdRoundUp(numKeys) + SIMD_WIDTH);
+    float * decoded = simdAlign(&decodeBuffer[0]);
+
+    for(unsigned int component = 0; component < 3; component++) {
+        for(uint16_t key = 0; key < numKeys; key++) {
+            openFile->readL16(quantized[key]);
+        }
+
+        decodeRange(&quantized[0], numKeys, min[component], extent[component], decoded);
+
+        for(uint16_t key = 0; key < numKeys; key++) {
+            values[beginKey + key][component] = decoded[key];
+        }
+    }
+
+    return numKeys;
+}
+
+//reads a channel written by writeQuantizedRotations
+uint32_t readQuantizedRotations(illFileSystem::File * openFile, float frameRate, std::vector<float>& times, std::vector<glm::quat>& values) {
+    uint16_t numKeys;
+    openFile->readL16(numKeys);
+
+    if(numKeys == 0) {
+        return 0;
+    }
+
+    for(uint16_t key = 0; key < numKeys; key++) {
+        uint16_t frame;
+        openFile->readL16(frame);
+
+        times.push_back(frame / frameRate);
+    }
+
+    std::vector<uint16_t> components(numKeys * 3);
+
+    for(auto iter = components.begin(); iter != components.end(); iter++) {
+        openFile->readL16(*iter);
+    }
+
+    size_t stride = simdRoundUp(numKeys);
+    std::vector<float> decodeBuffer(stride * 4 + SIMD_WIDTH);
+    float * decoded = simdAlign(&decodeBuffer[0]);
+
+    decodeSmallestThree(&components[0], numKeys, decoded);
+
+    for(uint16_t key = 0; key < numKeys; key++) {
+        values.push_back(glm::quat(decoded[3 * stride + key], decoded[key], decoded[stride + key], decoded[2 * stride + key]));
+    }
+
+    return numKeys;
+}
+
+float Animation::getSaveFrameRate() const {
+    return m_frameRate > 0.0f ? m_frameRate : DEFAULT_FRAME_RATE;
+}
+
+uint16_t Animation::getSaveSegmentFrames() const {
+    float frames = floor((m_segmentLength > 0.0f ? m_segmentLength : DEFAULT_SEGMENT_LENGTH) * getSaveFrameRate() + 0.5f);
+
+    if(frames > 65535.0f) {
+        LOG_FATAL_ERROR("Animation segments can be at most 65535 frames long, use a shorter -animsegment");
+    }
+
+    return frames < 1.0f ? 1 : (uint16_t) frames;
+}
+
+//how many bytes the quantized keys of all the tracks take, not counting the key counts
+size_t computeQuantizedKeysSize(const Animation& animation, float frameRate) {
+    size_t size = 0;
+    std::vector<uint16_t> frames;
+    std::vector<uint32_t> keys;
+
+    for(auto iter = animation.m_tracks.cbegin(); iter != animation.m_tracks.end(); iter++) {
+        for(unsigned int channel = 0; channel < Animation::NUM_CHANNELS; channel++) {
+            computeKeyFrames(animation.getTimes(*iter, (Animation::Channel) channel), iter->m_numKeys[channel], frameRate, frames, keys);
+
+            if(keys.empty()) {
+                continue;
+            }
+
+            //frames and 3 words per key, positions and scales also have their range
+            size += keys.size() * 4 * 2 + (channel == Animation::CHANNEL_ROTATION ? 0 : 6 * 4);
+        }
+    }
+
+    return size;
+}
+
+//header size of version 3, before the first segment
+size_t computeSegmentedHeaderSize(size_t numTracks, size_t numSegments) {
+    //magic, duration, frame rate, flags, segment frames, number of bones, the bones, number of segments, and the offset table
+    return 8 + 4 + 4 + 1 + 2 + 2 + numTracks * 2 + 4 + (numSegments + 1) * 4;
+}
+
+/**
+Adds the keys of a channel between two times to a segment.
+Channels with one key keep just it, the others get the value at both times so the segment interpolates the same as the whole thing.
+@param minGap Keys closer than this to either end would land on the same frame as the added ones and are left out.
+*/
+template <typename Value, typename Interpolate>
+uint32_t extractKeys(const float * times, const Value * values, uint32_t numKeys, float beginTime, float endTime, float minGap, Interpolate interpolate,
+        std::vector<float>& segmentTimes, std::vector<Value>& segmentValues) {
+    if(numKeys == 0) {
+        return 0;
+    }
+
+    if(numKeys == 1) {
+        segmentTimes.push_back(0.0f);
+        segmentValues.push_back(values[0]);
+
+        return 1;
+    }
+
+    uint32_t numSegmentKeys = 1;
+
+    segmentTimes.push_back(0.0f);
+    segmentValues.push_back(sampleKeys(times, values, numKeys, beginTime, values[0], interpolate));
+
+    for(uint32_t key = 0; key < numKeys; key++) {
+        if(times[key] >= beginTime + minGap && times[key] <= endTime - minGap) {
+            segmentTimes.push_back(times[key] - beginTime);
+            segmentValues.push_back(values[key]);
+            numSegmentKeys++;
+        }
+    }
+
+    if(endTime > beginTime) {
+        segmentTimes.push_back(endTime - beginTime);
+        segmentValues.push_back(sampleKeys(times, values, numKeys, endTime, values[0], interpolate));
+        numSegmentKeys++;
+    }
+
+    return numSegmentKeys;
+}
+
+void Animation::extractSegment(float beginTime, float endTime, Animation& segment) const {
+    segment.m_duration = endTime - beginTime;
+    segment.m_frameRate = m_frameRate;
+    segment.m_bindRelative = m_bindRelative;
+    segment.m_tracks.resize(m_tracks.size());
+
+    float minGap = 0.5f / getSaveFrameRate();
+
+    for(size_t track = 0; track < m_tracks.size(); track++) {
+        const Track& source = m_tracks[track];
+        Track& destination = segment.m_tracks[track];
+
+        destination.m_bone = source.m_bone;
+
+        destination.m_beginKey[CHANNEL_POSITION] = (uint32_t) segment.m_positions.size();
+        destination.m_numKeys[CHANNEL_POSITION] = extractKeys(getTimes(source, CHANNEL_POSITION), getPositions(source), source.m_numKeys[CHANNEL_POSITION],
+            beginTime, endTime, minGap, lerpKeys, segment.m_times[CHANNEL_POSITION], segment.m_positions);
+
+        destination.m_beginKey[CHANNEL_ROTATION] = (uint32_t) segment.m_rotations.size();
+        destination.m_numKeys[CHANNEL_ROTATION] = extractKeys(getTimes(source, CHANNEL_ROTATION), getRotations(source), source.m_numKeys[CHANNEL_ROTATION],
+            beginTime, endTime, minGap, slerpKeys, segment.m_times[CHANNEL_ROTATION], segment.m_rotations);
+
+        destination.m_beginKey[CHANNEL_SCALE] = (uint32_t) segment.m_scales.size();
+        destination.m_numKeys[CHANNEL_SCALE] = extractKeys(getTimes(source, CHANNEL_SCALE), getScales(source), source.m_numKeys[CHANNEL_SCALE],
+            beginTime, endTime, minGap, lerpKeys, segment.m_times[CHANNEL_SCALE], segment.m_scales);
+    }
+}
+
+void Animation::computeSegments(std::vector<Animation>& segments) const {
+    float frameRate = getSaveFrameRate();
+    uint32_t segmentFrames = getSaveSegmentFrames();
+    uint32_t numFrames = computeNumFrames();
+    uint32_t numSegments = std::max((numFrames - 1 + segmentFrames - 1) / segmentFrames, 1u);
+
+    segments.clear();
+    segments.resize(numSegments);
+
+    for(uint32_t segment = 0; segment < numSegments; segment++) {
+        float beginTime = (float) (segment * segmentFrames) / frameRate;
+        float endTime = std::min((float) ((segment + 1) * segmentFrames) / frameRate, m_duration);
+
+        extractSegment(beginTime, std::max(endTime, beginTime), segments[segment]);
+    }
+}
+
+size_t Animation::computeSaveSize(unsigned int version) const {
+    if(version >= 3) {
+        std::vector<Animation> segments;
+        computeSegments(segments);
+
+        //each segment has the key counts of every track then the keys
+        size_t size = computeSegmentedHeaderSize(m_tracks.size(), segments.size());
+
+        for(auto iter = segments.cbegin(); iter != segments.end(); iter++) {
+            size += iter->computeQuantizedTracksSize();
+        }
+
+        return size;
+    }
+
+    if(version == 2) {
+        //magic, duration, frame rate, flags, number of bones, and number of frames, then every channel of every bone for each frame
+        return 8 + 4 + 4 + 1 + 2 + 4 + (size_t) computeNumFrames() * m_tracks.size() * ResampledAnimation::NUM_CHANNELS * 4;
+    }
+
+    if(version == 0) {
+        //magic, duration, and number of bones, then each bone's index and key counts
+        return 8 + 4 + 2 + m_tracks.size() * 8
+            + m_positions.size() * 4 * 4
+            + m_rotations.size() * 5 * 4
+            + m_scales.size() * 4 * 4;
+    }
+
+    //magic, duration, frame rate, flags, and number of bones, then each bone's index and key counts
+    return 8 + 4 + 4 + 1 + 2 + m_tracks.size() * 8 + computeQuantizedKeysSize(*this, getSaveFrameRate());
+}
+
+size_t Animation::computeQuantizedTracksSize() const {
+    //the key counts of every channel of every track then the keys
+    return m_tracks.size() * 6 + computeQuantizedKeysSize(*this, getSaveFrameRate());
+}
+
+uint32_t Animation::writeQuantizedTracks(illFileSystem::File * openFile, float * maxErrors) const {
+    float frameRate = getSaveFrameRate();
+    uint32_t numDropped = 0;
+
+    for(auto trackIter = m_tracks.cbegin(); trackIter != m_tracks.end(); trackIter++) {
+        float errors[NUM_CHANNELS];
+
+        numDropped += writeQuantizedVectors(openFile, getTimes(*trackIter, CHANNEL_POSITION), getPositions(*trackIter),
+            trackIter->m_numKeys[CHANNEL_POSITION], frameRate, errors[CHANNEL_POSITION]);
+        numDropped += writeQuantizedRotations(openFile, getTimes(*trackIter, CHANNEL_ROTATION), getRotations(*trackIter),
+            trackIter->m_numKeys[CHANNEL_ROTATION], frameRate, errors[CHANNEL_ROTATION]);
+        numDropped += writeQuantizedVectors(openFile, getTimes(*trackIter, CHANNEL_SCALE), getScales(*trackIter),
+            trackIter->m_numKeys[CHANNEL_SCALE], frameRate, errors[CHANNEL_SCALE]);
+
+        for(unsigned int channel = 0; channel < NUM_CHANNELS; channel++) {
+            maxErrors[channel] = std::max(maxErrors[channel], errors[channel]);
+        }
+    }
+
+    return numDropped;
+}
+
+AnimationClip Animation::getClip() const {
+    AnimationClip clip;
+
+    clip.m_tracks = m_tracks.empty() ? NULL : &m_tracks[0];
+    clip.m_numTracks = (uint16_t) m_tracks.size();
+    clip.m_numBones = 0;
+
+    for(auto iter = m_tracks.cbegin(); iter != m_tracks.end(); iter++) {
+        clip.m_numBones = std::max(clip.m_numBones, (uint16_t) (iter->m_bone + 1));
+    }
+
+    for(unsigned int channel = 0; channel < NUM_CHANNELS; channel++) {
+        clip.m_times[channel] = m_times[channel].empty() ? NULL : &m_times[channel][0];
+    }
+
+    //glm keeps the components in xyz and xyzw order with nothing between them
+    clip.m_positions = m_positions.empty() ? NULL : &m_positions[0].x;
+    clip.m_rotations = m_rotations.empty() ? NULL : &m_rotations[0].x;
+    clip.m_scales = m_scales.empty() ? NULL : &m_scales[0].x;
+    clip.m_duration = m_duration;
+
+    return clip;
+}
+
+const Animation::Track * Animation::findTrack(uint16_t bone) const {
+    auto iter = std::lower_bound(m_tracks.begin(), m_tracks.end(), bone, [] (const Track& track, uint16_t bone) {
+        return track.m_bone < bone;
+    });
+
+    return iter != m_tracks.end() && iter->m_bone == bone ? &*iter : NULL;
+}
+
+/**
+Adds the keys of a channel from one segment after the ones from the segments before.
+The first key of a segment is usually the last of the one before, that one's only kept once.
+*/
+template <typename Value>
+void appendSegmentKeys(const std::vector<float>& segmentTimes, const std::vector<Value>& segmentValues, float beginTime,
+        std::vector<float>& times, std::vector<Value>& values) {
+    for(size_t key = 0; key < segmentTimes.size(); key++) {
+        float time = beginTime + segmentTimes[key];
+
+        if(!times.empty() && time <= times.back() + 0.0001f) {
+            continue;
+        }
+
+        times.push_back(time);
+        values.push_back(segmentValues[key]);
+    }
+}
+
+//reads the rest of a version 3 file after the flags and joins the segments back into whole tracks
+void readSegments(illFileSystem::File * openFile, Animation& animation) {
+    float frameRate = animation.m_frameRate;
+
+    uint16_t segmentFrames;
+    openFile->readL16(segmentFrames);
+
+    animation.m_segmentLength = segmentFrames / frameRate;
+
+    uint16_t numTracks;
+    openFile->readL16(numTracks);
+
+    animation.m_tracks.resize(numTracks);
+
+    for(uint16_t track = 0; track < numTracks; track++) {
+        openFile->readL16(animation.m_tracks[track].m_bone);
+    }
+
+    uint32_t numSegments;
+    openFile->readL32(numSegments);
+
+    //the segments are read in order so the offsets aren't needed
+    openFile->seekAhead((numSegments + 1) * 4);
+
+    std::vector<std::vector<float> > trackTimes[Animation::NUM_CHANNELS];
+    std::vector<std::vector<glm::vec3> > trackPositions(numTracks);
+    std::vector<std::vector<glm::quat> > trackRotations(numTracks);
+    std::vector<std::vector<glm::vec3> > trackScales(numTracks);
+
+    for(unsigned int channel = 0; channel < Animation::NUM_CHANNELS; channel++) {
+        trackTimes[channel].resize(numTracks);
+    }
+
+    std::vector<float> segmentTimes;
+    std::vector<glm::vec3> segmentVectors;
+    std::vector<glm::quat> segmentRotations;
+
+    for(uint32_t segment = 0; segment < numSegments; segment++) {
+        float beginTime = (float) (segment * segmentFrames) / frameRate;
+
+        for(uint16_t track = 0; track < numTracks; track++) {
+            segmentTimes.clear();
+            segmentVectors.clear();
+            readQuantizedVectors(openFile, frameRate, segmentTimes, segmentVectors);
+            appendSegmentKeys(segmentTimes, segmentVectors, beginTime, trackTimes[Animation::CHANNEL_POSITION][track], trackPositions[track]);
+
+            segmentTimes.clear();
+            segmentRotations.clear();
+            readQuantizedRotations(openFile, frameRate, segmentTimes, segmentRotations);
+            appendSegmentKeys(segmentTimes, segmentRotations, beginTime, trackTimes[Animation::CHANNEL_ROTATION][track], trackRotations[track]);
+
+            segmentTimes.clear();
+            segmentVectors.clear();
+            readQuantizedVectors(openFile, frameRate, segmentTimes, segmentVectors);
+            appendSegmentKeys(segmentTimes, segmentVectors, beginTime, trackTimes[Animation::CHANNEL_SCALE][track], trackScales[track]);
+        }
+    }
+
+    //back to one array per channel for all the tracks
+    for(uint16_t track = 0; track < numTracks; track++) {
+        Animation::Track& currTrack = animation.m_tracks[track];
+
+        for(unsigned int channel = 0; channel < Animation::NUM_CHANNELS; channel++) {
+            currTrack.m_beginKey[channel] = (uint32_t) animation.m_times[channel].size();
+            currTrack.m_numKeys[channel] = (uint32_t) trackTimes[channel][track].size();
+
+            animation.m_times[channel].insert(animation.m_times[channel].end(), trackTimes[channel][track].begin(), trackTimes[channel][track].end());
+        }
+
+        animation.m_positions.insert(animation.m_positions.end(), trackPositions[track].begin(), trackPositions[track].end());
+        animation.m_rotations.insert(animation.m_rotations.end(), trackRotations[track].begin(), trackRotations[track].end());
+        animation.m_scales.insert(animation.m_scales.end(), trackScales[track].begin(), trackScales[track].end());
+    }
+}
+
+void Animation::load(const char * path) {
+    illFileSystem::File * openFile = illFileSystem::fileSystem->openRead(path);
+
+    //read magic number
+    uint64_t magic;
+    openFile->readB64(magic);
+
+    if(magic == ANIM_MAGIC) {
+        m_version = 0;
+    }
+    else if(magic == ANIM_MAGIC_1) {
+        m_version = 1;
+    }
+    else if(magic == ANIM_MAGIC_2) {
+        m_version = 2;
+    }
+    else if(magic == ANIM_MAGIC_3) {
+        m_version = 3;
+    }
+    else {
+        LOG_FATAL_ERROR("Not a valid ILLANIM0, ILLANIM1, ILLANIM2, or ILLANIM3 file.");
+    }
+
+    m_animation = NULL;
+    m_tracks.clear();
+
+    for(unsigned int channel = 0; channel < NUM_CHANNELS; channel++) {
+        m_times[channel].clear();
+    }
+
+    m_positions.clear();
+    m_rotations.clear();
+    m_scales.clear();
+
+    //read duration in seconds
+    openFile->readLF(m_duration);
+
+    m_bindRelative = false;
+
+    if(m_version >= 1) {
+        openFile->readLF(m_frameRate);
+
+        uint8_t flags;
+        openFile->read8(flags);
+
+        m_bindRelative = (flags & ANIM_FLAG_BIND_RELATIVE) != 0;
+    }
+
+    if(m_version >= 3) {
+        readSegments(openFile, *this);
+
+        delete openFile;
+        return;
+    }
+
+    //read number of bones
+    uint16_t numBones;
+    openFile->readL16(numBones);
+
+    m_tracks.resize(numBones);
+
+    //every bone has a key on every frame, read them back into a track per bone
+    if(m_version >= 2) {
+        uint32_t numFrames;
+        openFile->readL32(numFrames);
+
+        for(uint16_t bone = 0; bone < numBones; bone++) {
+            m_tracks[bone].m_bone = bone;
+
+            for(unsigned int channel = 0; channel < NUM_CHANNELS; channel++) {
+                m_tracks[bone].m_beginKey[channel] = bone * numFrames;
+                m_tracks[bone].m_numKeys[channel] = numFrames;
+                m_times[channel].resize(numBones * numFrames);
+            }
+        }
+
+        m_positions.resize(numBones * numFrames);
+        m_rotations.resize(numBones * numFrames);
+        m_scales.resize(numBones * numFrames);
+
+        for(uint32_t frame = 0; frame < numFrames; frame++) {
+            float time = std::min((float) frame / m_frameRate, m_duration);
+
+            for(unsigned int channel = 0; channel < ResampledAnimation::NUM_CHANNELS; channel++) {
+                for(uint16_t bone = 0; bone < numBones; bone++) {
+                    uint32_t key = bone * numFrames + frame;
+                    openFile->readLF(*frameValue(m_positions[key], m_rotations[key], m_scales[key], channel));
+
+                    if(channel == 0) {
+                        m_times[CHANNEL_POSITION][key] = time;
+                        m_times[CHANNEL_ROTATION][key] = time;
+                        m_times[CHANNEL_SCALE][key] = time;
+                    }
+                }
+            }
+        }
+
+        delete openFile;
+        return;
+    }
+
+    //the bones
+    for(uint16_t bone = 0; bone < numBones; bone++) {
+        Track& track = m_tracks[bone];
+
+        //bone index
+        openFile->readL16(track.m_bone);
+
+        if(m_version >= 1) {
+            track.m_beginKey[CHANNEL_POSITION] = (uint32_t) m_positions.size();
+            track.m_numKeys[CHANNEL_POSITION] = readQuantizedVectors(openFile, m_frameRate, m_times[CHANNEL_POSITION], m_positions);
+
+            track.m_beginKey[CHANNEL_ROTATION] = (uint32_t) m_rotations.size();
+            track.m_numKeys[CHANNEL_ROTATION] = readQuantizedRotations(openFile, m_frameRate, m_times[CHANNEL_ROTATION], m_rotations);
+
+            track.m_beginKey[CHANNEL_SCALE] = (uint32_t) m_scales.size();
+            track.m_numKeys[CHANNEL_SCALE] = readQuantizedVectors(openFile, m_frameRate, m_times[CHANNEL_SCALE], m_scales);
+
+            continue;
+        }
+
+        //position keys
+        uint16_t numKeys;
+        openFile->readL16(numKeys);
+
+        track.m_beginKey[CHANNEL_POSITION] = (uint32_t) m_positions.size();
+        track.m_numKeys[CHANNEL_POSITION] = numKeys;
+
+        for(uint16_t key = 0; key < numKeys; key++) {
+            float time;
+            glm::vec3 position;
+
+            openFile->readLF(time);
+            openFile->readLF(position.x);
+            openFile->readLF(position.y);
+            openFile->readLF(position.z);
+
+            m_times[CHANNEL_POSITION].push_back(time);
+            m_positions.push_back(position);
+        }
+
+        //rotation keys
+        openFile->readL16(numKeys);
+
+        track.m_beginKey[CHANNEL_ROTATION] = (uint32_t) m_rotations.size();
+        track.m_numKeys[CHANNEL_ROTATION] = numKeys;
+
+        for(uint16_t key = 0; key < numKeys; key++) {
+            float time;
+            glm::quat rotation;
+
+            openFile->readLF(time);
+            openFile->readLF(rotation.x);
+            openFile->readLF(rotation.y);
+            openFile->readLF(rotation.z);
+            openFile->readLF(rotation.w);
+
+            m_times[CHANNEL_ROTATION].push_back(time);
+            m_rotations.push_back(rotation);
+        }
+
+        //scaling keys
+        openFile->readL16(numKeys);
+
+        track.m_beginKey[CHANNEL_SCALE] = (uint32_t) m_scales.size();
+        track.m_numKeys[CHANNEL_SCALE] = numKeys;
+
+        for(uint16_t key = 0; key < numKeys; key++) {
+            float time;
+            glm::vec3 scale;
+
+            openFile->readLF(time);
+            openFile->readLF(scale.x);
+            openFile->readLF(scale.y);
+            openFile->readLF(scale.z);
+
+            m_times[CHANNEL_SCALE].push_back(time);
+            m_scales.push_back(scale);
+        }
+    }
+
+    delete openFile;
+
+    //older files weren't always written in bone order
+    std::stable_sort(m_tracks.begin(), m_tracks.end(), [] (const Track& left, const Track& right) {
+        return left.m_bone < right.m_bone;
+    });
+}
+
+void Animation::save(const char * path) const {
+    if(m_version >= 3) {
+        saveSegmented(path);
+        return;
+    }
+
+    if(m_version == 2) {
+        saveResampled(path);
+        return;
+    }
+
+    if(m_version >= 1) {
+        saveQuantized(path);
+        return;
+    }
+
+    if(m_bindRelative) {
+        LOG_FATAL_ERROR("Animation %s has keys relative to the bind pose which version 0 can't hold", path);
+    }
+
+    illFileSystem::File * openFile = illFileSystem::fileSystem->openWrite(path);
+
+    //write magic number
+    openFile->writeB64(ANIM_MAGIC);
+
+    //write duration in seconds
+    openFile->writeLF(m_duration);
+
+    //write number of bones
+    openFile->writeL16((uint16_t) m_tracks.size());
+
+    //the bones
+    for(auto trackIter = m_tracks.cbegin(); trackIter != m_tracks.end(); trackIter++) {
+        //bone index
+        openFile->writeL16(trackIter->m_bone);
+
+        //number of position keys
+        openFile->writeL16((uint16_t) trackIter->m_numKeys[CHANNEL_POSITION]);
+
+        //position keys
+        const float * times = getTimes(*trackIter, CHANNEL_POSITION);
+        const glm::vec3 * positions = getPositions(*trackIter);
+
+        for(uint32_t key = 0; key < trackIter->m_numKeys[CHANNEL_POSITION]; key++) {
+            //write time stamp
+            openFile->writeLF(times[key]);
+
+            //write the position
+            openFile->writeLF(positions[key].x);
+            openFile->writeLF(positions[key].y);
+            openFile->writeLF(positions[key].z);
+        }
+
+        //number of rotation keys
+        openFile->writeL16((uint16_t) trackIter->m_numKeys[CHANNEL_ROTATION]);
+
+        //rotation keys
+        times = getTimes(*trackIter, CHANNEL_ROTATION);
+        const glm::quat * rotations = getRotations(*trackIter);
+
+        for(uint32_t key = 0; key < trackIter->m_numKeys[CHANNEL_ROTATION]; key++) {
+            //write time stamp
+            openFile->writeLF(times[key]);
+
+            //write the rotation
+            openFile->writeLF(rotations[key].x);
+            openFile->writeLF(rotations[key].y);
+            openFile->writeLF(rotations[key].z);
+            openFile->writeLF(rotations[key].w);
+        }
+
+        //number of scaling keys
+        openFile->writeL16((uint16_t) trackIter->m_numKeys[CHANNEL_SCALE]);
+
+        //scaling keys
+        times = getTimes(*trackIter, CHANNEL_SCALE);
+        const glm::vec3 * scales = getScales(*trackIter);
+
+        for(uint32_t key = 0; key < trackIter->m_numKeys[CHANNEL_SCALE]; key++) {
+            //write time stamp
+            openFile->writeLF(times[key]);
+
+            //write the scale
+            openFile->writeLF(scales[key].x);
+            openFile->writeLF(scales[key].y);
+            openFile->writeLF(scales[key].z);
+        }
+    }
+
+    delete openFile;
+}
+
+void Animation::saveQuantized(const char * path) const {
+    illFileSystem::File * openFile = illFileSystem::fileSystem->openWrite(path);
+
+    //write magic number
+    openFile->writeB64(ANIM_MAGIC_1);
+
+    //write duration in seconds
+    openFile->writeLF(m_duration);
+
+    //key times are saved as frames at this rate
+    float frameRate = getSaveFrameRate();
+    openFile->writeLF(frameRate);
+
+    //whether the keys are deltas from the bind pose
+    openFile->write8(m_bindRelative ? ANIM_FLAG_BIND_RELATIVE : 0);
+
+    //write number of bones
+    openFile->writeL16((uint16_t) m_tracks.size());
+
+    uint32_t numDropped = 0;
+
+    //the bones
+    for(auto trackIter = m_tracks.cbegin(); trackIter != m_tracks.end(); trackIter++) {
+        //bone index
+        openFile->writeL16(trackIter->m_bone);
+
+        float errors[NUM_CHANNELS];
+
+        numDropped += writeQuantizedVectors(openFile, getTimes(*trackIter, CHANNEL_POSITION), getPositions(*trackIter),
+            trackIter->m_numKeys[CHANNEL_POSITION], frameRate, errors[CHANNEL_POSITION]);
+        numDropped += writeQuantizedRotations(openFile, getTimes(*trackIter, CHANNEL_ROTATION), getRotations(*trackIter),
+            trackIter->m_numKeys[CHANNEL_ROTATION], frameRate, errors[CHANNEL_ROTATION]);
+        numDropped += writeQuantizedVectors(openFile, getTimes(*trackIter, CHANNEL_SCALE), getScales(*trackIter),
+            trackIter->m_numKeys[CHANNEL_SCALE], frameRate, errors[CHANNEL_SCALE]);
+
+        LOG_INFO("Animation %s bone %u max error: position %f, rotation %f degrees, scale %f", path, trackIter->m_bone,
+            errors[CHANNEL_POSITION], errors[CHANNEL_ROTATION] * 180.0f / 3.14159265f, errors[CHANNEL_SCALE]);
+    }
+
+    delete openFile;
+
+    if(numDropped > 0) {
+        LOG_INFO("Warning: dropped %u keys of animation %s that landed on the same frame at %f frames per second", numDropped, path, frameRate);
+    }
+
+    LOG_INFO("Saved animation %s as version 1, %u bytes, %.2f times smaller than version 0", path,
+        (unsigned int) computeSaveSize(1), (double) computeSaveSize(0) / computeSaveSize(1));
+}
+
+void Animation::saveResampled(const char * path) const {
+    //resampling leaves a track per bone in order with the same frames in every channel
+    uint32_t numFrames = m_tracks.empty() ? 0 : m_tracks[0].m_numKeys[CHANNEL_POSITION];
+
+    for(uint16_t bone = 0; bone < (uint16_t) m_tracks.size(); bone++) {
+        const Track& track = m_tracks[bone];
+
+        if(track.m_bone != bone || track.m_numKeys[CHANNEL_POSITION] != numFrames
+                || track.m_numKeys[CHANNEL_ROTATION] != numFrames || track.m_numKeys[CHANNEL_SCALE] != numFrames) {
+            LOG_FATAL_ERROR("Animation %s needs to be resampled before saving as version 2", path);
+        }
+    }
+
+    illFileSystem::File * openFile = illFileSystem::fileSystem->openWrite(path);
+
+    //write magic number
+    openFile->writeB64(ANIM_MAGIC_2);
+
+    //write duration in seconds
+    openFile->writeLF(m_duration);
+
+    //the rate the frames are at
+    openFile->writeLF(getSaveFrameRate());
+
+    //whether the frames are deltas from the bind pose
+    openFile->write8(m_bindRelative ? ANIM_FLAG_BIND_RELATIVE : 0);
+
+    //write number of bones and frames
+    openFile->writeL16((uint16_t) m_tracks.size());
+    openFile->writeL32(numFrames);
+
+    //each frame has each channel of all the bones in a row
+    for(uint32_t frame = 0; frame < numFrames; frame++) {
+        for(unsigned int channel = 0; channel < ResampledAnimation::NUM_CHANNELS; channel++) {
+            for(auto trackIter = m_tracks.cbegin(); trackIter != m_tracks.end(); trackIter++) {
+                glm::vec3 position = getPositions(*trackIter)[frame];
+                glm::quat rotation = getRotations(*trackIter)[frame];
+                glm::vec3 scale = getScales(*trackIter)[frame];
+
+                openFile->writeLF(*frameValue(position, rotation, scale, channel));
+            }
+        }
+    }
+
+    delete openFile;
+
+    LOG_INFO("Saved animation %s as version 2, %u frames of %u bones, %u bytes", path, numFrames, (unsigned int) m_tracks.size(),
+        (unsigned int) computeSaveSize(2));
+}
+
+void Animation::saveSegmented(const char * path) const {
+    float frameRate = getSaveFrameRate();
+    uint16_t segmentFrames = getSaveSegmentFrames();
+
+    std::vector<Animation> segments;
+    computeSegments(segments);
+
+    illFileSystem::File * openFile = illFileSystem::fileSystem->openWrite(path);
+
+    //write magic number
+    openFile->writeB64(ANIM_MAGIC_3);
+
+    //write duration in seconds
+    openFile->writeLF(m_duration);
+
+    //key times are saved as frames from the start of their segment at this rate
+    openFile->writeLF(frameRate);
+
+    //whether the keys are deltas from the bind pose
+    openFile->write8(m_bindRelative ? ANIM_FLAG_BIND_RELATIVE : 0);
+
+    //segment length in frames
+    openFile->writeL16(segmentFrames);
+
+    //write number of bones and the bone of each track, every segment has the same tracks
+    openFile->writeL16((uint16_t) m_tracks.size());
+
+    for(auto trackIter = m_tracks.cbegin(); trackIter != m_tracks.end(); trackIter++) {
+        openFile->writeL16(trackIter->m_bone);
+    }
+
+    //the offset of each segment from the start of the file, then the end of the last one, so the runtime can seek right to one
+    openFile->writeL32((uint32_t) segments.size());
+
+    size_t offset = computeSegmentedHeaderSize(m_tracks.size(), segments.size());
+    size_t largestSegment = 0;
+
+    for(auto segmentIter = segments.cbegin(); segmentIter != segments.end(); segmentIter++) {
+        openFile->writeL32((uint32_t) offset);
+
+        size_t segmentSize = segmentIter->computeQuantizedTracksSize();
+        largestSegment = std::max(largestSegment, segmentSize);
+        offset += segmentSize;
+    }
+
+    openFile->writeL32((uint32_t) offset);
+
+    //the segments
+    uint32_t numDropped = 0;
+    float maxErrors[NUM_CHANNELS] = {0.0f, 0.0f, 0.0f};
+
+    for(auto segmentIter = segments.cbegin(); segmentIter != segments.end(); segmentIter++) {
+        numDropped += segmentIter->writeQuantizedTracks(openFile, maxErrors);
+    }
+
+    delete openFile;
+
+    if(numDropped > 0) {
+        LOG_INFO("Warning: dropped %u keys of animation %s that landed on the same frame at %f frames per second", numDropped, path, frameRate);
+    }
+
+    LOG_INFO("Animation %s max error: position %f, rotation %f degrees, scale %f", path,
+        maxErrors[CHANNEL_POSITION], maxErrors[CHANNEL_ROTATION] * 180.0f / 3.14159265f, maxErrors[CHANNEL_SCALE]);
+
+    LOG_INFO("Saved animation %s as version 3, %u segments of %u frames, %u bytes, largest segment %u bytes", path,
+        (unsigned int) segments.size(), (unsigned int) segmentFrames, (unsigned int) offset, (unsigned int) largestSegment);
 }
\ No newline at end of file
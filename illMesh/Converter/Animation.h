@@ -2,31 +2,144 @@
 #define ILL_CONVERTER_ANIMATION_H_
 
 #include <assimp/scene.h>
-#include <unordered_map>
-#include <map>
+#include <stdint.h>
+#include <vector>
 
 #include "illEngine/Util/Geometry/Transform.h"
 
+#include "../Runtime/AnimationSampler.h"
+
 class AnimSet;
 class Skeleton;
 
+namespace illFileSystem {
+class File;
+}
+
+/**
+An animation clip with the keys stored as columns instead of per key nodes.
+Each channel has one array of key times and one array of values for all the bones, and each bone's track is a range of those.
+*/
 class Animation {
 public:
-    struct AnimData {        		
-        std::map<float, glm::vec3> m_positionKeys;
-        std::map<float, glm::quat> m_rotationKeys;
-        std::map<float, glm::vec3> m_scalingKeys;
+    enum Channel {
+        CHANNEL_POSITION,
+        CHANNEL_ROTATION,
+        CHANNEL_SCALE,
+
+        NUM_CHANNELS
     };
 
-    typedef std::unordered_map<uint16_t, AnimData> BoneAnimationMap;
+    //the keys of one bone, the same tracks the runtime sampler uses
+    typedef AnimationTrack Track;
+
+    Animation()
+        : m_animation(NULL),
+        m_duration(0.0f),
+        m_frameRate(0.0f),
+        m_version(0),
+        m_bindRelative(false),
+        m_segmentLength(0.0f)
+    {}
+
+    void load(const char * path);
+    void save(const char * path) const;
+
+    //saves version 1, with the keys quantized and their times as frames, and logs the error of each track
+    void saveQuantized(const char * path) const;
+
+    //saves version 2, the animation needs to have been resampled
+    void saveResampled(const char * path) const;
+
+    //saves version 3, split into time segments that are each quantized like version 1
+    void saveSegmented(const char * path) const;
+
+    /**
+    Copies out the keys between two times, with the values at both times added so the segment samples the same on its own.
+    The key times in the segment are relative to beginTime.
+    */
+    void extractSegment(float beginTime, float endTime, Animation& segment) const;
+
+    //the version 3 segments, each one starting getSaveSegmentFrames() frames after the last
+    void computeSegments(std::vector<Animation>& segments) const;
+    void import(const aiAnimation* animation, const aiScene * scene, const AnimSet * animset);
+
+    /**
+    Turns the keys into deltas from the skeleton's bind pose and drops the channels that stay within a tolerance of it.
+    Positions become offsets from the bind position, rotations the rotation applied after the bind rotation,
+    and scales the factor of the bind scale, so sampling a track gives the bind transform back for missing channels.
+    Tracks left with no channels are dropped too.
+    @param rotationTolerance In degrees.
+    @param name What to call the animation in the log.
+    */
+    void makeBindRelative(const Skeleton& skeleton, float positionTolerance, float rotationTolerance, float scaleTolerance, const char * name);
+
+    /**
+    Samples the animation at the save frame rate, leaving a track for every bone of the skeleton with a key on every frame in every channel.
+    Channels with no keys get the bind pose, or identity if the keys are relative to it.
+    Rotations are flipped to be on the same side as the frame before so the runtime can nlerp between frames without checking.
+    @param name What to call the animation in the log.
+    */
+    void resample(const Skeleton& skeleton, const char * name);
+
+    //how many frames resampling gives
+    uint32_t computeNumFrames() const;
 
-    void save(const char * path);
-    void import(const aiAnimation* animation, const Skeleton * skeleton, const AnimSet * animset);
+    //how many bytes saving as a version writes
+    size_t computeSaveSize(unsigned int version) const;
 
-    const aiAnimation* m_animation;
+    //how many bytes writeQuantizedTracks writes
+    size_t computeQuantizedTracksSize() const;
+
+    /**
+    Writes the channels of every track quantized like version 1 without the bone indices, the way version 3 segments and animation databases hold them.
+    @param maxErrors Raised to the largest error of each channel.
+    @return How many keys were dropped for landing on the same frame.
+    */
+    uint32_t writeQuantizedTracks(illFileSystem::File * openFile, float * maxErrors) const;
+
+    //the frame rate versions 1, 2, and 3 use
+    float getSaveFrameRate() const;
+
+    //how many frames long version 3 segments are
+    uint16_t getSaveSegmentFrames() const;
+
+    //the keys as the runtime sampler sees them, only good until the keys change
+    AnimationClip getClip() const;
+
+    //the track of a bone, NULL if the bone isn't animated
+    const Track * findTrack(uint16_t bone) const;
+
+    inline const float * getTimes(const Track& track, Channel channel) const {
+        return m_times[channel].data() + track.m_beginKey[channel];
+    }
+
+    inline const glm::vec3 * getPositions(const Track& track) const {
+        return m_positions.data() + track.m_beginKey[CHANNEL_POSITION];
+    }
+
+    inline const glm::quat * getRotations(const Track& track) const {
+        return m_rotations.data() + track.m_beginKey[CHANNEL_ROTATION];
+    }
+
+    inline const glm::vec3 * getScales(const Track& track) const {
+        return m_scales.data() + track.m_beginKey[CHANNEL_SCALE];
+    }
+
+    const aiAnimation* m_animation;     //NULL if the animation was loaded from a file
 
     float m_duration;
-    BoneAnimationMap m_boneAnimation;
+    float m_frameRate;          //frames per second that version 1 key times are snapped to and version 2 is sampled at, 0 for the default
+    unsigned int m_version;     //animation file version to save as
+    bool m_bindRelative;        //keys are deltas from the bind pose, only version 1 and up can save this
+    float m_segmentLength;      //seconds in each version 3 segment, 0 for the default
+
+    std::vector<Track> m_tracks;                //ordered by bone index, bones dropped by bone LODs are then all at the end
+
+    std::vector<float> m_times[NUM_CHANNELS];   //key times of all the tracks for each channel
+    std::vector<glm::vec3> m_positions;
+    std::vector<glm::quat> m_rotations;
+    std::vector<glm::vec3> m_scales;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,371 @@
+#include <algorithm>
+#include <cmath>
+
+#include "AnimationBaker.h"
+#include "Animation.h"
+#include "MeshBuffer.h"
+#include "Skeleton.h"
+
+#include "../Runtime/AnimationCodec.h"
+#include "../Runtime/AnimationSampler.h"
+#include "../Runtime/Pose.h"
+#include "../Runtime/PoseBuffer.h"
+#include "../Runtime/Skinning.h"
+
+#include "illEngine/FileSystem/FileSystem.h"
+#include "illEngine/FileSystem/File.h"
+
+#include "illEngine/Logging/logging.h"
+
+const uint64_t BAKE_MAGIC = 0x494C4C42414B4530;		//ILLBAKE0 in 64 bit big endian
+
+enum BakeType {
+    BAKE_BONES,
+    BAKE_VERTICES
+};
+
+//scales that differ more than this between axes can't be baked into a bone texel
+const float NON_UNIFORM_SCALE_TOLERANCE = 0.01f;
+
+/**
+The skinning palette of every frame of an animation.
+@param palettes Set to AFFINE_FLOATS per bone for each frame, one frame after the other.
+*/
+void computeFramePalettes(const Animation& animation, const Skeleton& skeleton, uint32_t numFrames, std::vector<float>& palettes) {
+    if(animation.m_bindRelative) {
+        LOG_FATAL_ERROR("Can't bake an animation with keys relative to the bind pose");
+    }
+
+    uint16_t numBones = (uint16_t) skeleton.m_bones.size();
+    AnimationClip clip = animation.getClip();
+
+    if(clip.m_numBones > numBones) {
+        LOG_FATAL_ERROR("The animation animates bone %u but the skeleton only has %u bones", clip.m_numBones - 1, numBones);
+    }
+
+    PoseBuffer pose;
+    skeleton.getBindPose(pose);
+
+    AnimationCursor cursor;
+    cursor.reset(clip);
+
+    std::vector<float> inverseBinds;
+    skeleton.getInverseBindTransforms(inverseBinds);
+
+    std::vector<float> localTransforms(numBones * AFFINE_FLOATS);
+    std::vector<float> modelTransforms(numBones * AFFINE_FLOATS);
+    palettes.resize(numFrames * numBones * AFFINE_FLOATS);
+
+    for(uint32_t frame = 0; frame < numFrames; frame++) {
+        float time = std::min((float) frame / animation.getSaveFrameRate(), animation.m_duration);
+
+        //bones without tracks keep the bind pose the whole time
+        sampleAnimation(clip, time, cursor, pose);
+
+        computeLocalTransforms(pose, numBones, &localTransforms[0]);
+        computeModelTransforms(&localTransforms[0], &skeleton.m_parents[0], numBones, &modelTransforms[0]);
+        computeSkinningPalette(&modelTransforms[0], &inverseBinds[0], numBones, &palettes[frame * numBones * AFFINE_FLOATS]);
+    }
+}
+
+/**
+Splits a 3x4 transform into a rotation, uniform scale, and translation.
+@return How far the scale is from uniform.
+*/
+float decomposeUniform(const float * transform, float * rotation, float& scale, float * translation) {
+    float axisScales[3];
+
+    for(unsigned int col = 0; col < 3; col++) {
+        axisScales[col] = sqrt(transform[col] * transform[col] + transform[4 + col] * transform[4 + col] + transform[8 + col] * transform[8 + col]);
+    }
+
+    scale = (axisScales[0] + axisScales[1] + axisScales[2]) / 3.0f;
+
+    float m[3][3];
+
+    for(unsigned int row = 0; row < 3; row++) {
+        translation[row] = transform[row * 4 + 3];
+
+        for(unsigned int col = 0; col < 3; col++) {
+            m[row][col] = scale > 0.0f ? transform[row * 4 + col] / scale : 0.0f;
+        }
+    }
+
+    //rotation matrix to quaternion, going off the largest diagonal for precision
+    float trace = m[0][0] + m[1][1] + m[2][2];
+
+    if(trace > 0.0f) {
+        float s = sqrt(trace + 1.0f) * 2.0f;
+        rotation[3] = 0.25f * s;
+        rotation[0] = (m[2][1] - m[1][2]) / s;
+        rotation[1] = (m[0][2] - m[2][0]) / s;
+        rotation[2] = (m[1][0] - m[0][1]) / s;
+    }
+    else if(m[0][0] > m[1][1] && m[0][0] > m[2][2]) {
+        float s = sqrt(1.0f + m[0][0] - m[1][1] - m[2][2]) * 2.0f;
+        rotation[3] = (m[2][1] - m[1][2]) / s;
+        rotation[0] = 0.25f * s;
+        rotation[1] = (m[0][1] + m[1][0]) / s;
+        rotation[2] = (m[0][2] + m[2][0]) / s;
+    }
+    else if(m[1][1] > m[2][2]) {
+        float s = sqrt(1.0f + m[1][1] - m[0][0] - m[2][2]) * 2.0f;
+        rotation[3] = (m[0][2] - m[2][0]) / s;
+        rotation[0] = (m[0][1] + m[1][0]) / s;
+        rotation[1] = 0.25f * s;
+        rotation[2] = (m[1][2] + m[2][1]) / s;
+    }
+    else {
+        float s = sqrt(1.0f + m[2][2] - m[0][0] - m[1][1]) * 2.0f;
+        rotation[3] = (m[1][0] - m[0][1]) / s;
+        rotation[0] = (m[0][2] + m[2][0]) / s;
+        rotation[1] = (m[1][2] + m[2][1]) / s;
+        rotation[2] = 0.25f * s;
+    }
+
+    float length = sqrt(rotation[0] * rotation[0] + rotation[1] * rotation[1] + rotation[2] * rotation[2] + rotation[3] * rotation[3]);
+
+    for(unsigned int component = 0; component < 4; component++) {
+        rotation[component] /= length;
+    }
+
+    return std::max(fabs(axisScales[0] - scale), std::max(fabs(axisScales[1] - scale), fabs(axisScales[2] - scale))) / std::max(scale, 1e-6f);
+}
+
+//a unit vector folded onto an octahedron and flattened to two bytes
+uint16_t encodeOctahedron(float x, float y, float z) {
+    float sum = fabs(x) + fabs(y) + fabs(z);
+
+    if(sum > 0.0f) {
+        x /= sum;
+        y /= sum;
+        z /= sum;
+    }
+
+    //the lower half folds over the upper half's corners
+    if(z < 0.0f) {
+        float foldedX = (1.0f - fabs(y)) * (x < 0.0f ? -1.0f : 1.0f);
+        float foldedY = (1.0f - fabs(x)) * (y < 0.0f ? -1.0f : 1.0f);
+
+        x = foldedX;
+        y = foldedY;
+    }
+
+    uint16_t encodedX = (uint16_t) floor((x * 0.5f + 0.5f) * 255.0f + 0.5f);
+    uint16_t encodedY = (uint16_t) floor((y * 0.5f + 0.5f) * 255.0f + 0.5f);
+
+    return (uint16_t) (encodedX | (encodedY << 8));
+}
+
+/**
+Writes the header all bake types share.
+@return How many rows each frame takes.
+*/
+uint32_t writeBakeHeader(illFileSystem::File * openFile, BakeType type, uint32_t numItems, const Animation& animation, uint32_t numFrames,
+        uint32_t maxWidth, uint32_t& width) {
+    width = std::max(std::min(numItems, maxWidth), 1u);
+    uint32_t rowsPerFrame = std::max((numItems + width - 1) / width, 1u);
+
+    //write magic number
+    openFile->writeB64(BAKE_MAGIC);
+
+    openFile->write8((uint8_t) type);
+    openFile->writeL32(numItems);
+
+    //the frames
+    openFile->writeLF(animation.getSaveFrameRate());
+    openFile->writeLF(animation.m_duration);
+    openFile->writeL32(numFrames);
+
+    //the texture
+    openFile->writeL32(width);
+    openFile->writeL32(numFrames * rowsPerFrame);
+    openFile->writeL32(rowsPerFrame);
+
+    return rowsPerFrame;
+}
+
+void AnimationBaker::bakeBones(const Animation& animation, const Skeleton& skeleton, const char * path) const {
+    uint32_t numFrames = animation.computeNumFrames();
+    uint16_t numBones = (uint16_t) skeleton.m_bones.size();
+
+    std::vector<float> palettes;
+    computeFramePalettes(animation, skeleton, numFrames, palettes);
+
+    //split every transform up and find the ranges to quantize in
+    std::vector<float> rotations(numFrames * numBones * 4);
+    std::vector<float> scales(numFrames * numBones);
+    std::vector<float> translations(numFrames * numBones * 3);
+
+    float minScale = 0.0f;
+    float maxScale = 0.0f;
+    float minTranslation[3] = {0.0f, 0.0f, 0.0f};
+    float maxTranslation[3] = {0.0f, 0.0f, 0.0f};
+    float maxNonUniform = 0.0f;
+
+    for(uint32_t transform = 0; transform < numFrames * numBones; transform++) {
+        maxNonUniform = std::max(maxNonUniform, decomposeUniform(&palettes[transform * AFFINE_FLOATS],
+            &rotations[transform * 4], scales[transform], &translations[transform * 3]));
+
+        minScale = transform == 0 ? scales[transform] : std::min(minScale, scales[transform]);
+        maxScale = transform == 0 ? scales[transform] : std::max(maxScale, scales[transform]);
+
+        for(unsigned int component = 0; component < 3; component++) {
+            float value = translations[transform * 3 + component];
+
+            minTranslation[component] = transform == 0 ? value : std::min(minTranslation[component], value);
+            maxTranslation[component] = transform == 0 ? value : std::max(maxTranslation[component], value);
+        }
+    }
+
+    if(maxNonUniform > NON_UNIFORM_SCALE_TOLERANCE) {
+        LOG_INFO("Warning: baked bones of %s have scales up to %f off from uniform, bone textures only hold uniform scale", path, maxNonUniform);
+    }
+
+    illFileSystem::File * openFile = illFileSystem::fileSystem->openWrite(path);
+
+    uint32_t width;
+    uint32_t rowsPerFrame = writeBakeHeader(openFile, BAKE_BONES, numBones, animation, numFrames, m_maxWidth, width);
+
+    //bytes per texel
+    openFile->write8(16);
+
+    //ranges
+    for(unsigned int component = 0; component < 3; component++) {
+        openFile->writeLF(minTranslation[component]);
+    }
+
+    for(unsigned int component = 0; component < 3; component++) {
+        openFile->writeLF(maxTranslation[component] - minTranslation[component]);
+    }
+
+    openFile->writeLF(minScale);
+    openFile->writeLF(maxScale - minScale);
+
+    //texels, with the rest of the last row of a frame left empty
+    for(uint32_t frame = 0; frame < numFrames; frame++) {
+        for(uint32_t bone = 0; bone < width * rowsPerFrame; bone++) {
+            if(bone >= numBones) {
+                for(unsigned int word = 0; word < 4; word++) {
+                    openFile->writeL32(0);
+                }
+
+                continue;
+            }
+
+            uint32_t transform = frame * numBones + bone;
+
+            uint16_t rotation[3];
+            encodeSmallestThree(&rotations[transform * 4], rotation);
+
+            uint16_t scale = encodeRange(scales[transform], minScale, maxScale - minScale);
+            uint16_t translation[3];
+
+            for(unsigned int component = 0; component < 3; component++) {
+                translation[component] = encodeRange(translations[transform * 3 + component],
+                    minTranslation[component], maxTranslation[component] - minTranslation[component]);
+            }
+
+            openFile->writeL32(rotation[0] | ((uint32_t) rotation[1] << 16));
+            openFile->writeL32(rotation[2] | ((uint32_t) scale << 16));
+            openFile->writeL32(translation[0] | ((uint32_t) translation[1] << 16));
+            openFile->writeL32(translation[2]);
+        }
+    }
+
+    delete openFile;
+
+    LOG_INFO("Baked %u bones over %u frames into %s, %u by %u texels, translation precision %f",
+        (unsigned int) numBones, numFrames, path, width, numFrames * rowsPerFrame,
+        std::max(maxTranslation[0] - minTranslation[0], std::max(maxTranslation[1] - minTranslation[1], maxTranslation[2] - minTranslation[2])) / RANGE_QUANTIZED_MAX);
+}
+
+void AnimationBaker::bakeVertices(const Animation& animation, const Skeleton& skeleton, const MeshBuffer& mesh, const char * path) const {
+    if(!(mesh.m_features & MeshFeatures::MF_BLEND_DATA)) {
+        LOG_INFO("Warning: not baking %s, the mesh has no blend data", path);
+        return;
+    }
+
+    SkinningMesh skinningMesh;
+    skinningMesh.setVertices(&mesh.m_vertices[0], mesh.m_vertexSize, mesh.m_numVertices, mesh.m_features);
+
+    uint16_t numBones = (uint16_t) skeleton.m_bones.size();
+
+    if(skinningMesh.m_maxBone >= numBones) {
+        LOG_FATAL_ERROR("The mesh uses bone %u but the skeleton only has %u bones", skinningMesh.m_maxBone, numBones);
+    }
+
+    uint32_t numFrames = animation.computeNumFrames();
+    uint32_t numVertices = mesh.m_numVertices;
+
+    std::vector<float> palettes;
+    computeFramePalettes(animation, skeleton, numFrames, palettes);
+
+    std::vector<float> positions(numFrames * numVertices * 3);
+    std::vector<float> normals(numFrames * numVertices * 3);
+
+    for(uint32_t frame = 0; frame < numFrames; frame++) {
+        skinVertices(skinningMesh, &palettes[frame * numBones * AFFINE_FLOATS], 0, numVertices,
+            &positions[frame * numVertices * 3], &normals[frame * numVertices * 3]);
+    }
+
+    float minPosition[3];
+    float maxPosition[3];
+
+    for(unsigned int component = 0; component < 3; component++) {
+        minPosition[component] = positions.empty() ? 0.0f : positions[component];
+        maxPosition[component] = minPosition[component];
+    }
+
+    for(size_t vertex = 0; vertex < numFrames * numVertices; vertex++) {
+        for(unsigned int component = 0; component < 3; component++) {
+            minPosition[component] = std::min(minPosition[component], positions[vertex * 3 + component]);
+            maxPosition[component] = std::max(maxPosition[component], positions[vertex * 3 + component]);
+        }
+    }
+
+    illFileSystem::File * openFile = illFileSystem::fileSystem->openWrite(path);
+
+    uint32_t width;
+    uint32_t rowsPerFrame = writeBakeHeader(openFile, BAKE_VERTICES, numVertices, animation, numFrames, m_maxWidth, width);
+
+    //bytes per texel
+    openFile->write8(8);
+
+    //ranges
+    for(unsigned int component = 0; component < 3; component++) {
+        openFile->writeLF(minPosition[component]);
+    }
+
+    for(unsigned int component = 0; component < 3; component++) {
+        openFile->writeLF(maxPosition[component] - minPosition[component]);
+    }
+
+    //texels, with the rest of the last row of a frame left empty
+    for(uint32_t frame = 0; frame < numFrames; frame++) {
+        for(uint32_t vertex = 0; vertex < width * rowsPerFrame; vertex++) {
+            if(vertex >= numVertices) {
+                for(unsigned int word = 0; word < 4; word++) {
+                    openFile->writeL16(0);
+                }
+
+                continue;
+            }
+
+            const float * position = &positions[(frame * numVertices + vertex) * 3];
+            const float * normal = &normals[(frame * numVertices + vertex) * 3];
+
+            for(unsigned int component = 0; component < 3; component++) {
+                openFile->writeL16(encodeRange(position[component], minPosition[component], maxPosition[component] - minPosition[component]));
+            }
+
+            openFile->writeL16(skinningMesh.m_hasNormals ? encodeOctahedron(normal[0], normal[1], normal[2]) : 0);
+        }
+    }
+
+    delete openFile;
+
+    LOG_INFO("Baked %u vertices over %u frames into %s, %u by %u texels, position precision %f",
+        numVertices, numFrames, path, width, numFrames * rowsPerFrame,
+        std::max(maxPosition[0] - minPosition[0], std::max(maxPosition[1] - minPosition[1], maxPosition[2] - minPosition[2])) / RANGE_QUANTIZED_MAX);
+}
\ No newline at end of file
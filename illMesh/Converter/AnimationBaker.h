@@ -0,0 +1,37 @@
+#ifndef ILL_CONVERTER_ANIMATION_BAKER_H_
+#define ILL_CONVERTER_ANIMATION_BAKER_H_
+
+#include <stdint.h>
+
+class Animation;
+class MeshBuffer;
+class Skeleton;
+
+/**
+Bakes an animation into a texture an instanced shader can play without evaluating the skeleton, saved as ILLBAKE0.
+Frames are sampled at the animation's save frame rate.  Each frame takes rowsPerFrame rows of the texture,
+and item i of frame f is the texel at (i % width, f * rowsPerFrame + i / width).
+
+Bone textures have one 4x32 bit texel per bone with its skinning transform, the 16 bit halves low first:
+x is the smallest three rotation words 0 and 1, y is word 2 and the uniform scale, z is translation x and y, and w is translation z.
+Scale and translation are quantized within the ranges in the header.
+
+Vertex textures have one 4x16 bit texel per vertex with its skinned position quantized within the header's range in xyz,
+and the octahedron encoded normal in w as two bytes, x in the low byte.
+*/
+class AnimationBaker {
+public:
+    AnimationBaker()
+        : m_maxWidth(4096)
+    {}
+
+    //bakes the skinning transform of every bone of the skeleton
+    void bakeBones(const Animation& animation, const Skeleton& skeleton, const char * path) const;
+
+    //bakes the skinned positions and normals of a mesh, which needs blend data
+    void bakeVertices(const Animation& animation, const Skeleton& skeleton, const MeshBuffer& mesh, const char * path) const;
+
+    uint32_t m_maxWidth;        //widest the texture can be, items of a frame go on more rows past this
+};
+
+#endif
\ No newline at end of file
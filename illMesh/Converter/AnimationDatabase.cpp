@@ -0,0 +1,170 @@
+#include <algorithm>
+
+#include "AnimationDatabase.h"
+#include "Animation.h"
+
+#include "../Runtime/MappedAnimationDatabase.h"
+
+#include "illEngine/FileSystem/FileSystem.h"
+#include "illEngine/FileSystem/File.h"
+
+#include "illEngine/Logging/logging.h"
+
+const uint64_t ANIM_DATABASE_MAGIC = 0x494C4C414E444230;		//ILLANDB0 in 64 bit big endian
+
+//clip keys start on multiples of this many bytes from the start of the file
+const uint16_t ANIM_DATABASE_ALIGNMENT = 16;
+
+const uint16_t ANIM_DATABASE_FLAG_BIND_RELATIVE = 1 << 0;
+
+inline size_t alignDatabaseOffset(size_t offset) {
+    return (offset + ANIM_DATABASE_ALIGNMENT - 1) / ANIM_DATABASE_ALIGNMENT * ANIM_DATABASE_ALIGNMENT;
+}
+
+void AnimationDatabase::add(const Animation * animation, const std::string& name) {
+    Clip clip;
+    clip.m_name = name;
+    clip.m_animation = animation;
+
+    m_clips.push_back(clip);
+}
+
+void AnimationDatabase::save(const char * path) const {
+    //the descriptors are every bone any clip has a track for, in bone index order so bone LODs still drop tracks off the end
+    std::vector<uint16_t> descriptors;
+
+    for(auto clipIter = m_clips.cbegin(); clipIter != m_clips.end(); clipIter++) {
+        const std::vector<Animation::Track>& tracks = clipIter->m_animation->m_tracks;
+
+        for(size_t track = 0; track < tracks.size(); track++) {
+            if(track > 0 && tracks[track].m_bone <= tracks[track - 1].m_bone) {
+                LOG_FATAL_ERROR("Animation %s doesn't have its tracks in bone order, it can't go in animation database %s", clipIter->m_name.c_str(), path);
+            }
+
+            descriptors.push_back(tracks[track].m_bone);
+        }
+    }
+
+    std::sort(descriptors.begin(), descriptors.end());
+    descriptors.erase(std::unique(descriptors.begin(), descriptors.end()), descriptors.end());
+
+    if(descriptors.size() > 65535) {
+        LOG_FATAL_ERROR("Animation database %s would have more than 65535 track descriptors", path);
+    }
+
+    //directory order, by name hash
+    std::vector<std::pair<uint32_t, size_t> > directory(m_clips.size());
+
+    for(size_t clip = 0; clip < m_clips.size(); clip++) {
+        directory[clip] = std::make_pair(hashAnimationName(m_clips[clip].m_name.c_str()), clip);
+    }
+
+    std::sort(directory.begin(), directory.end());
+
+    for(size_t entry = 1; entry < directory.size(); entry++) {
+        if(directory[entry].first == directory[entry - 1].first) {
+            LOG_FATAL_ERROR("Animations %s and %s have the same name hash in animation database %s, rename one of them",
+                m_clips[directory[entry - 1].second].m_name.c_str(), m_clips[directory[entry].second].m_name.c_str(), path);
+        }
+    }
+
+    //lay out the clip keys after the header, each one aligned
+    size_t maskSize = (descriptors.size() + 7) / 8;
+
+    //magic, alignment, number of descriptors, the descriptors, number of clips, names offset, and the directory
+    size_t headerSize = 8 + 2 + 2 + descriptors.size() * 2 + 4 + 4 + directory.size() * 24;
+
+    std::vector<size_t> offsets(directory.size());
+    std::vector<size_t> sizes(directory.size());
+    size_t offset = headerSize;
+
+    for(size_t entry = 0; entry < directory.size(); entry++) {
+        offset = alignDatabaseOffset(offset);
+
+        offsets[entry] = offset;
+        sizes[entry] = maskSize + m_clips[directory[entry].second].m_animation->computeQuantizedTracksSize();
+        offset += sizes[entry];
+    }
+
+    size_t namesOffset = offset;
+
+    illFileSystem::File * openFile = illFileSystem::fileSystem->openWrite(path);
+
+    //write magic number
+    openFile->writeB64(ANIM_DATABASE_MAGIC);
+
+    openFile->writeL16(ANIM_DATABASE_ALIGNMENT);
+
+    //the track descriptors
+    openFile->writeL16((uint16_t) descriptors.size());
+
+    for(auto iter = descriptors.cbegin(); iter != descriptors.end(); iter++) {
+        openFile->writeL16(*iter);
+    }
+
+    //the directory
+    openFile->writeL32((uint32_t) directory.size());
+    openFile->writeL32((uint32_t) namesOffset);
+
+    for(size_t entry = 0; entry < directory.size(); entry++) {
+        const Animation& animation = *m_clips[directory[entry].second].m_animation;
+
+        openFile->writeL32(directory[entry].first);
+        openFile->writeL32((uint32_t) offsets[entry]);
+        openFile->writeL32((uint32_t) sizes[entry]);
+        openFile->writeLF(animation.m_duration);
+        openFile->writeLF(animation.getSaveFrameRate());
+        openFile->writeL16(animation.m_bindRelative ? ANIM_DATABASE_FLAG_BIND_RELATIVE : 0);
+        openFile->writeL16((uint16_t) animation.m_tracks.size());
+    }
+
+    //the clips
+    size_t written = headerSize;
+    uint32_t numDropped = 0;
+    float maxErrors[Animation::NUM_CHANNELS] = {0.0f, 0.0f, 0.0f};
+    size_t separateSize = 0;
+
+    std::vector<uint8_t> mask(maskSize);
+
+    for(size_t entry = 0; entry < directory.size(); entry++) {
+        const Animation& animation = *m_clips[directory[entry].second].m_animation;
+
+        for(; written < offsets[entry]; written++) {
+            openFile->write8(0);
+        }
+
+        //which descriptors the clip has tracks for
+        std::fill(mask.begin(), mask.end(), 0);
+
+        for(auto trackIter = animation.m_tracks.cbegin(); trackIter != animation.m_tracks.end(); trackIter++) {
+            size_t descriptor = std::lower_bound(descriptors.begin(), descriptors.end(), trackIter->m_bone) - descriptors.begin();
+            mask[descriptor >> 3] |= (uint8_t) (1 << (descriptor & 7));
+        }
+
+        for(auto iter = mask.cbegin(); iter != mask.end(); iter++) {
+            openFile->write8(*iter);
+        }
+
+        numDropped += animation.writeQuantizedTracks(openFile, maxErrors);
+        written += sizes[entry];
+
+        separateSize += animation.computeSaveSize(1);
+    }
+
+    //the names in directory order, for tools
+    for(size_t entry = 0; entry < directory.size(); entry++) {
+        openFile->writeString(m_clips[directory[entry].second].m_name.c_str());
+    }
+
+    delete openFile;
+
+    if(numDropped > 0) {
+        LOG_INFO("Warning: dropped %u keys in animation database %s that landed on the same frame", numDropped, path);
+    }
+
+    LOG_INFO("Animation database %s max error: position %f, rotation %f degrees, scale %f", path,
+        maxErrors[Animation::CHANNEL_POSITION], maxErrors[Animation::CHANNEL_ROTATION] * 180.0f / 3.14159265f, maxErrors[Animation::CHANNEL_SCALE]);
+
+    LOG_INFO("Saved animation database %s with %u clips and %u track descriptors, %u bytes of keys, %u bytes as separate version 1 files", path,
+        (unsigned int) directory.size(), (unsigned int) descriptors.size(), (unsigned int) namesOffset, (unsigned int) separateSize);
+}
\ No newline at end of file
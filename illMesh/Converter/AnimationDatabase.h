@@ -0,0 +1,29 @@
+#ifndef ILL_CONVERTER_ANIMATION_DATABASE_H_
+#define ILL_CONVERTER_ANIMATION_DATABASE_H_
+
+#include <string>
+#include <vector>
+
+class Animation;
+
+/**
+Saves many animations together as one ILLANDB0 file, so a character's whole move set loads with one file open or memory map.
+The bones are stored once in a table of track descriptors shared by every clip, and clips are found by the hash of their name.
+Runtime/MappedAnimationDatabase.h reads the file.
+*/
+class AnimationDatabase {
+public:
+    struct Clip {
+        std::string m_name;
+        const Animation * m_animation;
+    };
+
+    //adds a clip, the animation needs to stay around until the database is saved
+    void add(const Animation * animation, const std::string& name);
+
+    void save(const char * path) const;
+
+    std::vector<Clip> m_clips;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include <algorithm>
+
+#include "BoneInfluences.h"
+
+#include "illEngine/Logging/logging.h"
+
+void BoneInfluences::reset(unsigned int numVertices) {
+    m_numVertices = numVertices;
+
+    m_bones.assign(numVertices * MAX_INFLUENCES, 0);
+    m_weights.assign(numVertices * MAX_INFLUENCES, 0.0f);
+    m_sourceCounts.assign(numVertices, 0);
+
+    m_numOverflowVertices = 0;
+    m_maxDroppedWeight = 0.0f;
+}
+
+void BoneInfluences::add(unsigned int vertex, uint16_t bone, float weight) {
+    if(weight <= 0.0f) {
+        return;
+    }
+
+    if(m_sourceCounts[vertex] < 0xFF) {
+        m_sourceCounts[vertex]++;
+    }
+
+    uint16_t * bones = &m_bones[vertex * MAX_INFLUENCES];
+    float * weights = &m_weights[vertex * MAX_INFLUENCES];
+
+    //all slots are taken by stronger influences
+    if(weight <= weights[MAX_INFLUENCES - 1]) {
+        m_maxDroppedWeight = std::max(m_maxDroppedWeight, weight);
+        return;
+    }
+
+    //the weakest one falls out the end
+    m_maxDroppedWeight = std::max(m_maxDroppedWeight, weights[MAX_INFLUENCES - 1]);
+
+    unsigned int slot = MAX_INFLUENCES - 1;
+
+    while(slot > 0 && weights[slot - 1] < weight) {
+        bones[slot] = bones[slot - 1];
+        weights[slot] = weights[slot - 1];
+        slot--;
+    }
+
+    bones[slot] = bone;
+    weights[slot] = weight;
+}
+
+void BoneInfluences::finish(const char * meshName) {
+    m_numOverflowVertices = 0;
+
+    for(unsigned int vertex = 0; vertex < m_numVertices; vertex++) {
+        if(m_sourceCounts[vertex] <= MAX_INFLUENCES) {
+            continue;
+        }
+
+        m_numOverflowVertices++;
+
+        switch(m_overflowPolicy) {
+        case OverflowPolicy::FAIL:
+            LOG_FATAL_ERROR("Vertex %u of mesh %s has %u bone influences, only %u are supported", vertex, meshName, m_sourceCounts[vertex], MAX_INFLUENCES);
+            break;
+
+        case OverflowPolicy::RENORMALIZE: {
+                float * weights = &m_weights[vertex * MAX_INFLUENCES];
+                float total = 0.0f;
+
+                for(unsigned int slot = 0; slot < MAX_INFLUENCES; slot++) {
+                    total += weights[slot];
+                }
+
+                for(unsigned int slot = 0; slot < MAX_INFLUENCES; slot++) {
+                    weights[slot] /= total;
+                }
+            } break;
+
+        case OverflowPolicy::DROP:
+            break;
+        }
+    }
+
+    if(m_numOverflowVertices > 0) {
+        LOG_INFO("Warning: %u vertices of mesh %s have more than %u bone influences, dropped the weakest ones%s.  The strongest dropped weight was %f",
+            m_numOverflowVertices, meshName, MAX_INFLUENCES,
+            m_overflowPolicy == OverflowPolicy::RENORMALIZE ? " and renormalized" : "",
+            m_maxDroppedWeight);
+    }
+}
+
+void BoneInfluences::remapBones(const std::vector<uint16_t>& remap) {
+    for(unsigned int vertex = 0; vertex < m_numVertices; vertex++) {
+        uint16_t * bones = &m_bones[vertex * MAX_INFLUENCES];
+        float * weights = &m_weights[vertex * MAX_INFLUENCES];
+
+        //merge into the first slot with the same bone
+        for(unsigned int slot = 0; slot < MAX_INFLUENCES; slot++) {
+            if(weights[slot] <= 0.0f) {
+                continue;
+            }
+
+            bones[slot] = remap[bones[slot]];
+
+            for(unsigned int prevSlot = 0; prevSlot < slot; prevSlot++) {
+                if(weights[prevSlot] > 0.0f && bones[prevSlot] == bones[slot]) {
+                    weights[prevSlot] += weights[slot];
+                    weights[slot] = 0.0f;
+                    break;
+                }
+            }
+        }
+
+        //sort strongest first again, emptied slots go to the end
+        for(unsigned int slot = 1; slot < MAX_INFLUENCES; slot++) {
+            uint16_t bone = bones[slot];
+            float weight = weights[slot];
+            unsigned int insertSlot = slot;
+
+            while(insertSlot > 0 && weights[insertSlot - 1] < weight) {
+                bones[insertSlot] = bones[insertSlot - 1];
+                weights[insertSlot] = weights[insertSlot - 1];
+                insertSlot--;
+            }
+
+            bones[insertSlot] = bone;
+            weights[insertSlot] = weight;
+        }
+
+        for(unsigned int slot = 0; slot < MAX_INFLUENCES; slot++) {
+            if(weights[slot] <= 0.0f) {
+                bones[slot] = 0;
+            }
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef ILL_CONVERTER_BONE_INFLUENCES_H_
+#define ILL_CONVERTER_BONE_INFLUENCES_H_
+
+#include <stdint.h>
+#include <vector>
+
+/**
+The bone weights of every vertex in a mesh as flat arrays with a fixed number of slots per vertex.
+The slots of a vertex are kept sorted strongest first, unused slots have bone 0 and weight 0.
+If a vertex has more influences than there are slots the weakest ones are dropped and the overflow policy decides what happens after.
+*/
+class BoneInfluences {
+public:
+    static const unsigned int MAX_INFLUENCES = 4;     //same as the number of blend slots in the mesh vertex format
+
+    enum class OverflowPolicy {
+        RENORMALIZE,        //drop the weakest influences and scale the rest so they add up to 1 again
+        DROP,               //drop the weakest influences and leave the rest alone
+        FAIL                //stop with an error
+    };
+
+    BoneInfluences()
+        : m_numVertices(0),
+        m_overflowPolicy(OverflowPolicy::RENORMALIZE),
+        m_numOverflowVertices(0),
+        m_maxDroppedWeight(0.0f)
+    {}
+
+    //clears everything and makes room for the vertices
+    void reset(unsigned int numVertices);
+
+    //adds an influence to a vertex, a vertex should only get each bone once
+    void add(unsigned int vertex, uint16_t bone, float weight);
+
+    //applies the overflow policy to vertices that lost influences and reports them
+    void finish(const char * meshName);
+
+    /**
+    Moves every influence to the bone remap gives for its bone, adding up the weights of influences that end up on the same bone.
+    The slots stay sorted strongest first.
+    */
+    void remapBones(const std::vector<uint16_t>& remap);
+
+    inline uint16_t getBone(unsigned int vertex, unsigned int slot) const {
+        return m_bones[vertex * MAX_INFLUENCES + slot];
+    }
+
+    inline float getWeight(unsigned int vertex, unsigned int slot) const {
+        return m_weights[vertex * MAX_INFLUENCES + slot];
+    }
+
+    //number of slots with weight in them
+    inline uint8_t getNumInfluences(unsigned int vertex) const {
+        uint8_t count = 0;
+
+        while(count < MAX_INFLUENCES && getWeight(vertex, count) > 0.0f) {
+            count++;
+        }
+
+        return count;
+    }
+
+    unsigned int m_numVertices;
+
+    std::vector<uint16_t> m_bones;          //MAX_INFLUENCES per vertex
+    std::vector<float> m_weights;           //MAX_INFLUENCES per vertex
+    std::vector<uint8_t> m_sourceCounts;    //number of influences each vertex was given, including dropped ones
+
+    OverflowPolicy m_overflowPolicy;
+
+    unsigned int m_numOverflowVertices;
+    float m_maxDroppedWeight;
+};
+
+#endif
@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <cstring>
+
+#include "BoneRegistry.h"
+
+#include "illEngine/Logging/logging.h"
+
+const uint16_t BoneRegistry::NOT_FOUND;
+
+uint32_t BoneRegistry::hashName(const char * name, uint32_t seed) {
+    uint32_t hash = seed;
+
+    for(const unsigned char * curr = (const unsigned char *) name; *curr; curr++) {
+        hash ^= *curr;
+        hash *= 0x01000193;
+    }
+
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6B;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35;
+    hash ^= hash >> 16;
+
+    return hash;
+}
+
+uint16_t BoneRegistry::findPerfectHash(const char * name, const uint32_t * seeds, uint16_t numBuckets, const uint16_t * slots, uint16_t numBones) {
+    if(numBones == 0) {
+        return NOT_FOUND;
+    }
+
+    uint32_t seed = seeds[hashName(name) % numBuckets];
+
+    return slots[hashName(name, seed) % numBones];
+}
+
+uint16_t BoneRegistry::find(const char * name) const {
+    if(m_table.empty()) {
+        return NOT_FOUND;
+    }
+
+    uint32_t hash = hashName(name);
+    size_t mask = m_table.size() - 1;
+
+    for(size_t slot = hash & mask; m_table[slot] != NOT_FOUND; slot = (slot + 1) & mask) {
+        uint16_t bone = m_table[slot];
+
+        if(m_hashes[bone] == hash && strcmp(m_names[bone].c_str(), name) == 0) {
+            return bone;
+        }
+    }
+
+    return NOT_FOUND;
+}
+
+uint16_t BoneRegistry::at(const char * name) const {
+    uint16_t bone = find(name);
+
+    if(bone == NOT_FOUND) {
+        LOG_FATAL_ERROR("Bone %s isn't in the animset", name);
+    }
+
+    return bone;
+}
+
+uint16_t BoneRegistry::insert(const char * name) {
+    uint16_t bone = find(name);
+
+    if(bone != NOT_FOUND) {
+        return bone;
+    }
+
+    if(m_names.size() >= NOT_FOUND) {
+        LOG_FATAL_ERROR("Too many bones, at most %u are supported", (unsigned int) NOT_FOUND);
+    }
+
+    bone = (uint16_t) m_names.size();
+    m_names.push_back(name);
+    m_hashes.push_back(hashName(name));
+
+    //keep the table at most half full
+    if(m_names.size() * 2 > m_table.size()) {
+        rebuildTable(m_table.empty() ? 64 : m_table.size() * 2);
+    }
+    else {
+        size_t mask = m_table.size() - 1;
+        size_t slot = m_hashes[bone] & mask;
+
+        while(m_table[slot] != NOT_FOUND) {
+            slot = (slot + 1) & mask;
+        }
+
+        m_table[slot] = bone;
+    }
+
+    return bone;
+}
+
+void BoneRegistry::clear() {
+    m_names.clear();
+    m_hashes.clear();
+    m_table.clear();
+}
+
+void BoneRegistry::remap(const std::vector<uint16_t>& remap) {
+    std::vector<std::string> names;
+    std::vector<uint32_t> hashes;
+
+    for(size_t bone = 0; bone < m_names.size(); bone++) {
+        if(remap[bone] == NOT_FOUND) {
+            continue;
+        }
+
+        if(remap[bone] >= names.size()) {
+            names.resize(remap[bone] + 1);
+            hashes.resize(remap[bone] + 1);
+        }
+
+        names[remap[bone]].swap(m_names[bone]);
+        hashes[remap[bone]] = m_hashes[bone];
+    }
+
+    m_names.swap(names);
+    m_hashes.swap(hashes);
+
+    rebuildTable(m_table.size());
+}
+
+void BoneRegistry::rebuildTable(size_t capacity) {
+    m_table.assign(capacity, NOT_FOUND);
+
+    if(capacity == 0) {
+        return;
+    }
+
+    size_t mask = capacity - 1;
+
+    for(size_t bone = 0; bone < m_names.size(); bone++) {
+        size_t slot = m_hashes[bone] & mask;
+
+        while(m_table[slot] != NOT_FOUND) {
+            slot = (slot + 1) & mask;
+        }
+
+        m_table[slot] = (uint16_t) bone;
+    }
+}
+
+//average names per bucket, fewer means a bigger seed table but seeds are found faster
+const unsigned int NAMES_PER_BUCKET = 4;
+const uint32_t MAX_SEED_TRIES = 0x100000;
+
+void BoneRegistry::buildPerfectHash(std::vector<uint32_t>& seeds, std::vector<uint16_t>& slots) const {
+    uint16_t numBones = (uint16_t) m_names.size();
+    uint16_t numBuckets = (uint16_t) std::max((numBones + NAMES_PER_BUCKET - 1) / NAMES_PER_BUCKET, 1u);
+
+    seeds.assign(numBuckets, 0);
+    slots.assign(numBones, NOT_FOUND);
+
+    std::vector<std::vector<uint16_t> > buckets(numBuckets);
+
+    for(uint16_t bone = 0; bone < numBones; bone++) {
+        buckets[m_hashes[bone] % numBuckets].push_back(bone);
+    }
+
+    //biggest buckets first while there are still lots of free slots
+    std::vector<uint16_t> bucketOrder(numBuckets);
+
+    for(uint16_t bucket = 0; bucket < numBuckets; bucket++) {
+        bucketOrder[bucket] = bucket;
+    }
+
+    std::stable_sort(bucketOrder.begin(), bucketOrder.end(), [&buckets] (uint16_t left, uint16_t right) {
+        return buckets[left].size() > buckets[right].size();
+    });
+
+    std::vector<uint16_t> bucketSlots;
+
+    for(auto bucketIter = bucketOrder.cbegin(); bucketIter != bucketOrder.end(); bucketIter++) {
+        const std::vector<uint16_t>& bucket = buckets[*bucketIter];
+
+        if(bucket.empty()) {
+            break;
+        }
+
+        //try seeds until all names in the bucket land in different free slots
+        bool placed = false;
+
+        for(uint32_t seed = 1; seed < MAX_SEED_TRIES && !placed; seed++) {
+            bucketSlots.clear();
+            placed = true;
+
+            for(auto boneIter = bucket.cbegin(); boneIter != bucket.end(); boneIter++) {
+                uint16_t slot = (uint16_t) (hashName(m_names[*boneIter].c_str(), seed) % numBones);
+
+                if(slots[slot] != NOT_FOUND || std::find(bucketSlots.begin(), bucketSlots.end(), slot) != bucketSlots.end()) {
+                    placed = false;
+                    break;
+                }
+
+                bucketSlots.push_back(slot);
+            }
+
+            if(placed) {
+                seeds[*bucketIter] = seed;
+
+                for(size_t name = 0; name < bucket.size(); name++) {
+                    slots[bucketSlots[name]] = bucket[name];
+                }
+            }
+        }
+
+        if(!placed) {
+            LOG_FATAL_ERROR("Couldn't build a perfect hash table for the bone names");
+        }
+    }
+}
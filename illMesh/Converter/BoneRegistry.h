@@ -0,0 +1,75 @@
+#ifndef ILL_CONVERTER_BONE_REGISTRY_H_
+#define ILL_CONVERTER_BONE_REGISTRY_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+Bone names and their indices.
+Each name is stored once, the bone index is the position in m_names.
+Lookups go through a flat open addressing table hashed with hashName, so there's no tree walking and string compares only happen on a hash match.
+The same hash is used for the perfect hash table saved in version 1 animset files so the engine can look up bones the same way.
+*/
+class BoneRegistry {
+public:
+    static const uint16_t NOT_FOUND = 0xFFFF;
+
+    /**
+    FNV-1a 32 bit followed by the murmur3 finalizer so the low bits are usable as a table index.
+    Anything reading the animset hash table has to match this exactly.
+    */
+    static uint32_t hashName(const char * name, uint32_t seed = 0x811C9DC5);
+
+    /**
+    The bone index a name has in a minimal perfect hash table built by buildPerfectHash.
+    Names that aren't bones also land on some bone so the caller still has to compare the name at the returned index.
+    Doesn't allocate so it works straight off the memory mapped table in an animset file.
+    */
+    static uint16_t findPerfectHash(const char * name, const uint32_t * seeds, uint16_t numBuckets, const uint16_t * slots, uint16_t numBones);
+
+    inline size_t size() const {
+        return m_names.size();
+    }
+
+    inline bool empty() const {
+        return m_names.empty();
+    }
+
+    inline const std::string& getName(uint16_t bone) const {
+        return m_names[bone];
+    }
+
+    //index of the bone with the name, NOT_FOUND if it's not there
+    uint16_t find(const char * name) const;
+
+    //index of the bone with the name, a fatal error if it's not there
+    uint16_t at(const char * name) const;
+
+    //index of the bone with the name, adds it to the end if it's not there yet
+    uint16_t insert(const char * name);
+
+    void clear();
+
+    /**
+    Renumbers the bones.
+    @param remap The new index for every current bone index, NOT_FOUND to remove the bone.  The new indices have to be 0 to the number of bones kept.
+    */
+    void remap(const std::vector<uint16_t>& remap);
+
+    void rebuildTable(size_t capacity);
+
+    /**
+    Builds a minimal perfect hash over the names, hash and displace style.
+    A name goes in bucket hashName(name) % numBuckets and then in slot hashName(name, seeds[bucket]) % size().
+    Every name ends up in its own slot, slots[slot] is the bone index in that slot.
+    */
+    void buildPerfectHash(std::vector<uint32_t>& seeds, std::vector<uint16_t>& slots) const;
+
+    std::vector<std::string> m_names;
+
+    std::vector<uint16_t> m_table;      //bone index per slot, NOT_FOUND for empty slots, size is a power of 2
+    std::vector<uint32_t> m_hashes;     //hash of each name, saves rehashing when the table grows
+};
+
+#endif
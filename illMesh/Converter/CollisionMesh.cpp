@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <map>
+
+#include "CollisionMesh.h"
+#include "Mesh.h"
+#include "AnimSet.h"
+
+#include "illEngine/FileSystem/FileSystem.h"
+#include "illEngine/FileSystem/File.h"
+#include "illEngine/Logging/logging.h"
+
+const uint64_t COLLISION_MAGIC = 0x494C4C434F4C4C30;	//ILLCOLL0 in 64 bit big endian
+
+//only split a static hull if the pieces together are this much smaller, otherwise the split didn't cut away enough empty space
+const float SPLIT_VOLUME_RATIO = 0.85f;
+
+struct HullCluster {
+    std::vector<unsigned int> m_faces;
+    ConvexHull m_hull;
+    float m_volume;
+    bool m_final;
+};
+
+//builds the hull of all the vertices the faces use, each vertex only once
+bool buildClusterHull(const aiMesh * mesh, HullCluster& cluster, unsigned int maxHullVertices) {
+    std::vector<bool> used(mesh->mNumVertices, false);
+    std::vector<glm::vec3> points;
+
+    for(auto faceIter = cluster.m_faces.cbegin(); faceIter != cluster.m_faces.end(); faceIter++) {
+        const aiFace& currFace = mesh->mFaces[*faceIter];
+
+        for(unsigned int corner = 0; corner < currFace.mNumIndices; corner++) {
+            unsigned int vertex = currFace.mIndices[corner];
+
+            if(!used[vertex]) {
+                used[vertex] = true;
+                points.push_back(glm::vec3(mesh->mVertices[vertex].x, mesh->mVertices[vertex].y, mesh->mVertices[vertex].z));
+            }
+        }
+    }
+
+    cluster.m_final = false;
+
+    if(!cluster.m_hull.build(points, maxHullVertices)) {
+        cluster.m_volume = 0.0f;
+        return false;
+    }
+
+    cluster.m_volume = cluster.m_hull.computeVolume();
+    return true;
+}
+
+glm::vec3 faceCentroid(const aiMesh * mesh, unsigned int face) {
+    const aiFace& currFace = mesh->mFaces[face];
+    glm::vec3 centroid(0.0f);
+
+    for(unsigned int corner = 0; corner < currFace.mNumIndices; corner++) {
+        const aiVector3D& position = mesh->mVertices[currFace.mIndices[corner]];
+        centroid += glm::vec3(position.x, position.y, position.z);
+    }
+
+    return centroid / (float) std::max(currFace.mNumIndices, 1u);
+}
+
+void importSkinnedHulls(CollisionMesh& collision, const Mesh * mesh, const AnimSet * animset) {
+    const aiMesh * sourceMesh = mesh->m_mesh;
+
+    //the offset matrix of each bone takes mesh space to bone space
+    std::map<uint16_t, const aiBone *> bones;
+
+    for(unsigned int bone = 0; bone < sourceMesh->mNumBones; bone++) {
+        bones[animset->m_boneRegistry.at(sourceMesh->mBones[bone]->mName.data)] = sourceMesh->mBones[bone];
+    }
+
+    //sort the vertices by the bone with the most influence on them
+    std::map<uint16_t, std::vector<glm::vec3> > bonePoints;
+
+    for(unsigned int vertex = 0; vertex < sourceMesh->mNumVertices; vertex++) {
+        //the influences are sorted strongest first
+        if(mesh->m_boneInfluences.getWeight(vertex, 0) <= 0.0f) {
+            continue;
+        }
+
+        uint16_t dominant = mesh->m_boneInfluences.getBone(vertex, 0);
+
+        aiVector3D bonePosition = bones.at(dominant)->mOffsetMatrix * sourceMesh->mVertices[vertex];
+        bonePoints[dominant].push_back(glm::vec3(bonePosition.x, bonePosition.y, bonePosition.z));
+    }
+
+    for(auto iter = bonePoints.cbegin(); iter != bonePoints.end(); iter++) {
+        CollisionMesh::Hull hull;
+        hull.m_boneIndex = iter->first;
+
+        if(hull.m_hull.build(iter->second, collision.m_maxHullVertices)) {
+            collision.m_hulls.push_back(hull);
+        }
+        else {
+            LOG_INFO("Bone %u of mesh %s doesn't have enough vertices around it for a collision hull", iter->first, sourceMesh->mName.data);
+        }
+    }
+}
+
+void importStaticHulls(CollisionMesh& collision, const Mesh * mesh) {
+    const aiMesh * sourceMesh = mesh->m_mesh;
+
+    std::vector<HullCluster> clusters(1);
+
+    for(unsigned int face = 0; face < sourceMesh->mNumFaces; face++) {
+        clusters[0].m_faces.push_back(face);
+    }
+
+    if(!buildClusterHull(sourceMesh, clusters[0], collision.m_maxHullVertices)) {
+        LOG_INFO("Mesh %s is flat, no collision hull", sourceMesh->mName.data);
+        return;
+    }
+
+    //keep splitting the biggest hull in half along its longest side while that cuts away enough empty space
+    while(clusters.size() < collision.m_maxStaticHulls) {
+        size_t biggest = clusters.size();
+
+        for(size_t cluster = 0; cluster < clusters.size(); cluster++) {
+            if(!clusters[cluster].m_final && (biggest == clusters.size() || clusters[cluster].m_volume > clusters[biggest].m_volume)) {
+                biggest = cluster;
+            }
+        }
+
+        if(biggest == clusters.size()) {
+            break;
+        }
+
+        HullCluster& parent = clusters[biggest];
+
+        if(parent.m_faces.size() < 2) {
+            parent.m_final = true;
+            continue;
+        }
+
+        //split the faces at the median centroid along the longest axis of the centroid bounds
+        std::vector<std::pair<float, unsigned int> > sortedFaces;
+        unsigned int splitAxis = 0;
+
+        {
+            glm::vec3 boundsMin = faceCentroid(sourceMesh, parent.m_faces[0]);
+            glm::vec3 boundsMax = boundsMin;
+
+            for(auto faceIter = parent.m_faces.cbegin(); faceIter != parent.m_faces.end(); faceIter++) {
+                glm::vec3 centroid = faceCentroid(sourceMesh, *faceIter);
+
+                boundsMin = glm::min(boundsMin, centroid);
+                boundsMax = glm::max(boundsMax, centroid);
+            }
+
+            glm::vec3 extent = boundsMax - boundsMin;
+
+            if(extent.y > extent[splitAxis]) {
+                splitAxis = 1;
+            }
+
+            if(extent.z > extent[splitAxis]) {
+                splitAxis = 2;
+            }
+
+            for(auto faceIter = parent.m_faces.cbegin(); faceIter != parent.m_faces.end(); faceIter++) {
+                sortedFaces.push_back(std::make_pair(faceCentroid(sourceMesh, *faceIter)[splitAxis], *faceIter));
+            }
+        }
+
+        std::sort(sortedFaces.begin(), sortedFaces.end());
+
+        HullCluster children[2];
+        size_t half = sortedFaces.size() / 2;
+
+        for(size_t face = 0; face < sortedFaces.size(); face++) {
+            children[face < half ? 0 : 1].m_faces.push_back(sortedFaces[face].second);
+        }
+
+        if(!buildClusterHull(sourceMesh, children[0], collision.m_maxHullVertices)
+                || !buildClusterHull(sourceMesh, children[1], collision.m_maxHullVertices)
+                || children[0].m_volume + children[1].m_volume > parent.m_volume * SPLIT_VOLUME_RATIO) {
+            parent.m_final = true;
+            continue;
+        }
+
+        parent = children[0];
+        clusters.push_back(children[1]);
+    }
+
+    for(auto iter = clusters.cbegin(); iter != clusters.end(); iter++) {
+        CollisionMesh::Hull hull;
+        hull.m_boneIndex = CollisionMesh::NO_BONE;
+        hull.m_hull = iter->m_hull;
+
+        collision.m_hulls.push_back(hull);
+    }
+}
+
+void CollisionMesh::import(const Mesh * mesh, const AnimSet * animset) {
+    m_hulls.clear();
+
+    if(!mesh->m_mesh->HasPositions()) {
+        return;
+    }
+
+    if(mesh->m_mesh->HasBones()) {
+        importSkinnedHulls(*this, mesh, animset);
+    }
+    else {
+        importStaticHulls(*this, mesh);
+    }
+
+    LOG_INFO("Collision for mesh %s has %u hulls", mesh->m_mesh->mName.data, (unsigned int) m_hulls.size());
+}
+
+void CollisionMesh::save(const char * path) const {
+    illFileSystem::File * openFile = illFileSystem::fileSystem->openWrite(path);
+
+    //write magic string
+    openFile->writeB64(COLLISION_MAGIC);
+
+    openFile->writeL16((uint16_t) m_hulls.size());
+
+    for(auto hullIter = m_hulls.cbegin(); hullIter != m_hulls.end(); hullIter++) {
+        //bone the hull is attached to
+        openFile->writeL16(hullIter->m_boneIndex);
+
+        //corner points
+        openFile->writeL16((uint16_t) hullIter->m_hull.m_vertices.size());
+
+        for(auto iter = hullIter->m_hull.m_vertices.cbegin(); iter != hullIter->m_hull.m_vertices.end(); iter++) {
+            openFile->writeLF(iter->x);
+            openFile->writeLF(iter->y);
+            openFile->writeLF(iter->z);
+        }
+
+        //face planes
+        openFile->writeL16((uint16_t) hullIter->m_hull.m_planes.size());
+
+        for(auto iter = hullIter->m_hull.m_planes.cbegin(); iter != hullIter->m_hull.m_planes.end(); iter++) {
+            openFile->writeLF(iter->m_normal.x);
+            openFile->writeLF(iter->m_normal.y);
+            openFile->writeLF(iter->m_normal.z);
+            openFile->writeLF(iter->m_distance);
+        }
+    }
+
+    delete openFile;
+}
\ No newline at end of file
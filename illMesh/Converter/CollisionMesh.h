@@ -0,0 +1,41 @@
+#ifndef ILL_CONVERTER_COLLISION_MESH_H_
+#define ILL_CONVERTER_COLLISION_MESH_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "ConvexHull.h"
+
+class AnimSet;
+class Mesh;
+
+/**
+Convex collision proxies for a mesh, meant for physics and hit detection instead of the render triangles.
+
+Skinned meshes get one hull per bone out of the vertices that bone has the most weight on, in that bone's space, for ragdolls and hitboxes.
+Static meshes get a small set of hulls from an approximate convex decomposition.
+*/
+class CollisionMesh {
+public:
+    struct Hull {
+        uint16_t m_boneIndex;       //NO_BONE for static hulls
+        ConvexHull m_hull;
+    };
+
+    static const uint16_t NO_BONE = 0xFFFF;
+
+    CollisionMesh()
+        : m_maxStaticHulls(4),
+        m_maxHullVertices(32)
+    {}
+
+    void import(const Mesh * mesh, const AnimSet * animset);
+    void save(const char * path) const;
+
+    unsigned int m_maxStaticHulls;
+    unsigned int m_maxHullVertices;
+
+    std::vector<Hull> m_hulls;
+};
+
+#endif
\ No newline at end of file
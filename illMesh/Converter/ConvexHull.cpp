@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <utility>
+
+#include "ConvexHull.h"
+
+const float PLANE_EPSILON = 1e-5f;         //relative to the size of the point cloud
+const float PLANE_MERGE_COS = 0.9999f;     //normals closer than this are treated as the same face plane
+
+struct HullFace {
+    unsigned int m_vertices[3];
+    glm::vec3 m_normal;
+    float m_distance;
+    bool m_alive;
+};
+
+HullFace makeFace(const std::vector<glm::vec3>& points, unsigned int vert0, unsigned int vert1, unsigned int vert2) {
+    HullFace face;
+    face.m_vertices[0] = vert0;
+    face.m_vertices[1] = vert1;
+    face.m_vertices[2] = vert2;
+    face.m_normal = glm::normalize(glm::cross(points[vert1] - points[vert0], points[vert2] - points[vert0]));
+    face.m_distance = -glm::dot(face.m_normal, points[vert0]);
+    face.m_alive = true;
+
+    return face;
+}
+
+//picks the extreme point in each of numDirections directions spread over a sphere with the golden angle spiral
+void reducePoints(const std::vector<glm::vec3>& points, unsigned int numDirections, std::vector<glm::vec3>& reduced) {
+    std::set<size_t> picked;
+    const float GOLDEN_ANGLE = 2.39996323f;
+
+    for(unsigned int direction = 0; direction < numDirections; direction++) {
+        float z = 1.0f - 2.0f * (direction + 0.5f) / numDirections;
+        float radius = sqrt(std::max(0.0f, 1.0f - z * z));
+        float angle = GOLDEN_ANGLE * direction;
+
+        glm::vec3 dir(radius * cos(angle), radius * sin(angle), z);
+
+        size_t best = 0;
+        float bestDot = glm::dot(points[0], dir);
+
+        for(size_t point = 1; point < points.size(); point++) {
+            float currDot = glm::dot(points[point], dir);
+
+            if(currDot > bestDot) {
+                bestDot = currDot;
+                best = point;
+            }
+        }
+
+        picked.insert(best);
+    }
+
+    reduced.clear();
+
+    for(auto iter = picked.cbegin(); iter != picked.end(); iter++) {
+        reduced.push_back(points[*iter]);
+    }
+}
+
+bool ConvexHull::build(const std::vector<glm::vec3>& inputPoints, unsigned int maxVertices) {
+    m_vertices.clear();
+    m_triangles.clear();
+    m_planes.clear();
+
+    if(inputPoints.size() < 4) {
+        return false;
+    }
+
+    std::vector<glm::vec3> points;
+
+    if(inputPoints.size() > maxVertices) {
+        reducePoints(inputPoints, maxVertices, points);
+    }
+    else {
+        points = inputPoints;
+    }
+
+    //scale the epsilon to the size of the cloud
+    glm::vec3 boundsMin = points[0];
+    glm::vec3 boundsMax = points[0];
+
+    for(size_t point = 1; point < points.size(); point++) {
+        boundsMin = glm::min(boundsMin, points[point]);
+        boundsMax = glm::max(boundsMax, points[point]);
+    }
+
+    float epsilon = PLANE_EPSILON * std::max(glm::length(boundsMax - boundsMin), 1e-6f);
+
+    //initial tetrahedron out of extreme points
+    unsigned int tetra[4] = {0, 0, 0, 0};
+
+    for(unsigned int point = 1; point < points.size(); point++) {
+        if(points[point].x < points[tetra[0]].x) {
+            tetra[0] = point;
+        }
+
+        if(points[point].x > points[tetra[1]].x) {
+            tetra[1] = point;
+        }
+    }
+
+    //if everything lines up on x, search for the farthest point from the first instead
+    if(points[tetra[1]].x - points[tetra[0]].x <= epsilon) {
+        float bestDistance = 0.0f;
+
+        for(unsigned int point = 0; point < points.size(); point++) {
+            float distance = glm::length(points[point] - points[tetra[0]]);
+
+            if(distance > bestDistance) {
+                bestDistance = distance;
+                tetra[1] = point;
+            }
+        }
+
+        if(bestDistance <= epsilon) {
+            return false;
+        }
+    }
+
+    {
+        glm::vec3 lineDir = glm::normalize(points[tetra[1]] - points[tetra[0]]);
+        float bestDistance = 0.0f;
+
+        for(unsigned int point = 0; point < points.size(); point++) {
+            glm::vec3 offset = points[point] - points[tetra[0]];
+            float distance = glm::length(offset - lineDir * glm::dot(offset, lineDir));
+
+            if(distance > bestDistance) {
+                bestDistance = distance;
+                tetra[2] = point;
+            }
+        }
+
+        if(bestDistance <= epsilon) {
+            return false;
+        }
+    }
+
+    {
+        HullFace base = makeFace(points, tetra[0], tetra[1], tetra[2]);
+        float bestDistance = 0.0f;
+
+        for(unsigned int point = 0; point < points.size(); point++) {
+            float distance = fabs(glm::dot(base.m_normal, points[point]) + base.m_distance);
+
+            if(distance > bestDistance) {
+                bestDistance = distance;
+                tetra[3] = point;
+            }
+        }
+
+        if(bestDistance <= epsilon) {
+            return false;
+        }
+    }
+
+    glm::vec3 center = (points[tetra[0]] + points[tetra[1]] + points[tetra[2]] + points[tetra[3]]) * 0.25f;
+
+    std::vector<HullFace> faces;
+
+    {
+        const unsigned int TETRA_FACES[4][3] = {{0, 1, 2}, {0, 3, 1}, {0, 2, 3}, {1, 3, 2}};
+
+        for(unsigned int face = 0; face < 4; face++) {
+            HullFace newFace = makeFace(points, tetra[TETRA_FACES[face][0]], tetra[TETRA_FACES[face][1]], tetra[TETRA_FACES[face][2]]);
+
+            //flip to face outwards
+            if(glm::dot(newFace.m_normal, center) + newFace.m_distance > 0.0f) {
+                newFace = makeFace(points, newFace.m_vertices[0], newFace.m_vertices[2], newFace.m_vertices[1]);
+            }
+
+            faces.push_back(newFace);
+        }
+    }
+
+    //add the rest of the points one at a time
+    for(unsigned int point = 0; point < points.size(); point++) {
+        if(point == tetra[0] || point == tetra[1] || point == tetra[2] || point == tetra[3]) {
+            continue;
+        }
+
+        //directed edges of the faces that can see the point
+        std::set<std::pair<unsigned int, unsigned int> > visibleEdges;
+
+        for(auto faceIter = faces.begin(); faceIter != faces.end(); faceIter++) {
+            if(faceIter->m_alive && glm::dot(faceIter->m_normal, points[point]) + faceIter->m_distance > epsilon) {
+                faceIter->m_alive = false;
+
+                for(unsigned int edge = 0; edge < 3; edge++) {
+                    visibleEdges.insert(std::make_pair(faceIter->m_vertices[edge], faceIter->m_vertices[(edge + 1) % 3]));
+                }
+            }
+        }
+
+        //inside the hull so far
+        if(visibleEdges.empty()) {
+            continue;
+        }
+
+        //the horizon is made of the visible edges whose twin belongs to a face that can't see the point
+        for(auto edgeIter = visibleEdges.cbegin(); edgeIter != visibleEdges.end(); edgeIter++) {
+            if(visibleEdges.find(std::make_pair(edgeIter->second, edgeIter->first)) == visibleEdges.end()) {
+                faces.push_back(makeFace(points, edgeIter->first, edgeIter->second, point));
+            }
+        }
+    }
+
+    //compact down to the points that ended up being used
+    std::vector<unsigned int> remap(points.size(), (unsigned int) -1);
+
+    for(auto faceIter = faces.cbegin(); faceIter != faces.end(); faceIter++) {
+        if(!faceIter->m_alive) {
+            continue;
+        }
+
+        for(unsigned int corner = 0; corner < 3; corner++) {
+            unsigned int vertex = faceIter->m_vertices[corner];
+
+            if(remap[vertex] == (unsigned int) -1) {
+                remap[vertex] = (unsigned int) m_vertices.size();
+                m_vertices.push_back(points[vertex]);
+            }
+
+            m_triangles.push_back(remap[vertex]);
+        }
+
+        //triangles on the same plane only need the plane once
+        bool havePlane = false;
+
+        for(auto planeIter = m_planes.cbegin(); planeIter != m_planes.end() && !havePlane; planeIter++) {
+            havePlane = glm::dot(planeIter->m_normal, faceIter->m_normal) > PLANE_MERGE_COS
+                && fabs(planeIter->m_distance - faceIter->m_distance) <= epsilon;
+        }
+
+        if(!havePlane) {
+            m_planes.push_back(Plane<>(faceIter->m_normal, faceIter->m_distance));
+        }
+    }
+
+    return true;
+}
+
+float ConvexHull::computeVolume() const {
+    if(m_vertices.empty()) {
+        return 0.0f;
+    }
+
+    //sum of the tetrahedrons from a point inside to every face
+    glm::vec3 center(0.0f);
+
+    for(auto iter = m_vertices.cbegin(); iter != m_vertices.end(); iter++) {
+        center += *iter;
+    }
+
+    center /= (float) m_vertices.size();
+
+    float volume = 0.0f;
+
+    for(size_t triangle = 0; triangle < m_triangles.size(); triangle += 3) {
+        glm::vec3 edge0 = m_vertices[m_triangles[triangle]] - center;
+        glm::vec3 edge1 = m_vertices[m_triangles[triangle + 1]] - center;
+        glm::vec3 edge2 = m_vertices[m_triangles[triangle + 2]] - center;
+
+        volume += glm::dot(edge0, glm::cross(edge1, edge2)) / 6.0f;
+    }
+
+    return volume;
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef ILL_CONVERTER_CONVEX_HULL_H_
+#define ILL_CONVERTER_CONVEX_HULL_H_
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "illEngine/Util/Geometry/Plane.h"
+
+/**
+A convex hull as its corner points and the planes of its faces.
+The plane normals point outwards, so a point is inside when its distance to every plane is <= 0.
+*/
+class ConvexHull {
+public:
+    /**
+    Computes the hull of a point cloud.
+    If there are more points than maxVertices, only the extreme points in maxVertices evenly spread directions are used,
+    so the hull ends up slightly inside the real one.
+
+    @return false if the points are all on a plane or line and there's no hull with a volume.
+    */
+    bool build(const std::vector<glm::vec3>& points, unsigned int maxVertices);
+
+    float computeVolume() const;
+
+    std::vector<glm::vec3> m_vertices;
+    std::vector<unsigned int> m_triangles;      //3 indeces into m_vertices per face triangle
+    std::vector<Plane<> > m_planes;             //one per face, triangles on the same plane share one
+};
+
+#endif
\ No newline at end of file
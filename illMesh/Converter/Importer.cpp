@@ -7,6 +7,7 @@
 #include "Mesh.h"
 #include "Skeleton.h"
 #include "AnimSet.h"
+#include "parallel.h"
 
 #include "illEngine/Util/util.h"
 #include "illEngine/FileSystem/FileSystem.h"
@@ -18,7 +19,7 @@ unsigned int MESH_FLAGS =
     aiProcess_Triangulate |
     aiProcess_GenSmoothNormals |
     //aiProcess_PreTransformVertices |          //This removes bones and animations, so we don't want this
-    aiProcess_LimitBoneWeights |
+    //aiProcess_LimitBoneWeights |              //Mesh::import limits the weights itself with a configurable policy that gets reported
     aiProcess_ValidateDataStructure |
     aiProcess_ImproveCacheLocality |
     aiProcess_RemoveRedundantMaterials |
@@ -29,46 +30,63 @@ unsigned int MESH_FLAGS =
     aiProcess_OptimizeGraph*/;
 
 unsigned int SKEL_FLAGS = 
-    aiProcess_LimitBoneWeights |
     aiProcess_ValidateDataStructure |
     aiProcess_FindInvalidData/* |
     aiProcess_OptimizeGraph*/;
 
 unsigned int ANIM_FLAGS = 
-    aiProcess_LimitBoneWeights |
     aiProcess_ValidateDataStructure |
     aiProcess_FindInvalidData/* |
     aiProcess_OptimizeGraph*/;
 
 void Importer::computeBones() {
-    for(auto iter = m_importFiles.begin(); iter != m_importFiles.end(); iter++) {
+    std::vector<AnimSet::SceneBoneData> sceneBoneData(m_importFiles.size());
+
+    //loading and searching the scenes doesn't touch anything shared, ReadFile doesn't throw
+    parallelFor(m_importFiles.size(), m_numThreads, [this, &sceneBoneData] (size_t importIndex) {
+        Import& currImport = m_importFiles[importIndex];
         unsigned int processFlags = SKEL_FLAGS;
 
-        if(iter->m_meshOutFile) {
+        if(currImport.m_meshOutFile) {
             processFlags |= MESH_FLAGS;
         }
 
-        if(iter->m_animOutFile) {
+        if(currImport.m_animOutFile) {
             processFlags |= ANIM_FLAGS;
         }
 
-        iter->m_scene = iter->m_importer.ReadFile(iter->m_importFile, processFlags);
+        currImport.m_scene = currImport.m_importer.ReadFile(currImport.m_importFile, processFlags);
 
         /**
         Line 387 in JoinVerticesProcess for assimp mentions something about possibly removing bones
         which are attachment points for weapons in Md5s.  This is happening with SOUL_ATTACHER in 
         the doom 3 mppplayer.md5mesh and the run.md5anim files.
+        The same goes for -prunebones, attachment points like that need -keepbone.
         */
 
+        if(currImport.m_scene) {
+            AnimSet::gatherBones(currImport.m_scene, sceneBoneData[importIndex]);
+        }
+    });
+
+    //merge in the order the files were given so the bone indices are the same every run
+    for(size_t importIndex = 0; importIndex < m_importFiles.size(); importIndex++) {
         // If the import failed, report it
-        if(!iter->m_scene) {
-            LOG_FATAL_ERROR("The file %s failed to import", iter->m_importFile);
+        if(!m_importFiles[importIndex].m_scene) {
+            LOG_FATAL_ERROR("The file %s failed to import", m_importFiles[importIndex].m_importFile);
         }
 
-        m_animSet.findBones(iter->m_scene);
+        m_animSet.mergeBones(m_importFiles[importIndex].m_scene, sceneBoneData[importIndex]);
     }
 
     //m_animSet.computeHeirarchies();
+
+    if(m_animSet.m_pruneBones) {
+        m_animSet.pruneBones();
+    }
+
+    //parents before children so runtimes can compute the skeleton in one pass
+    m_animSet.sortBones();
 }
 
 void Importer::doImports() {
@@ -85,12 +103,19 @@ void Importer::doImports() {
         //the animations
         for(unsigned int animation = 0; animation < iter->m_scene->mNumAnimations; animation++) {
             iter->m_animationOut.push_back(new Animation());
-            iter->m_animationOut.back()->import(iter->m_scene->mAnimations[animation], m_importFiles.at(m_mainSkeletonImport).m_skeletonOut, &m_animSet);
+            iter->m_animationOut.back()->import(iter->m_scene->mAnimations[animation], iter->m_scene, &m_animSet);
         }
 
         //the meshes
+        if((iter->m_detectRigid || iter->m_influenceGroups) && iter->m_mergeMesh) {
+            LOG_INFO("Warning: ignoring -rigid and -influencegroups for %s, the mesh merger only merges meshes with 1 primitive group", iter->m_importFile);
+        }
+
         for(unsigned int mesh = 0; mesh < iter->m_scene->mNumMeshes; mesh++) {
             iter->m_meshOut.push_back(new Mesh());
+            iter->m_meshOut.back()->m_detectRigid = iter->m_detectRigid && !iter->m_mergeMesh;
+            iter->m_meshOut.back()->m_influenceGroups = iter->m_influenceGroups && !iter->m_mergeMesh;
+            iter->m_meshOut.back()->m_boneInfluences.m_overflowPolicy = iter->m_weightOverflow;
             iter->m_meshOut.back()->import(iter->m_scene->mMeshes[mesh], &m_animSet);
         }
     }
@@ -240,4 +265,30 @@ std::string Importer::computeSkeletonFileName(Skeleton * skeleton, const char *
     }
 
     return skeletonFileName;
+}
+
+std::string Importer::computeSidecarFileName(const std::string& fileName, const char * extension) {
+    size_t extensionPos = fileName.rfind('.');
+    size_t slashPos = fileName.find_last_of("/\\");
+
+    //make sure the dot is part of the file name and not some directory
+    if(extensionPos == fileName.npos || (slashPos != fileName.npos && extensionPos < slashPos)) {
+        return fileName + extension;
+    }
+
+    return fileName.substr(0, extensionPos) + extension;
+}
+
+std::string Importer::computeLodFileName(const std::string& fileName, unsigned int lod) {
+    size_t extensionPos = fileName.rfind('.');
+    size_t slashPos = fileName.find_last_of("/\\");
+
+    std::string lodSuffix = "_lod" + std::to_string((unsigned long long) lod);
+
+    //make sure the dot is part of the file name and not some directory
+    if(extensionPos == fileName.npos || (slashPos != fileName.npos && extensionPos < slashPos)) {
+        return fileName + lodSuffix;
+    }
+
+    return fileName.substr(0, extensionPos) + lodSuffix + fileName.substr(extensionPos);
 }
\ No newline at end of file
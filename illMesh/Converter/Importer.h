@@ -9,7 +9,8 @@
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 
-#include "AnimSet.h"Impo
+#include "AnimSet.h"
+#include "BoneInfluences.h"
 
 class Animation;
 class Mesh;
@@ -17,6 +18,11 @@ class Skeleton;
 
 class Importer {
 public:
+    Importer()
+        : m_mainSkeletonImport(0),
+        m_numThreads(0)
+    {}
+
     struct Import {
         Import()
             : m_importFile(NULL),
@@ -28,6 +34,13 @@ public:
             m_skelOutFile(NULL),
 
             m_mergeMesh(false),
+            m_detectRigid(false),
+            m_influenceGroups(false),
+            m_weightOverflow(BoneInfluences::OverflowPolicy::RENORMALIZE),
+
+            m_occluderTriangles(0),
+            m_collisionHulls(0),
+            m_morphTargets(false),
 
             m_scene(NULL),
 
@@ -43,6 +56,13 @@ public:
         const char * m_skelOutFile;
 
         bool m_mergeMesh;
+        bool m_detectRigid;                     //export meshes or parts of meshes bound fully to one bone as rigid attachments
+        bool m_influenceGroups;                 //split mesh groups and vertices by bone influence count
+        BoneInfluences::OverflowPolicy m_weightOverflow;    //what to do with vertices that have more bone influences than fit
+
+        unsigned int m_occluderTriangles;       //triangle budget of the occluder exported alongside each mesh, 0 for no occluder
+        unsigned int m_collisionHulls;          //max convex hulls for static meshes in the collision exported alongside each mesh, 0 for no collision
+        bool m_morphTargets;                    //export the blend shapes of meshes that have them alongside each mesh
 
         Assimp::Importer m_importer;
         const aiScene * m_scene;
@@ -52,12 +72,22 @@ public:
         Skeleton * m_skeletonOut;
     };
 
+    /**
+    Loads all the import files and finds their bones.
+    The files load on separate threads, the bones are merged into the animset in the order the files were given so bone indices don't depend on timing.
+    */
     void computeBones();
     void doImports();
 
     std::string computeAnimationFileName(Animation * animation, const char * path);
     std::string computeMeshFileName(Mesh * mesh, const aiScene * scene, const char * path);
     std::string computeSkeletonFileName(Skeleton * skeleton, const char * path);
+
+    //file name of data that goes alongside an exported file, same name with a different extension
+    static std::string computeSidecarFileName(const std::string& fileName, const char * extension);
+
+    //file name of a bone LOD version of an exported file, _lod and the LOD number go before the extension
+    std::string computeLodFileName(const std::string& fileName, unsigned int lod);
     
     std::set<std::string> m_usedAnimationNames;
     std::set<std::string> m_usedMeshNames;
@@ -65,6 +95,7 @@ public:
 
     std::vector<Import> m_importFiles;
     size_t m_mainSkeletonImport;    //which file import's skeleton is the one used for all animations
+    unsigned int m_numThreads;      //threads for loading the import files, 0 means use the hardware thread count
 
     AnimSet m_animSet;
 };
@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "KeyReducer.h"
+#include "Animation.h"
+#include "Skeleton.h"
+
+#include "illEngine/Logging/logging.h"
+
+const float PI = 3.14159265358979f;
+
+//keys removed between two kept keys are checked against every interpolation, this keeps that from going quadratic on long smooth stretches
+const uint32_t MAX_KEY_GAP = 256;
+
+struct ChannelTolerances {
+    float m_position;
+    float m_rotation;       //in radians
+    float m_scale;
+};
+
+//angle between two rotations, from the distance between the quaternions since acos of their dot product loses small angles to float precision
+float rotationError(const glm::quat& left, glm::quat right) {
+    glm::quat normalizedLeft = glm::normalize(left);
+    right = glm::normalize(right);
+
+    if(glm::dot(normalizedLeft, right) < 0.0f) {
+        right = -right;
+    }
+
+    float distance = sqrt((normalizedLeft.x - right.x) * (normalizedLeft.x - right.x) + (normalizedLeft.y - right.y) * (normalizedLeft.y - right.y)
+        + (normalizedLeft.z - right.z) * (normalizedLeft.z - right.z) + (normalizedLeft.w - right.w) * (normalizedLeft.w - right.w));
+
+    return 4.0f * asin(std::min(distance * 0.5f, 1.0f));
+}
+
+glm::quat interpolateRotation(const glm::quat& from, glm::quat to, float weight) {
+    //q and -q are the same rotation, go the short way around
+    if(glm::dot(from, to) < 0.0f) {
+        to = -to;
+    }
+
+    return glm::slerp(from, to, weight);
+}
+
+float vectorError(const glm::vec3& left, const glm::vec3& right) {
+    return glm::distance(left, right);
+}
+
+glm::vec3 interpolateVector(const glm::vec3& from, const glm::vec3& to, float weight) {
+    return glm::mix(from, to, weight);
+}
+
+/**
+Picks the keys of one channel of a track to keep.  The first and last keys are always kept unless the whole track is constant.
+@param maxError Set to the largest error of any of the original keys after the reduction.
+*/
+template <typename Value, typename Interpolate, typename Error>
+void reduceChannel(const float * times, const Value * values, uint32_t numKeys, float tolerance,
+        Interpolate interpolate, Error error, std::vector<uint32_t>& keptKeys, float& maxError) {
+    keptKeys.clear();
+    maxError = 0.0f;
+
+    if(numKeys == 0) {
+        return;
+    }
+
+    //constant tracks only need one key
+    {
+        float constantError = 0.0f;
+
+        for(uint32_t key = 1; key < numKeys; key++) {
+            constantError = std::max(constantError, error(values[key], values[0]));
+        }
+
+        if(constantError <= tolerance) {
+            keptKeys.push_back(0);
+            maxError = constantError;
+            return;
+        }
+    }
+
+    //how far off the keys between two kept keys end up
+    auto computeSpanError = [&] (uint32_t begin, uint32_t end) -> float {
+        float spanError = 0.0f;
+
+        for(uint32_t key = begin + 1; key < end; key++) {
+            float weight = times[end] > times[begin] ? (times[key] - times[begin]) / (times[end] - times[begin]) : 0.0f;
+            spanError = std::max(spanError, error(values[key], interpolate(values[begin], values[end], weight)));
+        }
+
+        return spanError;
+    };
+
+    //grow each span until it can't skip the keys in it anymore, then keep the key before that
+    uint32_t anchor = 0;
+    keptKeys.push_back(anchor);
+
+    for(uint32_t end = 2; end < numKeys; end++) {
+        if(end - anchor > MAX_KEY_GAP || computeSpanError(anchor, end) > tolerance) {
+            anchor = end - 1;
+            keptKeys.push_back(anchor);
+        }
+    }
+
+    keptKeys.push_back(numKeys - 1);
+
+    for(size_t span = 1; span < keptKeys.size(); span++) {
+        maxError = std::max(maxError, computeSpanError(keptKeys[span - 1], keptKeys[span]));
+    }
+}
+
+//copies the kept keys of a track's channel to the end of the new arrays
+template <typename Value>
+void copyKeptKeys(const float * times, const Value * values, const std::vector<uint32_t>& keptKeys,
+        std::vector<float>& newTimes, std::vector<Value>& newValues) {
+    for(auto iter = keptKeys.cbegin(); iter != keptKeys.end(); iter++) {
+        newTimes.push_back(times[*iter]);
+        newValues.push_back(values[*iter]);
+    }
+}
+
+/**
+For each bone, how far the furthest thing it moves is in the bind pose, and how many bones are in the longest chain from a root to a leaf going through it.
+*/
+void computeBoneReach(const Skeleton& skeleton, std::vector<float>& extents, std::vector<unsigned int>& chainLengths) {
+    size_t numBones = skeleton.m_parents.size();
+
+    std::vector<glm::mat4> modelTransforms(numBones);
+    std::vector<glm::vec3> positions(numBones);
+    std::vector<unsigned int> depths(numBones, 1);
+    std::vector<unsigned int> heights(numBones, 1);
+
+    extents.assign(numBones, 0.0f);
+
+    //parents come before their children in the evaluation order
+    for(auto iter = skeleton.m_evaluationOrder.cbegin(); iter != skeleton.m_evaluationOrder.end(); iter++) {
+        uint16_t bone = *iter;
+        uint16_t parent = skeleton.m_parents[bone];
+
+        modelTransforms[bone] = parent == bone
+            ? skeleton.m_bones[bone].m_relativeTransform
+            : modelTransforms[parent] * skeleton.m_bones[bone].m_relativeTransform;
+
+        positions[bone] = glm::vec3(modelTransforms[bone][3].x, modelTransforms[bone][3].y, modelTransforms[bone][3].z);
+
+        if(parent != bone) {
+            depths[bone] = depths[parent] + 1;
+
+            //leaf bones have nothing below them, their own length stands in for the skin they move
+            extents[bone] = glm::distance(positions[bone], positions[parent]);
+        }
+    }
+
+    //children before parents, the descendants' extents are bounded through the triangle inequality
+    for(auto iter = skeleton.m_evaluationOrder.crbegin(); iter != skeleton.m_evaluationOrder.rend(); iter++) {
+        uint16_t bone = *iter;
+        uint16_t parent = skeleton.m_parents[bone];
+
+        if(parent != bone) {
+            extents[parent] = std::max(extents[parent], glm::distance(positions[bone], positions[parent]) + extents[bone]);
+            heights[parent] = std::max(heights[parent], heights[bone] + 1);
+        }
+    }
+
+    chainLengths.resize(numBones);
+
+    for(size_t bone = 0; bone < numBones; bone++) {
+        chainLengths[bone] = depths[bone] + heights[bone] - 1;
+    }
+}
+
+void KeyReducer::reduce(Animation& animation, const Skeleton& skeleton, const char * name) const {
+    std::vector<float> extents;
+    std::vector<unsigned int> chainLengths;
+    computeBoneReach(skeleton, extents, chainLengths);
+
+    size_t numBones = skeleton.m_parents.size();
+
+    //the tolerance of each bone
+    ChannelTolerances channelTolerances;
+    channelTolerances.m_position = m_positionTolerance;
+    channelTolerances.m_rotation = m_rotationTolerance * PI / 180.0f;
+    channelTolerances.m_scale = m_scaleTolerance;
+
+    std::vector<ChannelTolerances> boneTolerances(numBones, channelTolerances);
+
+    if(m_modelSpaceTolerance > 0.0f) {
+        for(size_t bone = 0; bone < numBones; bone++) {
+            //split evenly between the bones in the chain, then between position, rotation, and scale
+            float share = m_modelSpaceTolerance / chainLengths[bone] / 3.0f;
+
+            boneTolerances[bone].m_position = share;
+
+            //a bone with nothing around it to move keeps the channel tolerances for rotation and scale
+            if(extents[bone] > 0.0f) {
+                boneTolerances[bone].m_rotation = share / extents[bone];
+                boneTolerances[bone].m_scale = share / extents[bone];
+            }
+        }
+    }
+
+    size_t sizeBefore = animation.computeSaveSize(animation.m_version);
+    size_t keysBefore = animation.m_positions.size() + animation.m_rotations.size() + animation.m_scales.size();
+
+    std::vector<float> newTimes[Animation::NUM_CHANNELS];
+    std::vector<glm::vec3> newPositions;
+    std::vector<glm::quat> newRotations;
+    std::vector<glm::vec3> newScales;
+
+    std::vector<uint32_t> keptKeys;
+
+    //largest error of each channel over the whole clip, and the model space error each bone causes
+    float maxErrors[Animation::NUM_CHANNELS] = {0.0f, 0.0f, 0.0f};
+    std::vector<float> boneErrors(numBones, 0.0f);
+
+    for(auto iter = animation.m_tracks.begin(); iter != animation.m_tracks.end(); iter++) {
+        Animation::Track& track = *iter;
+        const ChannelTolerances& tolerances = boneTolerances.at(track.m_bone);
+        float channelErrors[Animation::NUM_CHANNELS];
+
+        //positions
+        reduceChannel(animation.getTimes(track, Animation::CHANNEL_POSITION), animation.getPositions(track), track.m_numKeys[Animation::CHANNEL_POSITION],
+            tolerances.m_position, interpolateVector, vectorError, keptKeys, channelErrors[Animation::CHANNEL_POSITION]);
+
+        copyKeptKeys(animation.getTimes(track, Animation::CHANNEL_POSITION), animation.getPositions(track), keptKeys,
+            newTimes[Animation::CHANNEL_POSITION], newPositions);
+        track.m_beginKey[Animation::CHANNEL_POSITION] = (uint32_t) (newPositions.size() - keptKeys.size());
+        track.m_numKeys[Animation::CHANNEL_POSITION] = (uint32_t) keptKeys.size();
+
+        //rotations
+        reduceChannel(animation.getTimes(track, Animation::CHANNEL_ROTATION), animation.getRotations(track), track.m_numKeys[Animation::CHANNEL_ROTATION],
+            tolerances.m_rotation, interpolateRotation, rotationError, keptKeys, channelErrors[Animation::CHANNEL_ROTATION]);
+
+        copyKeptKeys(animation.getTimes(track, Animation::CHANNEL_ROTATION), animation.getRotations(track), keptKeys,
+            newTimes[Animation::CHANNEL_ROTATION], newRotations);
+        track.m_beginKey[Animation::CHANNEL_ROTATION] = (uint32_t) (newRotations.size() - keptKeys.size());
+        track.m_numKeys[Animation::CHANNEL_ROTATION] = (uint32_t) keptKeys.size();
+
+        //scales
+        reduceChannel(animation.getTimes(track, Animation::CHANNEL_SCALE), animation.getScales(track), track.m_numKeys[Animation::CHANNEL_SCALE],
+            tolerances.m_scale, interpolateVector, vectorError, keptKeys, channelErrors[Animation::CHANNEL_SCALE]);
+
+        copyKeptKeys(animation.getTimes(track, Animation::CHANNEL_SCALE), animation.getScales(track), keptKeys,
+            newTimes[Animation::CHANNEL_SCALE], newScales);
+        track.m_beginKey[Animation::CHANNEL_SCALE] = (uint32_t) (newScales.size() - keptKeys.size());
+        track.m_numKeys[Animation::CHANNEL_SCALE] = (uint32_t) keptKeys.size();
+
+        for(unsigned int channel = 0; channel < Animation::NUM_CHANNELS; channel++) {
+            maxErrors[channel] = std::max(maxErrors[channel], channelErrors[channel]);
+        }
+
+        boneErrors[track.m_bone] = channelErrors[Animation::CHANNEL_POSITION]
+            + (channelErrors[Animation::CHANNEL_ROTATION] + channelErrors[Animation::CHANNEL_SCALE]) * extents[track.m_bone];
+    }
+
+    for(unsigned int channel = 0; channel < Animation::NUM_CHANNELS; channel++) {
+        animation.m_times[channel].swap(newTimes[channel]);
+    }
+
+    animation.m_positions.swap(newPositions);
+    animation.m_rotations.swap(newRotations);
+    animation.m_scales.swap(newScales);
+
+    //the errors of the bones in a chain add up
+    float maxModelError = 0.0f;
+
+    for(auto iter = skeleton.m_evaluationOrder.cbegin(); iter != skeleton.m_evaluationOrder.end(); iter++) {
+        uint16_t bone = *iter;
+
+        if(skeleton.m_parents[bone] != bone) {
+            boneErrors[bone] += boneErrors[skeleton.m_parents[bone]];
+        }
+
+        maxModelError = std::max(maxModelError, boneErrors[bone]);
+    }
+
+    size_t keysAfter = animation.m_positions.size() + animation.m_rotations.size() + animation.m_scales.size();
+
+    LOG_INFO("Reduced animation %s from %u to %u keys, %u to %u bytes", name,
+        (unsigned int) keysBefore, (unsigned int) keysAfter, (unsigned int) sizeBefore, (unsigned int) animation.computeSaveSize(animation.m_version));
+    LOG_INFO("Animation %s max error: position %f, rotation %f degrees, scale %f, model space at most %f", name,
+        maxErrors[Animation::CHANNEL_POSITION], maxErrors[Animation::CHANNEL_ROTATION] * 180.0f / PI, maxErrors[Animation::CHANNEL_SCALE], maxModelError);
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef ILL_CONVERTER_KEY_REDUCER_H_
+#define ILL_CONVERTER_KEY_REDUCER_H_
+
+class Animation;
+class Skeleton;
+
+/**
+Removes animation keys that interpolating between the neighboring kept keys gives back within a tolerance.
+Tracks that stay within the tolerance of their first key the whole time collapse to that one key.
+
+The tolerances are either set per channel, or come from a distance in model space.
+For the model space distance each bone gets a share of it based on the longest chain of bones it's part of,
+since the errors of all the bones in a chain add up at its end.
+Rotation and scale errors move things more the further they are from the bone,
+so their share is divided by the distance from the bone to its furthest descendant, or its own length for leaf bones.
+*/
+class KeyReducer {
+public:
+    KeyReducer()
+        : m_positionTolerance(0.001f),
+        m_rotationTolerance(0.05f),
+        m_scaleTolerance(0.001f),
+        m_modelSpaceTolerance(0.0f)
+    {}
+
+    /**
+    Reduces the keys of an animation in place and logs the size before and after and the largest errors.
+    @param skeleton The skeleton the animation is for, its bind pose is used to bound the error in model space.
+    @param name What to call the animation in the log.
+    */
+    void reduce(Animation& animation, const Skeleton& skeleton, const char * name) const;
+
+    float m_positionTolerance;
+    float m_rotationTolerance;      //in degrees
+    float m_scaleTolerance;
+    float m_modelSpaceTolerance;    //if above 0 the bone tolerances come from this distance instead of the ones above
+};
+
+#endif
\ No newline at end of file
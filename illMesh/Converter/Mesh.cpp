@@ -1,13 +1,43 @@
+#include <algorithm>
+#include <cmath>
+
 #include "Mesh.h"
 #include "AnimSet.h"
 
 #include "illEngine/FileSystem/FileSystem.h"
 #include "illEngine/FileSystem/File.h"
 #include "illEngine/Util/Geometry/MeshData.h"
+#include "illEngine/Logging/logging.h"
 
 const uint64_t MESH_MAGIC = 0x494C4C4D45534831;	//ILLMESH1 in 64 bit big endian
+const uint64_t MESH_GROUPS_MAGIC = 0x494C4C4D47525031;	//ILLMGRP1 in 64 bit big endian
+
+const uint16_t Mesh::NO_BONE;
+
+//a vertex with this much weight on a single bone counts as rigidly bound to it
+const float RIGID_WEIGHT = 0.999f;
+
+//rigid pieces with fewer faces than this aren't worth their own draw and stay with the skinned faces
+const unsigned int MIN_RIGID_GROUP_FACES = 16;
+
+aiVector3D transformDirection(const aiMatrix3x3& transform, const aiVector3D& direction) {
+    aiVector3D res = transform * direction;
+    float length = sqrt(res.x * res.x + res.y * res.y + res.z * res.z);
+
+    if(length > 0.0f) {
+        res.x /= length;
+        res.y /= length;
+        res.z /= length;
+    }
+
+    return res;
+}
 
 void Mesh::save(const char * path) const {
+    save(path, m_boneInfluences);
+}
+
+void Mesh::save(const char * path, const BoneInfluences& boneInfluences) const {
     illFileSystem::File * openFile = illFileSystem::fileSystem->openWrite(path);
 	
 	//write magic string
@@ -33,7 +63,7 @@ void Mesh::save(const char * path) const {
             features |= MeshFeatures::MF_TEX_COORD;
         }
 
-        if(m_mesh->HasBones()) {
+        if(m_mesh->HasBones() && !isRigid()) {
             features |= MeshFeatures::MF_BLEND_DATA;
         }
 
@@ -44,8 +74,8 @@ void Mesh::save(const char * path) const {
         openFile->write8(features);
     }
 
-    //number of groups, set at 1.  Use the mesh merger tool to create multiple groups.
-    openFile->write8(1);
+    //number of groups, 1 unless rigid groups were found.  Use the mesh merger tool to create multiple groups.
+    openFile->write8((uint8_t) m_groups.size());
 
     //number of vertices
     openFile->writeL32((uint32_t) m_mesh->mNumVertices);
@@ -54,15 +84,30 @@ void Mesh::save(const char * path) const {
     openFile->writeL16((uint16_t) m_mesh->mNumFaces * 3);
     
     //write the group data
-    openFile->write8(3);        //hardcoded as Triangles
-    openFile->writeL16(0);
-    openFile->writeL16((uint16_t) m_mesh->mNumFaces * 3);
+    for(auto iter = m_groups.cbegin(); iter != m_groups.end(); iter++) {
+        openFile->write8(3);        //hardcoded as Triangles
+        openFile->writeL16((uint16_t) iter->m_beginFace * 3);
+        openFile->writeL16((uint16_t) iter->m_numFaces * 3);
+    }
+
+    //rigid meshes are written in the space of the bone they're attached to
+    aiMatrix3x3 tangentTransform(m_rigidTransform);
+    aiMatrix3x3 normalTransform(m_rigidTransform);
+
+    if(isRigid()) {
+        normalTransform.Inverse().Transpose();
+    }
 
     //write the VBO data
-    for(unsigned int vertex = 0; vertex < m_mesh->mNumVertices; vertex++) {
-        //write position)
+    for(auto vertIter = m_vertexOrder.cbegin(); vertIter != m_vertexOrder.end(); vertIter++) {
+        unsigned int vertex = *vertIter;
+
+        //write position
         if(m_mesh->HasPositions()) {
-            aiVector3D& currVec = m_mesh->mVertices[vertex];
+            aiVector3D currVec = isRigid()
+                ? m_rigidTransform * m_mesh->mVertices[vertex]
+                : m_mesh->mVertices[vertex];
+
             openFile->writeLF(currVec.x);
             openFile->writeLF(currVec.y);
             openFile->writeLF(currVec.z);
@@ -70,7 +115,10 @@ void Mesh::save(const char * path) const {
 
         //write normal
         if(m_mesh->HasNormals()) {
-            aiVector3D& currVec = m_mesh->mNormals[vertex];
+            aiVector3D currVec = isRigid()
+                ? transformDirection(normalTransform, m_mesh->mNormals[vertex])
+                : m_mesh->mNormals[vertex];
+
             openFile->writeLF(currVec.x);
             openFile->writeLF(currVec.y);
             openFile->writeLF(currVec.z);
@@ -78,51 +126,35 @@ void Mesh::save(const char * path) const {
 
         //write tangents
         if(m_mesh->HasTangentsAndBitangents()) {
-            aiVector3D& currVec = m_mesh->mTangents[vertex];
+            aiVector3D currVec = isRigid()
+                ? transformDirection(tangentTransform, m_mesh->mTangents[vertex])
+                : m_mesh->mTangents[vertex];
+
             openFile->writeLF(currVec.x);
             openFile->writeLF(currVec.y);
             openFile->writeLF(currVec.z);
 
-            currVec = m_mesh->mBitangents[vertex];
+            currVec = isRigid()
+                ? transformDirection(tangentTransform, m_mesh->mBitangents[vertex])
+                : m_mesh->mBitangents[vertex];
+
             openFile->writeLF(currVec.x);
             openFile->writeLF(currVec.y);
             openFile->writeLF(currVec.z);
         }
 
         //write blend weights
-        if(m_mesh->HasBones()) {
-            BoneMap& currBoneMap = m_boneWeights[vertex];
+        if(m_mesh->HasBones() && !isRigid()) {
+            //the influences are already strongest first and padded with 0 weights
 
             //write the indeces
-            {
-                int bone = 0;
-
-                for(auto iter = currBoneMap.begin(); iter != currBoneMap.end(); iter++) {
-                    bone++;
-                    openFile->writeLF((float) iter->first);
-                }
-
-                //pad the rest
-                while(bone < 4) {
-                    bone++;
-                    openFile->writeLF(0.0f);
-                }
+            for(unsigned int slot = 0; slot < BoneInfluences::MAX_INFLUENCES; slot++) {
+                openFile->writeLF((float) boneInfluences.getBone(vertex, slot));
             }
 
             //write the weights
-            {
-                int bone = 0;
-
-                for(auto iter = currBoneMap.begin(); iter != currBoneMap.end(); iter++) {
-                    bone++;
-                    openFile->writeLF((float) iter->second);
-                }
-
-                //pad the rest
-                while(bone < 4) {
-                    bone++;
-                    openFile->writeLF(0.0f);
-                }
+            for(unsigned int slot = 0; slot < BoneInfluences::MAX_INFLUENCES; slot++) {
+                openFile->writeLF(boneInfluences.getWeight(vertex, slot));
             }
         }
 
@@ -143,38 +175,237 @@ void Mesh::save(const char * path) const {
         }
     }
 
-    //write the IBO array
-    for(unsigned int face = 0; face < m_mesh->mNumFaces; face++) {
-        aiFace& currFace = m_mesh->mFaces[face];
+    //write the IBO array, grouped and pointing at the vertices where they ended up
+    std::vector<unsigned int> vertexRemap(m_mesh->mNumVertices);
+
+    for(unsigned int vertex = 0; vertex < m_vertexOrder.size(); vertex++) {
+        vertexRemap[m_vertexOrder[vertex]] = vertex;
+    }
+
+    for(auto faceIter = m_faceOrder.cbegin(); faceIter != m_faceOrder.end(); faceIter++) {
+        aiFace& currFace = m_mesh->mFaces[*faceIter];
         
         for(unsigned int vertex = 0; vertex < currFace.mNumIndices; ) {
-            openFile->writeL16(currFace.mIndices[vertex++]);
+            openFile->writeL16((uint16_t) vertexRemap[currFace.mIndices[vertex++]]);
         }
     }
 
     delete openFile;
 }
 
+/**
+Finds the bone each face is rigidly attached to, where all the face's vertices have full weight on the same bone.
+If the whole mesh ends up on one bone it becomes a rigid mesh that's saved in bone space.
+Rigid groups in a mesh that also has skinned faces stay in mesh space with their blend data so the mesh still skins correctly,
+the runtime can draw those groups with the single bone matrix instead of the full palette.
+*/
+void computeRigidFaces(Mesh& mesh, const AnimSet * animset, std::vector<uint16_t>& faceBones) {
+    const aiMesh * sourceMesh = mesh.m_mesh;
+
+    //the bone each vertex is rigidly bound to
+    std::vector<uint16_t> vertexBones(sourceMesh->mNumVertices, Mesh::NO_BONE);
+
+    for(unsigned int vertex = 0; vertex < sourceMesh->mNumVertices; vertex++) {
+        if(mesh.m_boneInfluences.getWeight(vertex, 0) >= RIGID_WEIGHT) {
+            vertexBones[vertex] = mesh.m_boneInfluences.getBone(vertex, 0);
+        }
+    }
+
+    //faces are rigid if all their corners are on the same bone
+    std::map<uint16_t, unsigned int> boneFaceCounts;
+
+    for(unsigned int face = 0; face < sourceMesh->mNumFaces; face++) {
+        const aiFace& currFace = sourceMesh->mFaces[face];
+        uint16_t bone = currFace.mNumIndices > 0 ? vertexBones[currFace.mIndices[0]] : Mesh::NO_BONE;
+
+        for(unsigned int corner = 1; corner < currFace.mNumIndices; corner++) {
+            if(vertexBones[currFace.mIndices[corner]] != bone) {
+                bone = Mesh::NO_BONE;
+            }
+        }
+
+        faceBones[face] = bone;
+        boneFaceCounts[bone]++;
+    }
+
+    if(boneFaceCounts.size() > 1) {
+        //fold the small rigid pieces back into the skinned faces
+        for(unsigned int face = 0; face < sourceMesh->mNumFaces; face++) {
+            if(faceBones[face] != Mesh::NO_BONE && boneFaceCounts[faceBones[face]] < MIN_RIGID_GROUP_FACES) {
+                faceBones[face] = Mesh::NO_BONE;
+            }
+        }
+    }
+    else if(!boneFaceCounts.empty() && boneFaceCounts.begin()->first != Mesh::NO_BONE) {
+        //the whole mesh is on one bone
+        mesh.m_rigidBone = boneFaceCounts.begin()->first;
+
+        for(unsigned int bone = 0; bone < sourceMesh->mNumBones; bone++) {
+            if(animset->m_boneRegistry.at(sourceMesh->mBones[bone]->mName.data) == mesh.m_rigidBone) {
+                mesh.m_rigidTransform = sourceMesh->mBones[bone]->mOffsetMatrix;
+            }
+        }
+
+        LOG_INFO("Mesh %s is rigidly attached to bone %u, saving it without blend data", sourceMesh->mName.data, mesh.m_rigidBone);
+    }
+}
+
 void Mesh::import(const aiMesh * mesh, const AnimSet * animset) {
     m_mesh = mesh;
 
     //compute bone VBO data
     if(m_mesh->HasBones()) {
-        m_boneWeights = new BoneMap[m_mesh->mNumVertices];
+        m_boneInfluences.reset(m_mesh->mNumVertices);
 
         //for each bone
         for(unsigned int bone = 0; bone < m_mesh->mNumBones; bone++) {
             aiBone* currBone = m_mesh->mBones[bone];
 
+            //look up skeleton bone index by name of bone
+            uint16_t boneIndex = animset->m_boneRegistry.at(currBone->mName.data);
+
             //for each vertex affected by the bone
             for(unsigned int weight = 0; weight < currBone->mNumWeights; weight++) {
-                aiVertexWeight& currWeight = currBone->mWeights[weight];
+                const aiVertexWeight& currWeight = currBone->mWeights[weight];
+                m_boneInfluences.add(currWeight.mVertexId, boneIndex, currWeight.mWeight);
+            }
+        }
+
+        m_boneInfluences.finish(m_mesh->mName.data);
+    }
+
+    m_groups.clear();
+    m_faceOrder.clear();
+    m_vertexOrder.clear();
+    m_influenceVertexCounts.assign(5, 0);
+    m_rigidBone = NO_BONE;
 
-                //look up skeleton bone index by name of bone
-                size_t boneIndex = animset->m_boneNameMap.at(currBone->mName.data);
+    std::vector<uint16_t> faceBones(m_mesh->mNumFaces, NO_BONE);
+    std::vector<uint8_t> vertexInfluences(m_mesh->mNumVertices, 0);
 
-                m_boneWeights[currWeight.mVertexId][boneIndex] = currWeight.mWeight;
+    if(m_detectRigid && m_mesh->HasBones()) {
+        computeRigidFaces(*this, animset, faceBones);
+    }
+
+    //rigid meshes have no blend data so all their vertices count as having no influences
+    if(m_mesh->HasBones() && !isRigid()) {
+        for(unsigned int vertex = 0; vertex < m_mesh->mNumVertices; vertex++) {
+            vertexInfluences[vertex] = m_boneInfluences.getNumInfluences(vertex);
+        }
+    }
+
+    //group faces by the bone they're attached to, then by the most influences on their vertices if splitting those up
+    //the skinned faces end up last since NO_BONE sorts last
+    std::map<std::pair<uint16_t, uint8_t>, std::vector<unsigned int> > groupFaces;
+
+    for(unsigned int face = 0; face < m_mesh->mNumFaces; face++) {
+        const aiFace& currFace = m_mesh->mFaces[face];
+        uint8_t maxInfluences = 0;
+
+        for(unsigned int corner = 0; corner < currFace.mNumIndices; corner++) {
+            maxInfluences = std::max(maxInfluences, vertexInfluences[currFace.mIndices[corner]]);
+        }
+
+        groupFaces[std::make_pair(faceBones[face], m_influenceGroups ? maxInfluences : (uint8_t) 0)].push_back(face);
+    }
+
+    if(groupFaces.size() > 255) {
+        LOG_INFO("Warning: mesh %s would need %u primitive groups, more than the mesh format holds, saving it as one skinned group",
+            m_mesh->mName.data, (unsigned int) groupFaces.size());
+
+        m_rigidBone = NO_BONE;
+        groupFaces.clear();
+
+        for(unsigned int face = 0; face < m_mesh->mNumFaces; face++) {
+            groupFaces[std::make_pair(NO_BONE, (uint8_t) 0)].push_back(face);
+        }
+    }
+
+    //an empty mesh still has its one group
+    if(groupFaces.empty()) {
+        groupFaces[std::make_pair(NO_BONE, (uint8_t) 0)];
+    }
+
+    unsigned int numRigidGroups = 0;
+
+    for(auto iter = groupFaces.cbegin(); iter != groupFaces.end(); iter++) {
+        Group group;
+        group.m_beginFace = (unsigned int) m_faceOrder.size();
+        group.m_numFaces = (unsigned int) iter->second.size();
+        group.m_attachBone = iter->first.first;
+        group.m_maxInfluences = 0;
+
+        for(auto faceIter = iter->second.cbegin(); faceIter != iter->second.end(); faceIter++) {
+            const aiFace& currFace = m_mesh->mFaces[*faceIter];
+
+            for(unsigned int corner = 0; corner < currFace.mNumIndices; corner++) {
+                group.m_maxInfluences = std::max(group.m_maxInfluences, vertexInfluences[currFace.mIndices[corner]]);
             }
         }
+
+        if(group.m_attachBone != NO_BONE) {
+            numRigidGroups++;
+        }
+
+        m_groups.push_back(group);
+        m_faceOrder.insert(m_faceOrder.end(), iter->second.begin(), iter->second.end());
+    }
+
+    if(numRigidGroups > 0 && !isRigid()) {
+        LOG_INFO("Mesh %s has %u rigid groups", m_mesh->mName.data, numRigidGroups);
+    }
+
+    //vertices with fewer influences go first so compute skinning can process each influence count as one range
+    for(unsigned int vertex = 0; vertex < m_mesh->mNumVertices; vertex++) {
+        m_vertexOrder.push_back(vertex);
+        m_influenceVertexCounts[vertexInfluences[vertex]]++;
+    }
+
+    if(m_influenceGroups) {
+        std::stable_sort(m_vertexOrder.begin(), m_vertexOrder.end(), [&vertexInfluences] (unsigned int left, unsigned int right) {
+            return vertexInfluences[left] < vertexInfluences[right];
+        });
+
+        LOG_INFO("Mesh %s vertices by influence count: %u, %u, %u, %u, %u", m_mesh->mName.data,
+            m_influenceVertexCounts[0], m_influenceVertexCounts[1], m_influenceVertexCounts[2], m_influenceVertexCounts[3], m_influenceVertexCounts[4]);
+    }
+}
+
+bool Mesh::hasGroupInfo() const {
+    if(m_influenceGroups) {
+        return true;
+    }
+
+    for(auto iter = m_groups.cbegin(); iter != m_groups.end(); iter++) {
+        if(iter->m_attachBone != NO_BONE) {
+            return true;
+        }
     }
+
+    return false;
+}
+
+void Mesh::saveGroups(const char * path) const {
+    illFileSystem::File * openFile = illFileSystem::fileSystem->openWrite(path);
+
+    //write magic string
+    openFile->writeB64(MESH_GROUPS_MAGIC);
+
+    //flags, bit 0 is set if the vertices are sorted by influence count
+    openFile->write8(m_influenceGroups ? 1 : 0);
+
+    //groups are in the same order as the primitive groups in the mesh file
+    openFile->writeL16((uint16_t) m_groups.size());
+
+    for(auto iter = m_groups.cbegin(); iter != m_groups.end(); iter++) {
+        openFile->writeL16(iter->m_attachBone);
+        openFile->write8(iter->m_maxInfluences);
+    }
+
+    //number of vertices with 0 to 4 influences, these are consecutive ranges if sorted by influence count
+    for(unsigned int influences = 0; influences <= 4; influences++) {
+        openFile->writeL32((uint32_t) m_influenceVertexCounts[influences]);
+    }
+
+    delete openFile;
 }
\ No newline at end of file
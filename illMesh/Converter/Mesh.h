@@ -6,27 +6,65 @@
 #include <set>
 #include <map>
 #include <string>
+#include <vector>
+
+#include "BoneInfluences.h"
 
 class AnimSet;
 
 class Mesh {
 public:
+    struct Group {
+        unsigned int m_beginFace;
+        unsigned int m_numFaces;
+        uint16_t m_attachBone;      //the bone the group is rigidly attached to, NO_BONE if it's skinned
+        uint8_t m_maxInfluences;    //most bones with weight on any vertex in the group, 0 if there's no blend data
+    };
+
+    static const uint16_t NO_BONE = 0xFFFF;
+
     Mesh()
         : m_mesh(NULL),
-        m_boneWeights(NULL)
+        m_detectRigid(false),
+        m_influenceGroups(false),
+        m_rigidBone(NO_BONE)
     {}
 
-    ~Mesh() {
-        delete[] m_boneWeights;
-    }
-
     void save(const char * path) const;
+
+    //saves with other bone influences for the same vertices, like ones remapped for a bone LOD
+    void save(const char * path, const BoneInfluences& boneInfluences) const;
     void import(const aiMesh * mesh, const AnimSet * animset);
 
+    /**
+    Writes which bone each primitive group in the mesh file is attached to, how many influences its vertices have,
+    and the vertex ranges by influence count.
+    Only useful if hasGroupInfo() is true, otherwise the mesh is just one skinned group.
+    */
+    void saveGroups(const char * path) const;
+
+    //true if the whole mesh is attached to one bone, it's then saved in that bone's space without blend data
+    inline bool isRigid() const {
+        return m_rigidBone != NO_BONE;
+    }
+
+    //true if there are rigid groups or the groups are split by influence count
+    bool hasGroupInfo() const;
+
     const aiMesh* m_mesh;
 
-    typedef std::map<uint16_t, float> BoneMap;
-    BoneMap * m_boneWeights;   //map of bone index to weight for each vertex, the array is the size of verteces in the mesh
+    BoneInfluences m_boneInfluences;   //bone indices and weights for each vertex, strongest first
+
+    bool m_detectRigid;        //whether to look for faces that are bound to only one bone with full weight during import
+    bool m_influenceGroups;    //whether to split groups and sort vertices by how many bones influence them
+
+    std::vector<Group> m_groups;
+    std::vector<unsigned int> m_faceOrder;     //the source face of each face in the order they're saved, faces of the same group are together
+    std::vector<unsigned int> m_vertexOrder;   //the source vertex of each vertex in the order they're saved
+    std::vector<unsigned int> m_influenceVertexCounts;     //number of vertices with 0 to 4 influences
+
+    uint16_t m_rigidBone;               //bone the whole mesh is attached to, NO_BONE if the mesh isn't rigid
+    aiMatrix4x4 m_rigidTransform;       //takes the mesh into m_rigidBone's space
 };
 
 #endif
\ No newline at end of file
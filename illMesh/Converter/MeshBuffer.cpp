@@ -0,0 +1,126 @@
+#include "MeshBuffer.h"
+
+#include "illEngine/FileSystem/FileSystem.h"
+#include "illEngine/FileSystem/File.h"
+#include "illEngine/Logging/logging.h"
+
+const uint64_t MESH_BUFFER_MAGIC = 0x494C4C4D45534831;	//ILLMESH1 in 64 bit big endian
+
+size_t MeshBuffer::computeVertexSize(FeaturesMask features) {
+    size_t size = 0;
+
+    if(features & MeshFeatures::MF_POSITION) {
+        size += 3;
+    }
+
+    if(features & MeshFeatures::MF_NORMAL) {
+        size += 3;
+    }
+
+    if(features & MeshFeatures::MF_TANGENT) {
+        size += 6;          //tangent and bitangent
+    }
+
+    if(features & MeshFeatures::MF_BLEND_DATA) {
+        size += 8;          //4 indeces and 4 weights
+    }
+
+    if(features & MeshFeatures::MF_TEX_COORD) {
+        size += 2;
+    }
+
+    if(features & MeshFeatures::MF_COLOR) {
+        size += 4;
+    }
+
+    return size;
+}
+
+bool MeshBuffer::isMeshFile(const char * path) {
+    illFileSystem::File * openFile = illFileSystem::fileSystem->openRead(path);
+
+    uint64_t magic;
+    openFile->readB64(magic);
+
+    delete openFile;
+
+    return magic == MESH_BUFFER_MAGIC;
+}
+
+void MeshBuffer::load(const char * path) {
+    illFileSystem::File * openFile = illFileSystem::fileSystem->openRead(path);
+
+    //read magic string
+    {
+        uint64_t magic;
+        openFile->readB64(magic);
+
+        if(magic != MESH_BUFFER_MAGIC) {
+            delete openFile;
+            LOG_FATAL_ERROR("%s is not a valid ILLMESH1 file.", path);
+        }
+    }
+
+    openFile->read8(m_features);
+    m_vertexSize = computeVertexSize(m_features);
+
+    uint8_t numGroups;
+    openFile->read8(numGroups);
+
+    openFile->readL32(m_numVertices);
+
+    uint16_t numIndices;
+    openFile->readL16(numIndices);
+
+    //group data
+    m_groups.resize(numGroups);
+
+    for(uint8_t group = 0; group < numGroups; group++) {
+        openFile->read8(m_groups[group].m_type);
+        openFile->readL16(m_groups[group].m_beginIndex);
+        openFile->readL16(m_groups[group].m_numIndices);
+    }
+
+    //VBO data
+    m_vertices.resize(m_numVertices * m_vertexSize);
+
+    for(size_t element = 0; element < m_vertices.size(); element++) {
+        openFile->readLF(m_vertices[element]);
+    }
+
+    //IBO data
+    m_indices.resize(numIndices);
+
+    for(uint16_t index = 0; index < numIndices; index++) {
+        openFile->readL16(m_indices[index]);
+    }
+
+    delete openFile;
+}
+
+void MeshBuffer::save(const char * path) const {
+    illFileSystem::File * openFile = illFileSystem::fileSystem->openWrite(path);
+
+    openFile->writeB64(MESH_BUFFER_MAGIC);
+
+    openFile->write8(m_features);
+    openFile->write8((uint8_t) m_groups.size());
+    openFile->writeL32(m_numVertices);
+    openFile->writeL16((uint16_t) m_indices.size());
+
+    for(auto iter = m_groups.cbegin(); iter != m_groups.end(); iter++) {
+        openFile->write8(iter->m_type);
+        openFile->writeL16(iter->m_beginIndex);
+        openFile->writeL16(iter->m_numIndices);
+    }
+
+    for(size_t element = 0; element < m_vertices.size(); element++) {
+        openFile->writeLF(m_vertices[element]);
+    }
+
+    for(size_t index = 0; index < m_indices.size(); index++) {
+        openFile->writeL16(m_indices[index]);
+    }
+
+    delete openFile;
+}
\ No newline at end of file
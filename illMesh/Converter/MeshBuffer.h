@@ -0,0 +1,53 @@
+#ifndef ILL_CONVERTER_MESH_BUFFER_H_
+#define ILL_CONVERTER_MESH_BUFFER_H_
+
+#include <stdint.h>
+#include <vector>
+#include "illEngine/Util/Geometry/MeshData.h"
+
+/**
+An already exported ILLMESH1 file held as flat arrays so it can be modified and written back out.
+The vertex data is kept as the same interleaved floats that are in the file.
+*/
+class MeshBuffer {
+public:
+    struct PrimitiveGroup {
+        uint8_t m_type;
+        uint16_t m_beginIndex;
+        uint16_t m_numIndices;
+    };
+
+    MeshBuffer()
+        : m_features(0),
+        m_numVertices(0),
+        m_vertexSize(0)
+    {}
+
+    void load(const char * path);
+    void save(const char * path) const;
+
+    //checks the magic number without loading the rest
+    static bool isMeshFile(const char * path);
+
+    //number of floats per vertex for the features
+    static size_t computeVertexSize(FeaturesMask features);
+
+    inline float * getVertex(uint32_t vertex) {
+        return &m_vertices[vertex * m_vertexSize];
+    }
+
+    inline const float * getVertex(uint32_t vertex) const {
+        return &m_vertices[vertex * m_vertexSize];
+    }
+
+    FeaturesMask m_features;
+    std::vector<PrimitiveGroup> m_groups;
+
+    uint32_t m_numVertices;
+    size_t m_vertexSize;            //number of floats per vertex
+
+    std::vector<float> m_vertices;  //interleaved vertex data, m_numVertices * m_vertexSize floats
+    std::vector<uint16_t> m_indices;
+};
+
+#endif
\ No newline at end of file
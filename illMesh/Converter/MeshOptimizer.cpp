@@ -0,0 +1,425 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "MeshOptimizer.h"
+#include "MeshBuffer.h"
+
+const uint8_t TRIANGLES_TYPE = 3;              //primitive group type of plain triangle lists
+const uint32_t NO_VERTEX = 0xFFFFFFFF;
+
+//tuning constants from Tom Forsyth's article
+const float CACHE_DECAY_POWER = 1.5f;
+const float LAST_TRIANGLE_SCORE = 0.75f;
+const float VALENCE_BOOST_SCALE = 2.0f;
+const float VALENCE_BOOST_POWER = 0.5f;
+
+void MeshOptimizer::optimize(MeshBuffer& mesh) const {
+    //welding first so the cache optimizer sees the shared vertices
+    if(m_weld) {
+        weldVertices(mesh);
+    }
+
+    if(m_optimizeVertexCache) {
+        optimizeVertexCache(mesh);
+    }
+
+    //needs to be last since it follows the final index order
+    if(m_optimizeVertexFetch) {
+        optimizeVertexFetch(mesh);
+    }
+}
+
+uint32_t hashVertex(const float * vertex, size_t vertexSize) {
+    uint32_t hash = 2166136261u;
+
+    for(size_t element = 0; element < vertexSize; element++) {
+        uint32_t bits;
+
+        if(vertex[element] == 0.0f) {
+            bits = 0;       //so -0 and 0 end up the same
+        }
+        else {
+            memcpy(&bits, &vertex[element], sizeof(float));
+        }
+
+        //FNV-1a a byte at a time
+        for(unsigned int byte = 0; byte < 4; byte++) {
+            hash ^= (bits >> (byte * 8)) & 0xFF;
+            hash *= 16777619u;
+        }
+    }
+
+    return hash;
+}
+
+bool verticesEqual(const float * vertex1, const float * vertex2, size_t vertexSize, float epsilon) {
+    for(size_t element = 0; element < vertexSize; element++) {
+        if(fabs(vertex1[element] - vertex2[element]) > epsilon) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//for each vertex the first vertex bitwise equal to it, found with an open addressing hash table kept at most half full
+void findExactRepresentatives(const MeshBuffer& mesh, std::vector<uint32_t>& representatives) {
+    size_t tableSize = 1;
+
+    while(tableSize < mesh.m_numVertices * 2) {
+        tableSize <<= 1;
+    }
+
+    std::vector<uint32_t> table(tableSize, NO_VERTEX);
+
+    for(uint32_t vertex = 0; vertex < mesh.m_numVertices; vertex++) {
+        const float * currVertex = mesh.getVertex(vertex);
+        size_t slot = hashVertex(currVertex, mesh.m_vertexSize) & (tableSize - 1);
+
+        //probe until an equal vertex or an empty slot shows up
+        while(table[slot] != NO_VERTEX && !verticesEqual(mesh.getVertex(table[slot]), currVertex, mesh.m_vertexSize, 0.0f)) {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+
+        if(table[slot] == NO_VERTEX) {
+            table[slot] = vertex;
+        }
+
+        representatives[vertex] = table[slot];
+    }
+}
+
+/**
+For each vertex a vertex within epsilon of it that it gets welded to, or itself.
+Rounding to an epsilon grid and hashing would miss vertices on opposite sides of a cell boundary,
+so this sorts along the element that's most spread out and compares each vertex with every earlier one within epsilon along it.
+*/
+void findNearRepresentatives(const MeshBuffer& mesh, float epsilon, std::vector<uint32_t>& representatives) {
+    //the element with the biggest range keeps the windows small, flat meshes have a position axis that's all the same
+    size_t keyElement = 0;
+    float keyRange = -1.0f;
+
+    for(size_t element = 0; element < mesh.m_vertexSize; element++) {
+        float minValue = mesh.getVertex(0)[element];
+        float maxValue = minValue;
+
+        for(uint32_t vertex = 1; vertex < mesh.m_numVertices; vertex++) {
+            minValue = std::min(minValue, mesh.getVertex(vertex)[element]);
+            maxValue = std::max(maxValue, mesh.getVertex(vertex)[element]);
+        }
+
+        if(maxValue - minValue > keyRange) {
+            keyElement = element;
+            keyRange = maxValue - minValue;
+        }
+    }
+
+    std::vector<uint32_t> sorted(mesh.m_numVertices);
+
+    for(uint32_t vertex = 0; vertex < mesh.m_numVertices; vertex++) {
+        sorted[vertex] = vertex;
+    }
+
+    std::sort(sorted.begin(), sorted.end(), [&] (uint32_t vertex1, uint32_t vertex2) {
+        float key1 = mesh.getVertex(vertex1)[keyElement];
+        float key2 = mesh.getVertex(vertex2)[keyElement];
+
+        return key1 < key2 || (key1 == key2 && vertex1 < vertex2);
+    });
+
+    for(size_t position = 0; position < sorted.size(); position++) {
+        uint32_t vertex = sorted[position];
+        const float * currVertex = mesh.getVertex(vertex);
+
+        representatives[vertex] = vertex;
+
+        //only vertices that are welded to themselves get welded to, otherwise chains of close vertices could drift further than epsilon
+        for(size_t candidate = position; candidate > 0; candidate--) {
+            uint32_t other = sorted[candidate - 1];
+            const float * otherVertex = mesh.getVertex(other);
+
+            if(currVertex[keyElement] - otherVertex[keyElement] > epsilon) {
+                break;
+            }
+
+            if(representatives[other] == other && verticesEqual(otherVertex, currVertex, mesh.m_vertexSize, epsilon)) {
+                representatives[vertex] = other;
+                break;
+            }
+        }
+    }
+}
+
+void MeshOptimizer::weldVertices(MeshBuffer& mesh) const {
+    if(mesh.m_numVertices == 0) {
+        return;
+    }
+
+    std::vector<uint32_t> representatives(mesh.m_numVertices);
+
+    if(m_weldEpsilon > 0.0f) {
+        findNearRepresentatives(mesh, m_weldEpsilon, representatives);
+    }
+    else {
+        findExactRepresentatives(mesh, representatives);
+    }
+
+    //the welded vertices in the order they're first used
+    std::vector<uint32_t> weldedIndex(mesh.m_numVertices, NO_VERTEX);
+    std::vector<uint32_t> remap(mesh.m_numVertices);
+
+    std::vector<float> weldedVertices;
+    weldedVertices.reserve(mesh.m_vertices.size());
+    uint32_t numWelded = 0;
+
+    for(uint32_t vertex = 0; vertex < mesh.m_numVertices; vertex++) {
+        uint32_t representative = representatives[vertex];
+
+        if(weldedIndex[representative] == NO_VERTEX) {
+            const float * representativeVertex = mesh.getVertex(representative);
+
+            weldedIndex[representative] = numWelded++;
+            weldedVertices.insert(weldedVertices.end(), representativeVertex, representativeVertex + mesh.m_vertexSize);
+        }
+
+        remap[vertex] = weldedIndex[representative];
+    }
+
+    for(size_t index = 0; index < mesh.m_indices.size(); index++) {
+        mesh.m_indices[index] = (uint16_t) remap[mesh.m_indices[index]];
+    }
+
+    mesh.m_vertices.swap(weldedVertices);
+    mesh.m_numVertices = numWelded;
+}
+
+float computeVertexScore(int cachePosition, unsigned int remainingTriangles, unsigned int cacheSize) {
+    //no triangles left to draw means never pick this vertex
+    if(remainingTriangles == 0) {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+
+    if(cachePosition >= 0) {
+        if(cachePosition < 3) {
+            //the vertex was used by the last triangle, fixed score so it doesn't favor reusing the exact same triangle edges
+            score = LAST_TRIANGLE_SCORE;
+        }
+        else {
+            float scaler = 1.0f / (cacheSize - 3);
+            score = pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+        }
+    }
+
+    //boost vertices with few triangles left so lone triangles don't get left behind
+    score += VALENCE_BOOST_SCALE * pow((float) remainingTriangles, -VALENCE_BOOST_POWER);
+
+    return score;
+}
+
+void MeshOptimizer::optimizeVertexCache(MeshBuffer& mesh) const {
+    for(auto groupIter = mesh.m_groups.cbegin(); groupIter != mesh.m_groups.end(); groupIter++) {
+        if(groupIter->m_type != TRIANGLES_TYPE || groupIter->m_numIndices < 6) {
+            continue;
+        }
+
+        uint16_t * groupIndices = &mesh.m_indices[groupIter->m_beginIndex];
+        unsigned int numTriangles = groupIter->m_numIndices / 3;
+
+        //build the vertex to triangle adjacency
+        std::vector<unsigned int> remainingTriangles(mesh.m_numVertices, 0);
+
+        for(unsigned int index = 0; index < numTriangles * 3; index++) {
+            remainingTriangles[groupIndices[index]]++;
+        }
+
+        std::vector<unsigned int> adjacencyOffset(mesh.m_numVertices + 1, 0);
+
+        for(uint32_t vertex = 0; vertex < mesh.m_numVertices; vertex++) {
+            adjacencyOffset[vertex + 1] = adjacencyOffset[vertex] + remainingTriangles[vertex];
+        }
+
+        std::vector<unsigned int> adjacency(numTriangles * 3);
+
+        {
+            std::vector<unsigned int> fillCount(mesh.m_numVertices, 0);
+
+            for(unsigned int triangle = 0; triangle < numTriangles; triangle++) {
+                for(unsigned int corner = 0; corner < 3; corner++) {
+                    uint16_t vertex = groupIndices[triangle * 3 + corner];
+                    adjacency[adjacencyOffset[vertex] + fillCount[vertex]++] = triangle;
+                }
+            }
+        }
+
+        //initial scores
+        std::vector<int> cachePosition(mesh.m_numVertices, -1);
+        std::vector<float> vertexScore(mesh.m_numVertices, -1.0f);
+
+        for(uint32_t vertex = 0; vertex < mesh.m_numVertices; vertex++) {
+            vertexScore[vertex] = computeVertexScore(-1, remainingTriangles[vertex], m_cacheSize);
+        }
+
+        std::vector<float> triangleScore(numTriangles);
+        std::vector<bool> emitted(numTriangles, false);
+
+        for(unsigned int triangle = 0; triangle < numTriangles; triangle++) {
+            triangleScore[triangle] = vertexScore[groupIndices[triangle * 3]]
+                + vertexScore[groupIndices[triangle * 3 + 1]]
+                + vertexScore[groupIndices[triangle * 3 + 2]];
+        }
+
+        std::vector<uint16_t> cache;
+        std::vector<uint16_t> newCache;
+        cache.reserve(m_cacheSize + 3);
+        newCache.reserve(m_cacheSize + 3);
+
+        std::vector<uint16_t> output;
+        output.reserve(numTriangles * 3);
+
+        unsigned int bestTriangle = 0;
+        float bestScore = -1.0f;
+
+        for(unsigned int triangle = 0; triangle < numTriangles; triangle++) {
+            if(triangleScore[triangle] > bestScore) {
+                bestScore = triangleScore[triangle];
+                bestTriangle = triangle;
+            }
+        }
+
+        for(unsigned int numEmitted = 0; numEmitted < numTriangles; numEmitted++) {
+            //the cache had nothing useful left, fall back on a full search
+            if(bestScore < 0.0f) {
+                for(unsigned int triangle = 0; triangle < numTriangles; triangle++) {
+                    if(!emitted[triangle] && triangleScore[triangle] > bestScore) {
+                        bestScore = triangleScore[triangle];
+                        bestTriangle = triangle;
+                    }
+                }
+            }
+
+            emitted[bestTriangle] = true;
+
+            //emit the triangle and take it out of its vertices' adjacency lists
+            for(unsigned int corner = 0; corner < 3; corner++) {
+                uint16_t vertex = groupIndices[bestTriangle * 3 + corner];
+                output.push_back(vertex);
+
+                unsigned int * triangles = &adjacency[adjacencyOffset[vertex]];
+                unsigned int& numRemaining = remainingTriangles[vertex];
+
+                for(unsigned int adjacent = 0; adjacent < numRemaining; adjacent++) {
+                    if(triangles[adjacent] == bestTriangle) {
+                        triangles[adjacent] = triangles[--numRemaining];
+                        break;
+                    }
+                }
+            }
+
+            //push the triangle's vertices to the front of the LRU cache
+            newCache.clear();
+
+            for(unsigned int corner = 0; corner < 3; corner++) {
+                newCache.push_back(groupIndices[bestTriangle * 3 + corner]);
+            }
+
+            for(auto cacheIter = cache.cbegin(); cacheIter != cache.end(); cacheIter++) {
+                if(*cacheIter != newCache[0] && *cacheIter != newCache[1] && *cacheIter != newCache[2]) {
+                    newCache.push_back(*cacheIter);
+                }
+            }
+
+            //update the scores of everything that was in the cache, including the ones that just fell out of it
+            for(unsigned int position = 0; position < newCache.size(); position++) {
+                uint16_t vertex = newCache[position];
+
+                cachePosition[vertex] = position < m_cacheSize ? (int) position : -1;
+                vertexScore[vertex] = computeVertexScore(cachePosition[vertex], remainingTriangles[vertex], m_cacheSize);
+            }
+
+            bestScore = -1.0f;
+
+            for(unsigned int position = 0; position < newCache.size(); position++) {
+                uint16_t vertex = newCache[position];
+                const unsigned int * triangles = &adjacency[adjacencyOffset[vertex]];
+
+                for(unsigned int adjacent = 0; adjacent < remainingTriangles[vertex]; adjacent++) {
+                    unsigned int triangle = triangles[adjacent];
+
+                    triangleScore[triangle] = vertexScore[groupIndices[triangle * 3]]
+                        + vertexScore[groupIndices[triangle * 3 + 1]]
+                        + vertexScore[groupIndices[triangle * 3 + 2]];
+
+                    if(triangleScore[triangle] > bestScore) {
+                        bestScore = triangleScore[triangle];
+                        bestTriangle = triangle;
+                    }
+                }
+            }
+
+            if(newCache.size() > m_cacheSize) {
+                newCache.resize(m_cacheSize);
+            }
+
+            cache.swap(newCache);
+        }
+
+        std::copy(output.begin(), output.end(), groupIndices);
+    }
+}
+
+void MeshOptimizer::optimizeVertexFetch(MeshBuffer& mesh) const {
+    std::vector<uint32_t> remap(mesh.m_numVertices, NO_VERTEX);
+    uint32_t numUsed = 0;
+
+    for(size_t index = 0; index < mesh.m_indices.size(); index++) {
+        uint16_t& currIndex = mesh.m_indices[index];
+
+        if(remap[currIndex] == NO_VERTEX) {
+            remap[currIndex] = numUsed++;
+        }
+
+        currIndex = (uint16_t) remap[currIndex];
+    }
+
+    std::vector<float> orderedVertices(numUsed * mesh.m_vertexSize);
+
+    for(uint32_t vertex = 0; vertex < mesh.m_numVertices; vertex++) {
+        if(remap[vertex] != NO_VERTEX) {
+            memcpy(&orderedVertices[remap[vertex] * mesh.m_vertexSize], mesh.getVertex(vertex), mesh.m_vertexSize * sizeof(float));
+        }
+    }
+
+    mesh.m_vertices.swap(orderedVertices);
+    mesh.m_numVertices = numUsed;
+}
+
+float MeshOptimizer::computeAcmr(const MeshBuffer& mesh, unsigned int cacheSize) {
+    std::vector<unsigned int> cacheTimestamp(mesh.m_numVertices, 0);
+    unsigned int time = cacheSize + 1;      //so that nothing starts out in the cache
+    unsigned int misses = 0;
+    unsigned int numTriangles = 0;
+
+    for(auto groupIter = mesh.m_groups.cbegin(); groupIter != mesh.m_groups.end(); groupIter++) {
+        if(groupIter->m_type != TRIANGLES_TYPE) {
+            continue;
+        }
+
+        numTriangles += groupIter->m_numIndices / 3;
+
+        for(unsigned int index = 0; index < groupIter->m_numIndices; index++) {
+            uint16_t vertex = mesh.m_indices[groupIter->m_beginIndex + index];
+
+            //a FIFO cache only cares about when a vertex was inserted, not when it was last used
+            if(time - cacheTimestamp[vertex] > cacheSize) {
+                cacheTimestamp[vertex] = time++;
+                misses++;
+            }
+        }
+    }
+
+    return numTriangles == 0 ? 0.0f : (float) misses / numTriangles;
+}
\ No newline at end of file
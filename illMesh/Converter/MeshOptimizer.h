@@ -0,0 +1,53 @@
+#ifndef ILL_CONVERTER_MESH_OPTIMIZER_H_
+#define ILL_CONVERTER_MESH_OPTIMIZER_H_
+
+class MeshBuffer;
+
+/**
+Optimization passes that run on an exported mesh.
+Each one keeps the mesh rendering exactly the same, it just reorganizes the buffers to be friendlier to the GPU.
+*/
+class MeshOptimizer {
+public:
+    MeshOptimizer()
+        : m_weld(true),
+        m_weldEpsilon(0.0f),
+        m_optimizeVertexCache(true),
+        m_cacheSize(32),
+        m_optimizeVertexFetch(true)
+    {}
+
+    //runs all enabled passes in the order they should happen
+    void optimize(MeshBuffer& mesh) const;
+
+    /**
+    Merges vertices that have all the same attributes.
+    With an epsilon of 0 only bitwise identical vertices get merged, otherwise attributes that are within epsilon of eachother.
+    */
+    void weldVertices(MeshBuffer& mesh) const;
+
+    /**
+    Reorders the triangles of each triangle primitive group so vertices get reused out of the post transform cache as much as possible.
+    This is Tom Forsyth's linear speed vertex cache optimization.
+    */
+    void optimizeVertexCache(MeshBuffer& mesh) const;
+
+    /**
+    Reorders the vertices in the order the index buffer first touches them so fetching them is as linear in memory as possible.
+    Vertices that no index references get dropped.
+    */
+    void optimizeVertexFetch(MeshBuffer& mesh) const;
+
+    //average cache miss ratio, number of vertices transformed per triangle with a FIFO cache of the given size
+    static float computeAcmr(const MeshBuffer& mesh, unsigned int cacheSize);
+
+    bool m_weld;
+    float m_weldEpsilon;
+
+    bool m_optimizeVertexCache;
+    unsigned int m_cacheSize;
+
+    bool m_optimizeVertexFetch;
+};
+
+#endif
\ No newline at end of file
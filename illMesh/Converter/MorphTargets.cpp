@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <cmath>
+
+#include "MorphTargets.h"
+#include "Mesh.h"
+
+#include "illEngine/FileSystem/FileSystem.h"
+#include "illEngine/FileSystem/File.h"
+#include "illEngine/Logging/logging.h"
+
+const uint64_t MORPH_MAGIC = 0x494C4C4D52504830;	//ILLMRPH0 in 64 bit big endian
+
+//normal deltas are at most 2 long per component, this maps them to -127 to 127
+const float NORMAL_DELTA_SCALE = 63.5f;
+
+glm::vec3 toGlm(const aiVector3D& vec) {
+    return glm::vec3(vec.x, vec.y, vec.z);
+}
+
+glm::vec3 normalizeOrZero(const glm::vec3& vec) {
+    float length = glm::length(vec);
+    return length > 0.0f ? vec / length : vec;
+}
+
+void MorphTargets::import(const Mesh * mesh) {
+    const aiMesh * sourceMesh = mesh->m_mesh;
+
+    m_numVertices = sourceMesh->mNumVertices;
+    m_targets.clear();
+
+    //rigid meshes are saved in bone space, the deltas need to be in the same space
+    aiMatrix3x3 positionTransform(mesh->m_rigidTransform);
+    aiMatrix3x3 normalTransform(mesh->m_rigidTransform);
+
+    if(mesh->isRigid()) {
+        normalTransform.Inverse().Transpose();
+    }
+
+    for(unsigned int animMesh = 0; animMesh < sourceMesh->mNumAnimMeshes; animMesh++) {
+        const aiAnimMesh * target = sourceMesh->mAnimMeshes[animMesh];
+
+        m_targets.push_back(Target());
+        Target& currTarget = m_targets.back();
+
+        if(target->mNumVertices != sourceMesh->mNumVertices || !target->HasPositions()) {
+            LOG_INFO("Warning: morph target %u of mesh %s doesn't line up with the mesh vertices, saving it empty", animMesh, sourceMesh->mName.data);
+            continue;
+        }
+
+        bool hasNormals = target->HasNormals() && sourceMesh->HasNormals();
+
+        //walk the vertices in saved order so the indices come out ascending
+        for(uint32_t vertex = 0; vertex < (uint32_t) mesh->m_vertexOrder.size(); vertex++) {
+            unsigned int sourceVertex = mesh->m_vertexOrder[vertex];
+
+            aiVector3D positionOffset = target->mVertices[sourceVertex];
+            positionOffset.x -= sourceMesh->mVertices[sourceVertex].x;
+            positionOffset.y -= sourceMesh->mVertices[sourceVertex].y;
+            positionOffset.z -= sourceMesh->mVertices[sourceVertex].z;
+
+            glm::vec3 positionDelta = mesh->isRigid() ? toGlm(positionTransform * positionOffset) : toGlm(positionOffset);
+            glm::vec3 normalDelta(0.0f);
+
+            if(hasNormals) {
+                if(mesh->isRigid()) {
+                    normalDelta = normalizeOrZero(toGlm(normalTransform * target->mNormals[sourceVertex]))
+                        - normalizeOrZero(toGlm(normalTransform * sourceMesh->mNormals[sourceVertex]));
+                }
+                else {
+                    normalDelta = toGlm(target->mNormals[sourceVertex]) - toGlm(sourceMesh->mNormals[sourceVertex]);
+                }
+            }
+
+            if(glm::length(positionDelta) <= m_epsilon && glm::length(normalDelta) <= m_epsilon) {
+                continue;
+            }
+
+            if(currTarget.m_vertices.empty()) {
+                currTarget.m_minDelta = positionDelta;
+                currTarget.m_maxDelta = positionDelta;
+            }
+            else {
+                currTarget.m_minDelta = glm::min(currTarget.m_minDelta, positionDelta);
+                currTarget.m_maxDelta = glm::max(currTarget.m_maxDelta, positionDelta);
+            }
+
+            currTarget.m_vertices.push_back((uint16_t) vertex);
+            currTarget.m_positionDeltas.push_back(positionDelta);
+
+            if(hasNormals) {
+                currTarget.m_normalDeltas.push_back(normalDelta);
+            }
+        }
+
+        LOG_INFO("Morph target %u of mesh %s moves %u of %u vertices", animMesh, sourceMesh->mName.data,
+            (unsigned int) currTarget.m_vertices.size(), m_numVertices);
+    }
+}
+
+void MorphTargets::save(const char * path) const {
+    illFileSystem::File * openFile = illFileSystem::fileSystem->openWrite(path);
+
+    //write magic string
+    openFile->writeB64(MORPH_MAGIC);
+
+    //so the runtime can check the targets go with the mesh
+    openFile->writeL32(m_numVertices);
+    openFile->writeL16((uint16_t) m_targets.size());
+
+    for(auto iter = m_targets.cbegin(); iter != m_targets.end(); iter++) {
+        uint16_t numDeltas = (uint16_t) iter->m_vertices.size();
+        bool hasNormals = !iter->m_normalDeltas.empty();
+
+        openFile->writeL16(numDeltas);
+
+        //flags, bit 0 is set if there are normal deltas
+        openFile->write8(hasNormals ? 1 : 0);
+
+        if(numDeltas == 0) {
+            continue;
+        }
+
+        //the position delta bounds, the quantized deltas go from min at 0 to max at 65535
+        for(unsigned int component = 0; component < 3; component++) {
+            openFile->writeLF(iter->m_minDelta[component]);
+        }
+
+        for(unsigned int component = 0; component < 3; component++) {
+            openFile->writeLF(iter->m_maxDelta[component]);
+        }
+
+        for(uint16_t delta = 0; delta < numDeltas; delta++) {
+            openFile->writeL16(iter->m_vertices[delta]);
+        }
+
+        glm::vec3 range = iter->m_maxDelta - iter->m_minDelta;
+
+        for(uint16_t delta = 0; delta < numDeltas; delta++) {
+            for(unsigned int component = 0; component < 3; component++) {
+                float normalized = range[component] > 0.0f
+                    ? (iter->m_positionDeltas[delta][component] - iter->m_minDelta[component]) / range[component]
+                    : 0.0f;
+
+                openFile->writeL16((uint16_t) floor(normalized * 65535.0f + 0.5f));
+            }
+        }
+
+        if(hasNormals) {
+            for(uint16_t delta = 0; delta < numDeltas; delta++) {
+                for(unsigned int component = 0; component < 3; component++) {
+                    float quantized = floor(iter->m_normalDeltas[delta][component] * NORMAL_DELTA_SCALE + 0.5f);
+                    openFile->write8((uint8_t) (int8_t) std::max(-127.0f, std::min(127.0f, quantized)));
+                }
+            }
+        }
+    }
+
+    delete openFile;
+}
\ No newline at end of file
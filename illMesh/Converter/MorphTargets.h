@@ -0,0 +1,40 @@
+#ifndef ILL_CONVERTER_MORPH_TARGETS_H_
+#define ILL_CONVERTER_MORPH_TARGETS_H_
+
+#include <stdint.h>
+#include <vector>
+#include <glm/glm.hpp>
+
+class Mesh;
+
+/**
+The blend shapes of a mesh, saved sparsely.
+Each target only keeps the vertices it moves, as saved vertex indices with position and normal deltas from the base mesh.
+Position deltas are quantized to 16 bits within the target's delta bounds, normal deltas to 8 bits.
+*/
+class MorphTargets {
+public:
+    struct Target {
+        std::vector<uint16_t> m_vertices;           //the moved vertices in the order they're saved in the mesh file, ascending
+        std::vector<glm::vec3> m_positionDeltas;
+        std::vector<glm::vec3> m_normalDeltas;      //empty if the target has no normals
+
+        glm::vec3 m_minDelta;                       //bounds of the position deltas
+        glm::vec3 m_maxDelta;
+    };
+
+    MorphTargets()
+        : m_epsilon(0.00001f),
+        m_numVertices(0)
+    {}
+
+    void import(const Mesh * mesh);
+    void save(const char * path) const;
+
+    float m_epsilon;                    //vertices whose position and normal move less than this aren't in the target
+
+    uint32_t m_numVertices;             //vertices in the mesh the targets go with
+    std::vector<Target> m_targets;      //in the same order as the source mesh's anim meshes
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <cmath>
+
+#include "Occluder.h"
+#include "Mesh.h"
+
+#include "illEngine/FileSystem/FileSystem.h"
+#include "illEngine/FileSystem/File.h"
+#include "illEngine/Logging/logging.h"
+
+const uint64_t OCCLUDER_MAGIC = 0x494C4C4F43434C30;	//ILLOCCL0 in 64 bit big endian
+
+enum VoxelState {
+    VS_UNKNOWN,         //not touched by the surface and not reachable from outside, so inside
+    VS_SURFACE,
+    VS_OUTSIDE
+};
+
+struct VoxelBox {
+    unsigned int m_min[3];
+    unsigned int m_max[3];      //exclusive
+    unsigned int m_volume;
+};
+
+//box vertex is (x ? 1 : 0) | (y ? 2 : 0) | (z ? 4 : 0), counter clockwise when looking at the box from outside
+const uint16_t BOX_INDICES[36] = {
+    0, 4, 6,  0, 6, 2,      //-X
+    1, 3, 7,  1, 7, 5,      //+X
+    0, 1, 5,  0, 5, 4,      //-Y
+    2, 6, 7,  2, 7, 3,      //+Y
+    0, 2, 3,  0, 3, 1,      //-Z
+    4, 5, 7,  4, 7, 6       //+Z
+};
+
+//separating axis test of a triangle already relative to the box center
+bool axisSeparates(const glm::vec3& axis, const glm::vec3& vert0, const glm::vec3& vert1, const glm::vec3& vert2, const glm::vec3& halfSize) {
+    float proj0 = glm::dot(vert0, axis);
+    float proj1 = glm::dot(vert1, axis);
+    float proj2 = glm::dot(vert2, axis);
+
+    float radius = halfSize.x * fabs(axis.x) + halfSize.y * fabs(axis.y) + halfSize.z * fabs(axis.z);
+
+    return std::min(proj0, std::min(proj1, proj2)) > radius
+        || std::max(proj0, std::max(proj1, proj2)) < -radius;
+}
+
+//Akenine-Moller triangle box overlap test
+bool triangleOverlapsBox(const glm::vec3& boxCenter, const glm::vec3& halfSize, const glm::vec3& point0, const glm::vec3& point1, const glm::vec3& point2) {
+    glm::vec3 vert0 = point0 - boxCenter;
+    glm::vec3 vert1 = point1 - boxCenter;
+    glm::vec3 vert2 = point2 - boxCenter;
+
+    glm::vec3 edges[3] = {vert1 - vert0, vert2 - vert1, vert0 - vert2};
+    const glm::vec3 boxAxes[3] = {glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)};
+
+    //the box face normals
+    for(unsigned int axis = 0; axis < 3; axis++) {
+        if(axisSeparates(boxAxes[axis], vert0, vert1, vert2, halfSize)) {
+            return false;
+        }
+    }
+
+    //the triangle plane
+    if(axisSeparates(glm::cross(edges[0], edges[1]), vert0, vert1, vert2, halfSize)) {
+        return false;
+    }
+
+    //the edge cross products
+    for(unsigned int axis = 0; axis < 3; axis++) {
+        for(unsigned int edge = 0; edge < 3; edge++) {
+            if(axisSeparates(glm::cross(boxAxes[axis], edges[edge]), vert0, vert1, vert2, halfSize)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void Occluder::import(const Mesh * mesh) {
+    const aiMesh * sourceMesh = mesh->m_mesh;
+
+    m_vertices.clear();
+    m_indices.clear();
+
+    if(!sourceMesh->HasPositions() || sourceMesh->mNumFaces == 0) {
+        return;
+    }
+
+    //in the same space the mesh is saved in
+    std::vector<glm::vec3> positions(sourceMesh->mNumVertices);
+
+    for(unsigned int vertex = 0; vertex < sourceMesh->mNumVertices; vertex++) {
+        aiVector3D position = mesh->isRigid()
+            ? mesh->m_rigidTransform * sourceMesh->mVertices[vertex]
+            : sourceMesh->mVertices[vertex];
+
+        positions[vertex] = glm::vec3(position.x, position.y, position.z);
+    }
+
+    //figure out the voxel grid
+    glm::vec3 boundsMin = positions[0];
+    glm::vec3 boundsMax = boundsMin;
+
+    for(unsigned int vertex = 1; vertex < sourceMesh->mNumVertices; vertex++) {
+        boundsMin = glm::min(boundsMin, positions[vertex]);
+        boundsMax = glm::max(boundsMax, positions[vertex]);
+    }
+
+    glm::vec3 extent = boundsMax - boundsMin;
+    float voxelSize = std::max(extent.x, std::max(extent.y, extent.z)) / m_resolution;
+
+    if(voxelSize <= 0.0f) {
+        return;
+    }
+
+    //pad by a voxel on each side so the border of the grid is guaranteed to be outside
+    unsigned int gridSize[3];
+
+    for(unsigned int axis = 0; axis < 3; axis++) {
+        gridSize[axis] = (unsigned int) ceil(extent[axis] / voxelSize) + 2;
+    }
+
+    glm::vec3 gridMin = boundsMin - glm::vec3(voxelSize);
+
+    std::vector<uint8_t> voxels(gridSize[0] * gridSize[1] * gridSize[2], VS_UNKNOWN);
+
+    #define VOXEL_INDEX(x, y, z) (((z) * gridSize[1] + (y)) * gridSize[0] + (x))
+
+    //mark every voxel the surface passes through, the box is slightly enlarged so touching counts too
+    {
+        glm::vec3 halfSize(voxelSize * 0.5001f);
+
+        for(unsigned int face = 0; face < sourceMesh->mNumFaces; face++) {
+            const aiFace& currFace = sourceMesh->mFaces[face];
+
+            if(currFace.mNumIndices != 3) {
+                continue;
+            }
+
+            glm::vec3 points[3];
+            glm::vec3 triMin, triMax;
+
+            for(unsigned int corner = 0; corner < 3; corner++) {
+                points[corner] = positions[currFace.mIndices[corner]];
+            }
+
+            triMin = glm::min(points[0], glm::min(points[1], points[2]));
+            triMax = glm::max(points[0], glm::max(points[1], points[2]));
+
+            unsigned int cellMin[3];
+            unsigned int cellMax[3];
+
+            for(unsigned int axis = 0; axis < 3; axis++) {
+                cellMin[axis] = (unsigned int) std::max(0.0f, (float) floor((triMin[axis] - gridMin[axis]) / voxelSize) - 1.0f);
+                cellMax[axis] = std::min(gridSize[axis] - 1, (unsigned int) floor((triMax[axis] - gridMin[axis]) / voxelSize) + 1);
+            }
+
+            for(unsigned int z = cellMin[2]; z <= cellMax[2]; z++) {
+                for(unsigned int y = cellMin[1]; y <= cellMax[1]; y++) {
+                    for(unsigned int x = cellMin[0]; x <= cellMax[0]; x++) {
+                        uint8_t& voxel = voxels[VOXEL_INDEX(x, y, z)];
+
+                        if(voxel == VS_SURFACE) {
+                            continue;
+                        }
+
+                        glm::vec3 center = gridMin + glm::vec3(x + 0.5f, y + 0.5f, z + 0.5f) * voxelSize;
+
+                        if(triangleOverlapsBox(center, halfSize, points[0], points[1], points[2])) {
+                            voxel = VS_SURFACE;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    //flood fill the outside starting from the corner of the padding
+    {
+        std::vector<unsigned int> stack;
+        stack.push_back(VOXEL_INDEX(0, 0, 0));
+        voxels[VOXEL_INDEX(0, 0, 0)] = VS_OUTSIDE;
+
+        while(!stack.empty()) {
+            unsigned int index = stack.back();
+            stack.pop_back();
+
+            unsigned int x = index % gridSize[0];
+            unsigned int y = (index / gridSize[0]) % gridSize[1];
+            unsigned int z = index / (gridSize[0] * gridSize[1]);
+
+            unsigned int neighbors[6];
+            unsigned int numNeighbors = 0;
+
+            if(x > 0) neighbors[numNeighbors++] = VOXEL_INDEX(x - 1, y, z);
+            if(x + 1 < gridSize[0]) neighbors[numNeighbors++] = VOXEL_INDEX(x + 1, y, z);
+            if(y > 0) neighbors[numNeighbors++] = VOXEL_INDEX(x, y - 1, z);
+            if(y + 1 < gridSize[1]) neighbors[numNeighbors++] = VOXEL_INDEX(x, y + 1, z);
+            if(z > 0) neighbors[numNeighbors++] = VOXEL_INDEX(x, y, z - 1);
+            if(z + 1 < gridSize[2]) neighbors[numNeighbors++] = VOXEL_INDEX(x, y, z + 1);
+
+            for(unsigned int neighbor = 0; neighbor < numNeighbors; neighbor++) {
+                if(voxels[neighbors[neighbor]] == VS_UNKNOWN) {
+                    voxels[neighbors[neighbor]] = VS_OUTSIDE;
+                    stack.push_back(neighbors[neighbor]);
+                }
+            }
+        }
+    }
+
+    //greedily merge the inside voxels into boxes, growing along x, then y, then z
+    std::vector<VoxelBox> boxes;
+    std::vector<bool> claimed(voxels.size(), false);
+    unsigned int numInside = 0;
+
+    #define VOXEL_FREE(x, y, z) (voxels[VOXEL_INDEX(x, y, z)] == VS_UNKNOWN && !claimed[VOXEL_INDEX(x, y, z)])
+
+    for(unsigned int z = 0; z < gridSize[2]; z++) {
+        for(unsigned int y = 0; y < gridSize[1]; y++) {
+            for(unsigned int x = 0; x < gridSize[0]; x++) {
+                if(!VOXEL_FREE(x, y, z)) {
+                    continue;
+                }
+
+                VoxelBox box;
+                box.m_min[0] = x;
+                box.m_min[1] = y;
+                box.m_min[2] = z;
+
+                unsigned int maxX = x + 1;
+
+                while(maxX < gridSize[0] && VOXEL_FREE(maxX, y, z)) {
+                    maxX++;
+                }
+
+                unsigned int maxY = y + 1;
+
+                for(bool grow = true; grow && maxY < gridSize[1]; ) {
+                    for(unsigned int boxX = x; boxX < maxX && grow; boxX++) {
+                        grow = VOXEL_FREE(boxX, maxY, z);
+                    }
+
+                    if(grow) {
+                        maxY++;
+                    }
+                }
+
+                unsigned int maxZ = z + 1;
+
+                for(bool grow = true; grow && maxZ < gridSize[2]; ) {
+                    for(unsigned int boxY = y; boxY < maxY && grow; boxY++) {
+                        for(unsigned int boxX = x; boxX < maxX && grow; boxX++) {
+                            grow = VOXEL_FREE(boxX, boxY, maxZ);
+                        }
+                    }
+
+                    if(grow) {
+                        maxZ++;
+                    }
+                }
+
+                for(unsigned int boxZ = z; boxZ < maxZ; boxZ++) {
+                    for(unsigned int boxY = y; boxY < maxY; boxY++) {
+                        for(unsigned int boxX = x; boxX < maxX; boxX++) {
+                            claimed[VOXEL_INDEX(boxX, boxY, boxZ)] = true;
+                        }
+                    }
+                }
+
+                box.m_max[0] = maxX;
+                box.m_max[1] = maxY;
+                box.m_max[2] = maxZ;
+                box.m_volume = (maxX - x) * (maxY - y) * (maxZ - z);
+
+                numInside += box.m_volume;
+                boxes.push_back(box);
+            }
+        }
+    }
+
+    #undef VOXEL_FREE
+    #undef VOXEL_INDEX
+
+    if(boxes.empty()) {
+        LOG_INFO("Warning: mesh %s has no voxels fully inside it, it's either too thin or not closed.  The occluder will be empty.", sourceMesh->mName.data);
+        return;
+    }
+
+    //keep the biggest boxes that fit in the budget
+    std::stable_sort(boxes.begin(), boxes.end(), [] (const VoxelBox& box1, const VoxelBox& box2) {
+        return box1.m_volume > box2.m_volume;
+    });
+
+    size_t numBoxes = std::min(boxes.size(), (size_t) (m_triangleBudget / 12));
+    numBoxes = std::min(numBoxes, (size_t) (0xFFFF / 36));      //16 bit index count
+    unsigned int keptVolume = 0;
+
+    for(size_t box = 0; box < numBoxes; box++) {
+        const VoxelBox& currBox = boxes[box];
+        uint16_t firstVertex = (uint16_t) m_vertices.size();
+
+        for(unsigned int corner = 0; corner < 8; corner++) {
+            m_vertices.push_back(gridMin + glm::vec3(
+                (float) ((corner & 1) ? currBox.m_max[0] : currBox.m_min[0]),
+                (float) ((corner & 2) ? currBox.m_max[1] : currBox.m_min[1]),
+                (float) ((corner & 4) ? currBox.m_max[2] : currBox.m_min[2])) * voxelSize);
+        }
+
+        for(unsigned int index = 0; index < 36; index++) {
+            m_indices.push_back(firstVertex + BOX_INDICES[index]);
+        }
+
+        keptVolume += currBox.m_volume;
+    }
+
+    LOG_INFO("Occluder for mesh %s has %u boxes with %u triangles covering %.1f%% of the inside volume",
+        sourceMesh->mName.data, (unsigned int) numBoxes, (unsigned int) (m_indices.size() / 3), 100.0f * keptVolume / numInside);
+}
+
+void Occluder::save(const char * path) const {
+    illFileSystem::File * openFile = illFileSystem::fileSystem->openWrite(path);
+
+    //write magic string
+    openFile->writeB64(OCCLUDER_MAGIC);
+
+    openFile->writeL16((uint16_t) m_vertices.size());
+    openFile->writeL16((uint16_t) m_indices.size());
+
+    for(auto iter = m_vertices.cbegin(); iter != m_vertices.end(); iter++) {
+        openFile->writeLF(iter->x);
+        openFile->writeLF(iter->y);
+        openFile->writeLF(iter->z);
+    }
+
+    for(auto iter = m_indices.cbegin(); iter != m_indices.end(); iter++) {
+        openFile->writeL16(*iter);
+    }
+
+    delete openFile;
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef ILL_CONVERTER_OCCLUDER_H_
+#define ILL_CONVERTER_OCCLUDER_H_
+
+#include <stdint.h>
+#include <vector>
+#include <glm/glm.hpp>
+
+class Mesh;
+
+/**
+Low poly occluder geometry for software occlusion culling.
+
+The mesh gets voxelized and the voxels that are completely inside the surface get merged into boxes.
+The biggest boxes that fit in the triangle budget become the occluder, so it is always closed and never sticks out of the real mesh.
+This only works for meshes that are closed themselves, anything with holes ends up with an empty occluder.
+*/
+class Occluder {
+public:
+    Occluder()
+        : m_resolution(32),
+        m_triangleBudget(120)
+    {}
+
+    //rigid meshes get voxelized in bone space, the space they're saved in
+    void import(const Mesh * mesh);
+    void save(const char * path) const;
+
+    unsigned int m_resolution;          //number of voxels along the longest side of the mesh bounds
+    unsigned int m_triangleBudget;      //each box takes 12 triangles
+
+    std::vector<glm::vec3> m_vertices;
+    std::vector<uint16_t> m_indices;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <dirent.h>
+#endif
+
+#include "Reoptimizer.h"
+#include "MeshBuffer.h"
+#include "parallel.h"
+
+#include "illEngine/Logging/logging.h"
+
+bool isDirectory(const char * path) {
+    struct stat info;
+    return stat(path, &info) == 0 && (info.st_mode & S_IFDIR) != 0;
+}
+
+//moves a file over another one, replacing it in one step
+bool replaceFile(const char * source, const char * destination) {
+#ifdef _WIN32
+    return MoveFileExA(source, destination, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(source, destination) == 0;
+#endif
+}
+
+//recursively finds all regular files in a directory
+void findFiles(const std::string& directory, std::vector<std::string>& files) {
+#ifdef _WIN32
+    _finddata_t findData;
+    intptr_t handle = _findfirst((directory + "/*").c_str(), &findData);
+
+    if(handle == -1) {
+        return;
+    }
+
+    do {
+        std::string name(findData.name);
+
+        if(name == "." || name == "..") {
+            continue;
+        }
+
+        if(findData.attrib & _A_SUBDIR) {
+            findFiles(directory + "/" + name, files);
+        }
+        else {
+            files.push_back(directory + "/" + name);
+        }
+    } while(_findnext(handle, &findData) == 0);
+
+    _findclose(handle);
+#else
+    DIR * dir = opendir(directory.c_str());
+
+    if(!dir) {
+        return;
+    }
+
+    while(dirent * entry = readdir(dir)) {
+        std::string name(entry->d_name);
+
+        if(name == "." || name == "..") {
+            continue;
+        }
+
+        std::string path = directory + "/" + name;
+
+        if(isDirectory(path.c_str())) {
+            findFiles(path, files);
+        }
+        else {
+            files.push_back(path);
+        }
+    }
+
+    closedir(dir);
+#endif
+}
+
+void Reoptimizer::reoptimize() {
+    std::vector<std::string> files;
+    std::vector<bool> fromDirectory;        //files found while searching directories can be anything, don't complain if they aren't meshes
+
+    for(auto iter = m_paths.cbegin(); iter != m_paths.end(); iter++) {
+        if(isDirectory(iter->c_str())) {
+            size_t numFound = files.size();
+            findFiles(*iter, files);
+            fromDirectory.resize(files.size(), true);
+
+            LOG_INFO("Found %u files in directory %s", (unsigned int) (files.size() - numFound), iter->c_str());
+        }
+        else {
+            files.push_back(*iter);
+            fromDirectory.push_back(false);
+        }
+    }
+
+    std::mutex logMutex;                    //the logger isn't meant to be used from multiple threads
+    std::atomic<unsigned int> numOptimized(0);
+    std::atomic<unsigned int> numFailed(0);
+
+    parallelFor(files.size(), m_numThreads, [&] (size_t file) {
+        const char * path = files[file].c_str();
+
+        try {
+            if(!MeshBuffer::isMeshFile(path)) {
+                if(!fromDirectory[file]) {
+                    std::lock_guard<std::mutex> lock(logMutex);
+                    LOG_INFO("Warning: %s is not an ILLMESH1 file, skipping", path);
+                }
+
+                return;
+            }
+
+            MeshBuffer mesh;
+            mesh.load(path);
+
+            uint32_t numVerticesBefore = mesh.m_numVertices;
+            float acmrBefore = MeshOptimizer::computeAcmr(mesh, m_optimizer.m_cacheSize);
+
+            m_optimizer.optimize(mesh);
+
+            //the meshes are often the only copy left, so write next to it and only replace it once the write is done
+            std::string tempPath = files[file] + ".tmp";
+
+            try {
+                mesh.save(tempPath.c_str());
+            }
+            catch(...) {
+                remove(tempPath.c_str());
+                throw;
+            }
+
+            if(!replaceFile(tempPath.c_str(), path)) {
+                remove(tempPath.c_str());
+                LOG_FATAL_ERROR("Couldn't replace %s with the reoptimized mesh", path);
+            }
+
+            numOptimized++;
+
+            std::lock_guard<std::mutex> lock(logMutex);
+            LOG_INFO("Reoptimized %s: %u -> %u vertices, ACMR %.3f -> %.3f", path,
+                numVerticesBefore, mesh.m_numVertices,
+                acmrBefore, MeshOptimizer::computeAcmr(mesh, m_optimizer.m_cacheSize));
+        }
+        catch(...) {
+            numFailed++;
+
+            std::lock_guard<std::mutex> lock(logMutex);
+            LOG_INFO("Warning: failed to reoptimize %s", path);
+        }
+    });
+
+    LOG_INFO("Reoptimized %u meshes", numOptimized.load());
+
+    if(numFailed > 0) {
+        LOG_FATAL_ERROR("%u meshes failed to reoptimize", numFailed.load());
+    }
+}
\ No newline at end of file
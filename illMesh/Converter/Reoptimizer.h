@@ -0,0 +1,26 @@
+#ifndef ILL_CONVERTER_REOPTIMIZER_H_
+#define ILL_CONVERTER_REOPTIMIZER_H_
+
+#include <string>
+#include <vector>
+
+#include "MeshOptimizer.h"
+
+/**
+Runs the mesh optimization passes on already exported ILLMESH1 files and writes them back in place.
+This is for upgrading meshes whose original source files are long gone.
+*/
+class Reoptimizer {
+public:
+    Reoptimizer()
+        : m_numThreads(0)
+    {}
+
+    std::vector<std::string> m_paths;       //mesh files, or directories that get searched recursively for mesh files
+    MeshOptimizer m_optimizer;
+    unsigned int m_numThreads;              //0 means use the hardware thread count
+
+    void reoptimize();
+};
+
+#endif
\ No newline at end of file
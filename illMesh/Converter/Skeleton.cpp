@@ -1,7 +1,10 @@
+#include <algorithm>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 #include "Skeleton.h"
 #include "AnimSet.h"
+#include "../Runtime/PoseBuffer.h"
 
 #include "illEngine/FileSystem/FileSystem.h"
 #include "illEngine/FileSystem/File.h"
@@ -11,6 +14,86 @@
 #include "illEngine/Util/Geometry/Transform.h"
 
 const uint64_t SKEL_MAGIC = 0x494C4C534B454C30;		//ILLSKEL0 in 64 bit big endian
+const uint64_t SKEL_MAGIC_1 = 0x494C4C534B454C31;		//ILLSKEL1 in 64 bit big endian
+const uint64_t SKEL_MAGIC_2 = 0x494C4C534B454C32;		//ILLSKEL2 in 64 bit big endian
+
+//ILLSKEL2 flags
+const uint8_t SKEL_FLAG_MODEL_BIND = 1 << 0;       //has the model space bind transforms after the inverse binds
+const uint8_t SKEL_FLAG_LODS = 1 << 1;             //has the number of bones in each bone LOD after the evaluation order
+
+//floats per bone in the ILLSKEL2 arrays
+const unsigned int AFFINE_FLOATS = 12;             //3x4 row major
+const unsigned int TRS_FLOATS = 10;                //translation xyz, rotation quaternion xyzw, scale xyz
+
+/**
+Size of the ILLSKEL2 header up to the bind arrays, which start at the next multiple of 16 bytes
+so they can be used straight out of a memory mapped file.
+*/
+size_t computeSkeletonHeaderSize(size_t numBones, size_t numLevels, size_t numLods) {
+    return 8                //magic
+        + 2                 //number of bones
+        + 1                 //flags
+        + 2 * numBones      //parents
+        + 2                 //number of levels
+        + 4 * numLevels     //levels
+        + 2 * numBones      //evaluation order
+        + (numLods ? 1 + 2 * numLods : 0);     //bone LODs
+}
+
+size_t computeSkeletonPadding(size_t headerSize) {
+    return (16 - headerSize % 16) % 16;
+}
+
+void writeAffine(illFileSystem::File * openFile, const glm::mat4& transform) {
+    for(unsigned int matRow = 0; matRow < 3; matRow++) {
+        for(unsigned int matCol = 0; matCol < 4; matCol++) {
+            openFile->writeLF(transform[matCol][matRow]);
+        }
+    }
+}
+
+glm::mat4 readAffine(const float * data) {
+    glm::mat4 res;
+
+    for(unsigned int matRow = 0; matRow < 3; matRow++) {
+        for(unsigned int matCol = 0; matCol < 4; matCol++) {
+            res[matCol][matRow] = data[matRow * 4 + matCol];
+        }
+    }
+
+    res[0][3] = 0.0f;
+    res[1][3] = 0.0f;
+    res[2][3] = 0.0f;
+    res[3][3] = 1.0f;
+
+    return res;
+}
+
+//splits a transform into translation, rotation, and scale, bind poses don't have shear so nothing is lost
+void decomposeTransform(const glm::mat4& transform, glm::vec3& translation, glm::quat& rotation, glm::vec3& scale) {
+    translation = glm::vec3(transform[3].x, transform[3].y, transform[3].z);
+
+    glm::mat3 rotationMat(transform);
+
+    scale = glm::vec3(glm::length(rotationMat[0]), glm::length(rotationMat[1]), glm::length(rotationMat[2]));
+
+    //a mirrored transform gets a negative scale on one axis
+    if(glm::determinant(rotationMat) < 0.0f) {
+        scale.x = -scale.x;
+    }
+
+    for(unsigned int axis = 0; axis < 3; axis++) {
+        if(scale[axis] != 0.0f) {
+            rotationMat[axis] /= scale[axis];
+        }
+    }
+
+    rotation = glm::normalize(glm::quat_cast(rotationMat));
+}
+
+glm::mat4 composeTransform(const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale) {
+    return glm::scale(glm::translate(glm::mat4(), translation) * glm::mat4_cast(rotation), scale);
+}
 
 void Skeleton::load(const char * path, const aiScene * scene) {
     m_scene = scene;
@@ -18,12 +101,23 @@ void Skeleton::load(const char * path, const aiScene * scene) {
     illFileSystem::File * openFile = illFileSystem::fileSystem->openRead(path);
 	
 	//read magic string
+    unsigned int version;
+
     {
 		uint64_t magic;
         openFile->readB64(magic);
 
-        if(magic != SKEL_MAGIC) {
-            LOG_FATAL_ERROR("Not a valid ILLSKEL0 file.");      //TODO: make this not fatal somehow, I guess all meshes would be in their rest pose if they're supposed to have an associated skeleton
+        if(magic == SKEL_MAGIC) {
+            version = 0;
+        }
+        else if(magic == SKEL_MAGIC_1) {
+            version = 1;
+        }
+        else if(magic == SKEL_MAGIC_2) {
+            version = 2;
+        }
+        else {
+            LOG_FATAL_ERROR("Not a valid ILLSKEL0, ILLSKEL1, or ILLSKEL2 file.");      //TODO: make this not fatal somehow, I guess all meshes would be in their rest pose if they're supposed to have an associated skeleton
         }
     }
 	
@@ -34,8 +128,14 @@ void Skeleton::load(const char * path, const aiScene * scene) {
 		m_bones.resize(numBones);
 	}
 
-    //read the bind poses and offsets
-    for(unsigned bone = 0; bone < m_bones.size(); bone++) {
+    uint8_t flags = 0;
+
+    if(version >= 2) {
+        openFile->read8(flags);
+    }
+
+    //read the bind poses and offsets, version 2 has them after the heirarchy
+    for(unsigned bone = 0; bone < m_bones.size() && version < 2; bone++) {
         //bind
         for(unsigned int matCol = 0; matCol < 4; matCol++) {
             for(unsigned int matRow = 0; matRow < 4; matRow++) {
@@ -51,23 +151,152 @@ void Skeleton::load(const char * path, const aiScene * scene) {
         }
     }
     
-    //no need to read the heirarchy, that gets computed separately in the animset stage, a bit weird...
-	//TODO: never mind, I need to import the heirarchy later	
+    //read the heirarchy
+    m_parents.resize(m_bones.size());
+
+    for(unsigned bone = 0; bone < m_bones.size(); bone++) {
+        openFile->readL16(m_parents[bone]);
+    }
+
+    //version 1 has the levels precomputed
+    if(version >= 1) {
+        uint16_t numLevels;
+        openFile->readL16(numLevels);
+        m_levels.resize(numLevels);
+
+        for(uint16_t level = 0; level < numLevels; level++) {
+            openFile->readL16(m_levels[level].m_begin);
+            openFile->readL16(m_levels[level].m_count);
+        }
+
+        m_evaluationOrder.resize(m_bones.size());
+
+        for(unsigned bone = 0; bone < m_bones.size(); bone++) {
+            openFile->readL16(m_evaluationOrder[bone]);
+        }
+    }
+    else {
+        computeLevels();
+    }
+
+    //version 2 can have the bone LODs
+    m_lodNumBones.clear();
+
+    if(flags & SKEL_FLAG_LODS) {
+        uint8_t numLods;
+        openFile->read8(numLods);
+        m_lodNumBones.resize(numLods);
+
+        for(uint8_t lod = 0; lod < numLods; lod++) {
+            openFile->readL16(m_lodNumBones[lod]);
+        }
+    }
+
+    //version 2 has the compact bind arrays, all read in one go
+    if(version >= 2) {
+        openFile->seekAhead(computeSkeletonPadding(computeSkeletonHeaderSize(m_bones.size(), m_levels.size(), m_lodNumBones.size())));
+
+        size_t numArrays = (flags & SKEL_FLAG_MODEL_BIND) ? 2 : 1;
+        std::vector<float> data(m_bones.size() * (AFFINE_FLOATS * numArrays + TRS_FLOATS));
+
+        //the floats are little endian like the rest of the file, a skeleton with no bones has none
+        if(!data.empty()) {
+            openFile->read(&data[0], data.size() * sizeof(float));
+
+            const float * inverseBinds = &data[0];
+            const float * trs = inverseBinds + m_bones.size() * AFFINE_FLOATS * numArrays;
+
+            for(unsigned bone = 0; bone < m_bones.size(); bone++) {
+                m_bones[bone].m_offsetTransform = readAffine(inverseBinds + bone * AFFINE_FLOATS);
+
+                const float * boneTrs = trs + bone * TRS_FLOATS;
+
+                m_bones[bone].m_relativeTransform = composeTransform(
+                    glm::vec3(boneTrs[0], boneTrs[1], boneTrs[2]),
+                    glm::quat(boneTrs[6], boneTrs[3], boneTrs[4], boneTrs[5]),
+                    glm::vec3(boneTrs[7], boneTrs[8], boneTrs[9]));
+            }
+        }
+    }
 
 	delete openFile;
 }
 
-//a nice lazy way to get the full transform, very inefficient, but I don't feel like computing a heirarchy tree from the parent list
-glm::mat4 getFullTransform(uint16_t boneIndex, const std::map<uint16_t, uint16_t>& boneParentMap, const Skeleton::Bone * bones) {
-    //get parent index
-    auto parentIndIter = boneParentMap.find(boneIndex);
+void Skeleton::computeLevels() {
+    uint16_t numBones = (uint16_t) m_parents.size();
+
+    //depth of each bone, walking up only as far as a bone whose depth is already known
+    std::vector<int> depths(numBones, -1);
+    std::vector<uint16_t> chain;
+    int maxDepth = -1;
+
+    for(uint16_t bone = 0; bone < numBones; bone++) {
+        uint16_t currBone = bone;
+        chain.clear();
+
+        while(depths[currBone] < 0) {
+            chain.push_back(currBone);
+
+            if(m_parents[currBone] == currBone) {
+                break;
+            }
 
-    //if root
-    if(parentIndIter == boneParentMap.end() || boneIndex == parentIndIter->second) {
-        return bones[boneIndex].m_relativeTransform;
+            currBone = m_parents[currBone];
+        }
+
+        int depth = depths[currBone] < 0 ? -1 : depths[currBone];
+
+        for(auto iter = chain.rbegin(); iter != chain.rend(); iter++) {
+            depths[*iter] = ++depth;
+        }
+
+        maxDepth = std::max(maxDepth, depths[bone]);
     }
-    else {
-        return getFullTransform(parentIndIter->second, boneParentMap, bones) * bones[boneIndex].m_relativeTransform;
+
+    //bucket the bones by depth, in index order within a depth
+    m_levels.assign(maxDepth + 1, Level());
+
+    for(uint16_t bone = 0; bone < numBones; bone++) {
+        m_levels[depths[bone]].m_count++;
+    }
+
+    for(size_t level = 1; level < m_levels.size(); level++) {
+        m_levels[level].m_begin = m_levels[level - 1].m_begin + m_levels[level - 1].m_count;
+    }
+
+    m_evaluationOrder.resize(numBones);
+
+    {
+        std::vector<uint16_t> levelFill(m_levels.size(), 0);
+
+        for(uint16_t bone = 0; bone < numBones; bone++) {
+            m_evaluationOrder[m_levels[depths[bone]].m_begin + levelFill[depths[bone]]++] = bone;
+        }
+    }
+}
+
+void Skeleton::getBindPose(PoseBuffer& pose) const {
+    pose.resize((uint16_t) m_bones.size());
+
+    for(uint16_t bone = 0; bone < (uint16_t) m_bones.size(); bone++) {
+        glm::vec3 translation;
+        glm::quat rotation;
+        glm::vec3 scale;
+
+        decomposeTransform(m_bones[bone].m_relativeTransform, translation, rotation, scale);
+        pose.setBone(bone, translation, rotation, scale);
+    }
+}
+
+void Skeleton::getInverseBindTransforms(std::vector<float>& inverseBinds) const {
+    inverseBinds.resize(m_bones.size() * AFFINE_FLOATS);
+
+    for(uint16_t bone = 0; bone < (uint16_t) m_bones.size(); bone++) {
+        for(unsigned int matRow = 0; matRow < 3; matRow++) {
+            for(unsigned int matCol = 0; matCol < 4; matCol++) {
+                inverseBinds[bone * AFFINE_FLOATS + matRow * 4 + matCol] = m_bones[bone].m_offsetTransform[matCol][matRow];
+            }
+        }
     }
 }
 
@@ -76,9 +305,11 @@ void Skeleton::import(const aiScene * scene, const AnimSet * animset) {
     const AnimSet::SceneBoneData& sceneBoneData = animset->m_sceneBoneData.at(scene);
 
     //allocate space for the bones
-    uint16_t numBones = (uint16_t) animset->m_boneNameMap.size();
+    uint16_t numBones = (uint16_t) animset->m_boneRegistry.size();
     m_bones.resize(numBones);
 
+    m_lodNumBones = animset->m_lodNumBones;
+
     //get their bind pose transforms
     for(uint16_t bone = 0; bone < numBones; bone++) {
         auto boneNodeIter = sceneBoneData.m_boneIndexNodes.find(bone);
@@ -87,37 +318,61 @@ void Skeleton::import(const aiScene * scene, const AnimSet * animset) {
             m_bones[bone].m_relativeTransform = glm::mat4();
         }
         else {
+            //pruned nodes above this bone get folded into its bind transform
+            aiMatrix4x4 nodeTransform = animset->computeCollapsedTransform(boneNodeIter->second) * boneNodeIter->second->mTransformation;
+
             m_bones[bone].m_relativeTransform = glm::mat4(
-                glm::vec4(boneNodeIter->second->mTransformation[0][0], 
-                    boneNodeIter->second->mTransformation[1][0], 
-                    boneNodeIter->second->mTransformation[2][0], 
-                    boneNodeIter->second->mTransformation[3][0]),
+                glm::vec4(nodeTransform[0][0], 
+                    nodeTransform[1][0], 
+                    nodeTransform[2][0], 
+                    nodeTransform[3][0]),
 
-                glm::vec4(boneNodeIter->second->mTransformation[0][1], 
-                    boneNodeIter->second->mTransformation[1][1], 
-                    boneNodeIter->second->mTransformation[2][1], 
-                    boneNodeIter->second->mTransformation[3][1]),
+                glm::vec4(nodeTransform[0][1], 
+                    nodeTransform[1][1], 
+                    nodeTransform[2][1], 
+                    nodeTransform[3][1]),
 
-                glm::vec4(boneNodeIter->second->mTransformation[0][2], 
-                    boneNodeIter->second->mTransformation[1][2], 
-                    boneNodeIter->second->mTransformation[2][2], 
-                    boneNodeIter->second->mTransformation[3][2]),
+                glm::vec4(nodeTransform[0][2], 
+                    nodeTransform[1][2], 
+                    nodeTransform[2][2], 
+                    nodeTransform[3][2]),
 
-                glm::vec4(boneNodeIter->second->mTransformation[0][3], 
-                    boneNodeIter->second->mTransformation[1][3], 
-                    boneNodeIter->second->mTransformation[2][3], 
-                    boneNodeIter->second->mTransformation[3][3]));
+                glm::vec4(nodeTransform[0][3], 
+                    nodeTransform[1][3], 
+                    nodeTransform[2][3], 
+                    nodeTransform[3][3]));
         }
 
         //dirty hack to try rotating the skeleton 90 degrees
-        /*if(animset->m_boneNameMap.at("origin") == bone) {
+        /*if(animset->m_boneRegistry.at("origin") == bone) {
             m_bones[bone].m_relativeTransform = glm::rotate(m_bones[bone].m_relativeTransform, -90.0f, glm::vec3(0.0f, 1.0f, 0.0f));
         }*/
     }
 
-    //get their bone offsets, this is the inverse of the full bind pose
+    //get the heirarchy
+    m_parents.resize(numBones);
+
     for(uint16_t bone = 0; bone < numBones; bone++) {
-        m_bones[bone].m_offsetTransform = glm::inverse(getFullTransform(bone, animset->m_boneParentIndeces, &m_bones[0]));
+        auto parentIndIter = animset->m_boneParentIndeces.find(bone);
+
+        m_parents[bone] = parentIndIter == animset->m_boneParentIndeces.end()
+            ? bone
+            : parentIndIter->second;
+    }
+
+    computeLevels();
+
+    //get their bone offsets, this is the inverse of the full bind pose, parents get their full transform before their children need it
+    std::vector<glm::mat4> fullTransforms(numBones);
+
+    for(auto iter = m_evaluationOrder.cbegin(); iter != m_evaluationOrder.end(); iter++) {
+        uint16_t bone = *iter;
+
+        fullTransforms[bone] = m_parents[bone] == bone
+            ? m_bones[bone].m_relativeTransform
+            : fullTransforms[m_parents[bone]] * m_bones[bone].m_relativeTransform;
+
+        m_bones[bone].m_offsetTransform = glm::inverse(fullTransforms[bone]);
     }
 }
 
@@ -125,12 +380,34 @@ void Skeleton::save(const char * path, const AnimSet * animset) const {
     illFileSystem::File * openFile = illFileSystem::fileSystem->openWrite(path);
 	
 	//write magic string
-    openFile->writeB64(SKEL_MAGIC);
+    switch(m_version) {
+    case 0:
+        openFile->writeB64(SKEL_MAGIC);
+        break;
+
+    case 1:
+        openFile->writeB64(SKEL_MAGIC_1);
+        break;
+
+    case 2:
+        openFile->writeB64(SKEL_MAGIC_2);
+        break;
+
+    default:
+        LOG_FATAL_ERROR("Can't save skeleton version %u", m_version);
+        break;
+    }
     	
     //write number of bones
     openFile->writeL16(m_bones.size());
 
-    for(uint16_t bone = 0; bone < (uint16_t) m_bones.size(); bone++) {
+    if(m_version >= 2) {
+        openFile->write8((m_saveModelBind ? SKEL_FLAG_MODEL_BIND : 0)
+            | (m_lodNumBones.empty() ? 0 : SKEL_FLAG_LODS));
+    }
+
+    //version 2 has the bind poses and offsets after the heirarchy
+    for(uint16_t bone = 0; bone < (uint16_t) m_bones.size() && m_version < 2; bone++) {
         //bind
         for(unsigned int matCol = 0; matCol < 4; matCol++) {
             for(unsigned int matRow = 0; matRow < 4; matRow++) {
@@ -148,22 +425,79 @@ void Skeleton::save(const char * path, const AnimSet * animset) const {
     
     //write the heirarchy
     for(uint16_t bone = 0; bone < (uint16_t) m_bones.size(); bone++) {
-        //get parent index
-        auto parentIndIter = animset->m_boneParentIndeces.find(bone);
+        openFile->writeL16(m_parents[bone]);
+    }
 
-        //LOG_DEBUG("Bone number %u", bone);
+    //write the levels so runtimes can go through the bones in one pass or a level at a time
+    if(m_version >= 1) {
+        openFile->writeL16((uint16_t) m_levels.size());
 
-        //if root
-        if(parentIndIter == animset->m_boneParentIndeces.end() 
-            || bone == parentIndIter->second) {
-            //LOG_DEBUG("Root");
-            openFile->writeL16(bone);
+        for(auto iter = m_levels.cbegin(); iter != m_levels.end(); iter++) {
+            openFile->writeL16(iter->m_begin);
+            openFile->writeL16(iter->m_count);
         }
-        else {
-            //LOG_DEBUG("Parent %u", parentIndIter->second);
-            openFile->writeL16(parentIndIter->second);
+
+        for(auto iter = m_evaluationOrder.cbegin(); iter != m_evaluationOrder.end(); iter++) {
+            openFile->writeL16(*iter);
+        }
+    }
+
+    //bone LODs, each LOD is the first however many bones
+    if(m_version >= 2 && !m_lodNumBones.empty()) {
+        openFile->write8((uint8_t) m_lodNumBones.size());
+
+        for(auto iter = m_lodNumBones.cbegin(); iter != m_lodNumBones.end(); iter++) {
+            openFile->writeL16(*iter);
+        }
+    }
+
+    //write the compact bind arrays, aligned to 16 bytes
+    if(m_version >= 2) {
+        for(size_t pad = computeSkeletonPadding(computeSkeletonHeaderSize(m_bones.size(), m_levels.size(), m_lodNumBones.size())); pad > 0; pad--) {
+            openFile->write8(0);
+        }
+
+        //inverse binds
+        for(uint16_t bone = 0; bone < (uint16_t) m_bones.size(); bone++) {
+            writeAffine(openFile, m_bones[bone].m_offsetTransform);
+        }
+
+        //model space binds, computed parents first
+        if(m_saveModelBind) {
+            std::vector<glm::mat4> modelTransforms(m_bones.size());
+
+            for(auto iter = m_evaluationOrder.cbegin(); iter != m_evaluationOrder.end(); iter++) {
+                modelTransforms[*iter] = m_parents[*iter] == *iter
+                    ? m_bones[*iter].m_relativeTransform
+                    : modelTransforms[m_parents[*iter]] * m_bones[*iter].m_relativeTransform;
+            }
+
+            for(uint16_t bone = 0; bone < (uint16_t) m_bones.size(); bone++) {
+                writeAffine(openFile, modelTransforms[bone]);
+            }
+        }
+
+        //relative bind poses
+        for(uint16_t bone = 0; bone < (uint16_t) m_bones.size(); bone++) {
+            glm::vec3 translation;
+            glm::quat rotation;
+            glm::vec3 scale;
+
+            decomposeTransform(m_bones[bone].m_relativeTransform, translation, rotation, scale);
+
+            openFile->writeLF(translation.x);
+            openFile->writeLF(translation.y);
+            openFile->writeLF(translation.z);
+
+            openFile->writeLF(rotation.x);
+            openFile->writeLF(rotation.y);
+            openFile->writeLF(rotation.z);
+            openFile->writeLF(rotation.w);
+
+            openFile->writeLF(scale.x);
+            openFile->writeLF(scale.y);
+            openFile->writeLF(scale.z);
         }
-        
     }
 		
 	delete openFile;
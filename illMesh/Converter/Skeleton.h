@@ -4,13 +4,23 @@
 #include <glm/glm.hpp>
 #include <set>
 #include <string>
+#include <vector>
+#include <map>
+#include <stdint.h>
 #include <assimp/scene.h>
 #include "illEngine/Util/serial/Array.h"
 
 class AnimSet;
+class PoseBuffer;
 
 class Skeleton {
 public:
+    Skeleton()
+        : m_scene(NULL),
+        m_version(0),
+        m_saveModelBind(false)
+    {}
+
     void load(const char * path, const aiScene * scene);
     void save(const char * path, const AnimSet * animset) const;
 
@@ -24,6 +34,29 @@ public:
     };
 
     Array<Bone> m_bones;
+
+    struct Level {
+        uint16_t m_begin;       //index into m_evaluationOrder
+        uint16_t m_count;
+    };
+
+    //computes the evaluation order and levels from the parents
+    void computeLevels();
+
+    //the relative bind transforms of all the bones as a pose for the runtime pose code
+    void getBindPose(PoseBuffer& pose) const;
+
+    //the inverse bind transforms of all the bones as 3x4 row major transforms for the runtime pose code
+    void getInverseBindTransforms(std::vector<float>& inverseBinds) const;
+
+    std::vector<uint16_t> m_parents;            //parent of each bone, roots are their own parent
+    std::vector<uint16_t> m_evaluationOrder;    //the bones ordered by depth, parents always come before their children
+    std::vector<Level> m_levels;                //ranges of m_evaluationOrder with all the bones at the same depth
+
+    std::vector<uint16_t> m_lodNumBones;        //how many bones each bone LOD keeps, they're always the first bones, empty if there are no LODs
+
+    unsigned int m_version;     //skeleton file version to save as
+    bool m_saveModelBind;       //version 2 and up can also have the model space bind transforms precomputed
 };
 
 #endif
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include <glm/gtc/quaternion.hpp>
 
+#include <algorithm>
 #include <stdint.h>
+#include <vector>
 #include "asciiDump.h"
 #include "illEngine/FileSystem/FileSystem.h"
 #include "illEngine/FileSystem/File.h"
@@ -8,15 +10,36 @@
 #include "illEngine/Util/serial/Array.h"
 #include "illEngine/Util/Geometry/MeshData.h"
 
+#include "../Runtime/AnimationCodec.h"
+
 const uint64_t ANIM_MAGIC = 0x494C4C414E494D30;		    //ILLANIM0 in 64 bit big endian
+const uint64_t ANIM_MAGIC_1 = 0x494C4C414E494D31;		    //ILLANIM1 in 64 bit big endian
+const uint64_t ANIM_MAGIC_2 = 0x494C4C414E494D32;		    //ILLANIM2 in 64 bit big endian
+const uint64_t ANIM_MAGIC_3 = 0x494C4C414E494D33;		    //ILLANIM3 in 64 bit big endian
 const uint64_t ANIMSET_MAGIC = 0x494C414E53455430;		//ILANSET0 in 64 bit big endian
+const uint64_t ANIMSET_MAGIC_1 = 0x494C414E53455431;		//ILANSET1 in 64 bit big endian
 const uint64_t MESH_MAGIC = 0x494C4C4D45534831;	        //ILLMESH1 in 64 bit big endian
 const uint64_t SKEL_MAGIC = 0x494C4C534B454C30;		    //ILLSKEL0 in 64 bit big endian
-
-void dumpAnimset(illFileSystem::File * openFile);
-void dumpAnimation(illFileSystem::File * openFile);
-void dumpSkeleton(illFileSystem::File * openFile);
+const uint64_t SKEL_MAGIC_1 = 0x494C4C534B454C31;		    //ILLSKEL1 in 64 bit big endian
+const uint64_t SKEL_MAGIC_2 = 0x494C4C534B454C32;		    //ILLSKEL2 in 64 bit big endian
+const uint64_t OCCLUDER_MAGIC = 0x494C4C4F43434C30;	    //ILLOCCL0 in 64 bit big endian
+const uint64_t COLLISION_MAGIC = 0x494C4C434F4C4C30;	    //ILLCOLL0 in 64 bit big endian
+const uint64_t MESH_GROUPS_MAGIC_0 = 0x494C4C4D47525030;	//ILLMGRP0 in 64 bit big endian
+const uint64_t MESH_GROUPS_MAGIC = 0x494C4C4D47525031;	    //ILLMGRP1 in 64 bit big endian
+const uint64_t MORPH_MAGIC = 0x494C4C4D52504830;	        //ILLMRPH0 in 64 bit big endian
+const uint64_t BAKE_MAGIC = 0x494C4C42414B4530;	        //ILLBAKE0 in 64 bit big endian
+const uint64_t ANIM_DATABASE_MAGIC = 0x494C4C414E444230;	//ILLANDB0 in 64 bit big endian
+
+void dumpAnimset(illFileSystem::File * openFile, unsigned int version);
+void dumpAnimation(illFileSystem::File * openFile, unsigned int version);
+void dumpSkeleton(illFileSystem::File * openFile, unsigned int version);
 void dumpMesh(illFileSystem::File * openFile);
+void dumpOccluder(illFileSystem::File * openFile);
+void dumpCollision(illFileSystem::File * openFile);
+void dumpMeshGroups(illFileSystem::File * openFile, unsigned int version);
+void dumpMorphs(illFileSystem::File * openFile);
+void dumpBake(illFileSystem::File * openFile);
+void dumpAnimationDatabase(illFileSystem::File * openFile);
 
 void asciiDump(const char * path) {
     illFileSystem::File * openFile = illFileSystem::fileSystem->openRead(path);
@@ -29,12 +52,32 @@ void asciiDump(const char * path) {
         switch(magic) {
         case ANIM_MAGIC:
             LOG_INFO("Dumping contents of Animation file %s\n", path);
-            dumpAnimation(openFile);
+            dumpAnimation(openFile, 0);
+            break;
+
+        case ANIM_MAGIC_1:
+            LOG_INFO("Dumping contents of Animation version 1 file %s\n", path);
+            dumpAnimation(openFile, 1);
+            break;
+
+        case ANIM_MAGIC_2:
+            LOG_INFO("Dumping contents of Animation version 2 file %s\n", path);
+            dumpAnimation(openFile, 2);
+            break;
+
+        case ANIM_MAGIC_3:
+            LOG_INFO("Dumping contents of Animation version 3 file %s\n", path);
+            dumpAnimation(openFile, 3);
             break;
 
         case ANIMSET_MAGIC:
             LOG_INFO("Dumping contents of Animation Set file %s\n", path);
-            dumpAnimset(openFile);
+            dumpAnimset(openFile, 0);
+            break;
+
+        case ANIMSET_MAGIC_1:
+            LOG_INFO("Dumping contents of Animation Set version 1 file %s\n", path);
+            dumpAnimset(openFile, 1);
             break;
 
         case MESH_MAGIC:
@@ -44,11 +87,56 @@ void asciiDump(const char * path) {
 
         case SKEL_MAGIC:
             LOG_INFO("Dumping contents of Skeleton file %s\n", path);
-            dumpSkeleton(openFile);
+            dumpSkeleton(openFile, 0);
+            break;
+
+        case SKEL_MAGIC_1:
+            LOG_INFO("Dumping contents of Skeleton version 1 file %s\n", path);
+            dumpSkeleton(openFile, 1);
+            break;
+
+        case SKEL_MAGIC_2:
+            LOG_INFO("Dumping contents of Skeleton version 2 file %s\n", path);
+            dumpSkeleton(openFile, 2);
+            break;
+
+        case OCCLUDER_MAGIC:
+            LOG_INFO("Dumping contents of Occluder file %s\n", path);
+            dumpOccluder(openFile);
+            break;
+
+        case COLLISION_MAGIC:
+            LOG_INFO("Dumping contents of Collision file %s\n", path);
+            dumpCollision(openFile);
+            break;
+
+        case MESH_GROUPS_MAGIC_0:
+            LOG_INFO("Dumping contents of Mesh Groups version 0 file %s\n", path);
+            dumpMeshGroups(openFile, 0);
+            break;
+
+        case MESH_GROUPS_MAGIC:
+            LOG_INFO("Dumping contents of Mesh Groups file %s\n", path);
+            dumpMeshGroups(openFile, 1);
+            break;
+
+        case MORPH_MAGIC:
+            LOG_INFO("Dumping contents of Morph Targets file %s\n", path);
+            dumpMorphs(openFile);
+            break;
+
+        case BAKE_MAGIC:
+            LOG_INFO("Dumping contents of Animation Bake file %s\n", path);
+            dumpBake(openFile);
+            break;
+
+        case ANIM_DATABASE_MAGIC:
+            LOG_INFO("Dumping contents of Animation Database file %s\n", path);
+            dumpAnimationDatabase(openFile);
             break;
 
         default:
-            LOG_INFO("File %s is not a valid animset, animation, mesh, or skeleton file.", path);
+            LOG_INFO("File %s is not a valid animset, animation, mesh, skeleton, occluder, collision, mesh groups, morph targets, animation bake, or animation database file.", path);
             break;
         }
     }
@@ -56,29 +144,333 @@ void asciiDump(const char * path) {
     delete openFile;
 }
 
-void dumpAnimset(illFileSystem::File * openFile) {
+void dumpAnimset(illFileSystem::File * openFile, unsigned int version) {
     //num bones
     uint16_t numBones;
     openFile->readL16(numBones);
 
     LOG_INFO("%u bones\n", numBones);
 
-    //bone names
-    Array<char> strBuffer;
+    if(version >= 1) {
+        //name hash table
+        uint16_t numBuckets;
+        openFile->readL16(numBuckets);
 
-    for(uint16_t bone = 0; bone < numBones; bone++) {
-        uint16_t stringBufferLength = openFile->readStringBufferLength();			
-		strBuffer.reserve(stringBufferLength);
-		openFile->readString(&strBuffer[0], stringBufferLength);
+        LOG_INFO("%u hash buckets", numBuckets);
+
+        for(uint16_t bucket = 0; bucket < numBuckets; bucket++) {
+            uint32_t seed;
+            openFile->readL32(seed);
+
+            LOG_INFO("Bucket: %u Seed: %u", bucket, seed);
+        }
+
+        LOG_INFO("\n");
+
+        for(uint16_t slot = 0; slot < numBones; slot++) {
+            uint16_t bone;
+            openFile->readL16(bone);
+
+            LOG_INFO("Slot: %u Bone: %u", slot, bone);
+        }
+
+        LOG_INFO("\n");
+
+        if(numBones % 2) {
+            openFile->seekAhead(2);
+        }
+
+        //bone names
+        std::vector<uint32_t> nameOffsets(numBones + 1);
+
+        for(unsigned int bone = 0; bone <= numBones; bone++) {
+            openFile->readL32(nameOffsets[bone]);
+        }
+
+        std::vector<char> names(nameOffsets[numBones] + 1, 0);
+
+        if(nameOffsets[numBones] > 0) {
+            openFile->read(&names[0], nameOffsets[numBones]);
+        }
 
-        LOG_INFO("Bone: %u Name: %s", bone, &strBuffer[0]);
+        for(uint16_t bone = 0; bone < numBones; bone++) {
+            LOG_INFO("Bone: %u Offset: %u Name: %s", bone, nameOffsets[bone], &names[nameOffsets[bone]]);
+        }
+    }
+    else {
+        //bone names
+        Array<char> strBuffer;
+
+        for(uint16_t bone = 0; bone < numBones; bone++) {
+            uint16_t stringBufferLength = openFile->readStringBufferLength();			
+		    strBuffer.reserve(stringBufferLength);
+		    openFile->readString(&strBuffer[0], stringBufferLength);
+
+            LOG_INFO("Bone: %u Name: %s", bone, &strBuffer[0]);
+        }
     }
     
     LOG_INFO("\n");
     LOG_INFO("End of animation set file\n\n");
 }
 
-void dumpAnimation(illFileSystem::File * openFile) {
+//a position or scale channel of a version 1 animation
+void dumpQuantizedVectors(illFileSystem::File * openFile, float frameRate, const char * name) {
+    uint16_t keys;
+    openFile->readL16(keys);
+
+    LOG_INFO("%u %s Keys\n", keys, name);
+
+    if(keys == 0) {
+        return;
+    }
+
+    glm::vec3 min;
+    glm::vec3 extent;
+
+    openFile->readLF(min.x);
+    openFile->readLF(min.y);
+    openFile->readLF(min.z);
+    openFile->readLF(extent.x);
+    openFile->readLF(extent.y);
+    openFile->readLF(extent.z);
+
+    LOG_INFO("Range min (%f, %f, %f) extent (%f, %f, %f)", min.x, min.y, min.z, extent.x, extent.y, extent.z);
+
+    std::vector<uint16_t> frames(keys);
+
+    for(uint16_t key = 0; key < keys; key++) {
+        openFile->readL16(frames[key]);
+    }
+
+    size_t stride = simdRoundUp(keys);
+    std::vector<uint16_t> quantized(keys);
+    std::vector<float> decodeBuffer(stride * 3 + SIMD_WIDTH);
+    float * decoded = simdAlign(&decodeBuffer[0]);
+
+    for(unsigned int component = 0; component < 3; component++) {
+        for(uint16_t key = 0; key < keys; key++) {
+            openFile->readL16(quantized[key]);
+        }
+
+        decodeRange(&quantized[0], keys, min[component], extent[component], decoded + component * stride);
+    }
+
+    for(uint16_t key = 0; key < keys; key++) {
+        LOG_INFO("Frame %u Time %f %s (%f, %f, %f)", frames[key], frames[key] / frameRate, name,
+            decoded[key], decoded[stride + key], decoded[2 * stride + key]);
+    }
+}
+
+//a rotation channel of a version 1 animation
+void dumpQuantizedRotations(illFileSystem::File * openFile, float frameRate) {
+    uint16_t keys;
+    openFile->readL16(keys);
+
+    LOG_INFO("%u Rotation Keys\n", keys);
+
+    if(keys == 0) {
+        return;
+    }
+
+    std::vector<uint16_t> frames(keys);
+
+    for(uint16_t key = 0; key < keys; key++) {
+        openFile->readL16(frames[key]);
+    }
+
+    std::vector<uint16_t> components(keys * 3);
+
+    for(auto iter = components.begin(); iter != components.end(); iter++) {
+        openFile->readL16(*iter);
+    }
+
+    size_t stride = simdRoundUp(keys);
+    std::vector<float> decodeBuffer(stride * 4 + SIMD_WIDTH);
+    float * decoded = simdAlign(&decodeBuffer[0]);
+
+    decodeSmallestThree(&components[0], keys, decoded);
+
+    for(uint16_t key = 0; key < keys; key++) {
+        LOG_INFO("Frame %u Time %f Rotation quat XYZW (%f, %f, %f, %f)", frames[key], frames[key] / frameRate,
+            decoded[key], decoded[stride + key], decoded[2 * stride + key], decoded[3 * stride + key]);
+    }
+}
+
+//version 2 frames, each one has every channel of all the bones in a row, rotation xyzw, then position xyz, then scale xyz
+void dumpResampledFrames(illFileSystem::File * openFile, uint16_t numBones, float frameRate) {
+    uint32_t numFrames;
+    openFile->readL32(numFrames);
+
+    LOG_INFO("%u Frames\n", numFrames);
+
+    std::vector<float> frameData(numBones * 10);
+
+    for(uint32_t frame = 0; frame < numFrames; frame++) {
+        LOG_INFO("Frame %u Time %f", frame, frame / frameRate);
+
+        for(size_t value = 0; value < frameData.size(); value++) {
+            openFile->readLF(frameData[value]);
+        }
+
+        for(uint16_t bone = 0; bone < numBones; bone++) {
+            const float * channel = &frameData[bone];
+
+            LOG_INFO("Bone %u Rotation (%f, %f, %f, %f) Position (%f, %f, %f) Scale (%f, %f, %f)", bone,
+                channel[0], channel[numBones], channel[2 * numBones], channel[3 * numBones],
+                channel[4 * numBones], channel[5 * numBones], channel[6 * numBones],
+                channel[7 * numBones], channel[8 * numBones], channel[9 * numBones]);
+        }
+
+        LOG_INFO("\n");
+    }
+}
+
+//clips of an animation database, each quantized like version 1 with the tracks from the descriptors it has bits set for
+void dumpAnimationDatabase(illFileSystem::File * openFile) {
+    uint16_t alignment;
+    openFile->readL16(alignment);
+
+    uint16_t numDescriptors;
+    openFile->readL16(numDescriptors);
+
+    std::vector<uint16_t> descriptors(numDescriptors);
+
+    for(uint16_t descriptor = 0; descriptor < numDescriptors; descriptor++) {
+        openFile->readL16(descriptors[descriptor]);
+        LOG_INFO("Descriptor %u Bone index %u", descriptor, descriptors[descriptor]);
+    }
+
+    uint32_t numClips;
+    openFile->readL32(numClips);
+
+    uint32_t namesOffset;
+    openFile->readL32(namesOffset);
+
+    LOG_INFO("%u track descriptors, %u clips aligned to %u bytes, %u bytes of clips\n", numDescriptors, numClips, alignment, namesOffset);
+
+    struct Entry {
+        uint32_t m_hash;
+        uint32_t m_offset;
+        uint32_t m_size;
+        float m_duration;
+        float m_frameRate;
+        uint16_t m_flags;
+        uint16_t m_numTracks;
+    };
+
+    std::vector<Entry> entries(numClips);
+
+    for(uint32_t clip = 0; clip < numClips; clip++) {
+        Entry& entry = entries[clip];
+
+        openFile->readL32(entry.m_hash);
+        openFile->readL32(entry.m_offset);
+        openFile->readL32(entry.m_size);
+        openFile->readLF(entry.m_duration);
+        openFile->readLF(entry.m_frameRate);
+        openFile->readL16(entry.m_flags);
+        openFile->readL16(entry.m_numTracks);
+    }
+
+    uint32_t position = 8 + 2 + 2 + numDescriptors * 2 + 4 + 4 + numClips * 24;
+    uint32_t maskSize = (numDescriptors + 7) / 8;
+
+    for(uint32_t clip = 0; clip < numClips; clip++) {
+        const Entry& entry = entries[clip];
+
+        openFile->seekAhead(entry.m_offset - position);
+        position = entry.m_offset + entry.m_size;
+
+        LOG_INFO("Clip %u name hash %08X at %u, %u bytes, duration %f, %f FPS, %u tracks%s\n", clip, entry.m_hash, entry.m_offset, entry.m_size,
+            entry.m_duration, entry.m_frameRate, entry.m_numTracks, (entry.m_flags & 1) ? ", keys relative to the bind pose" : "");
+
+        std::vector<uint8_t> mask(maskSize);
+
+        for(uint32_t byte = 0; byte < maskSize; byte++) {
+            openFile->read8(mask[byte]);
+        }
+
+        for(uint16_t descriptor = 0; descriptor < numDescriptors; descriptor++) {
+            if(!(mask[descriptor >> 3] & (1 << (descriptor & 7)))) {
+                continue;
+            }
+
+            LOG_INFO("Bone index %u\n", descriptors[descriptor]);
+
+            dumpQuantizedVectors(openFile, entry.m_frameRate, "Position");
+            LOG_INFO("\n");
+
+            dumpQuantizedRotations(openFile, entry.m_frameRate);
+            LOG_INFO("\n");
+
+            dumpQuantizedVectors(openFile, entry.m_frameRate, "Scale");
+            LOG_INFO("\n");
+        }
+    }
+
+    Array<char> strBuffer;
+
+    for(uint32_t clip = 0; clip < numClips; clip++) {
+        uint16_t stringBufferLength = openFile->readStringBufferLength();
+        strBuffer.reserve(stringBufferLength);
+        openFile->readString(&strBuffer[0], stringBufferLength);
+
+        LOG_INFO("Clip %u Name: %s", clip, &strBuffer[0]);
+    }
+
+    LOG_INFO("\n");
+}
+
+//version 3 segments, the bones and segment offsets are in the header and each segment has its keys quantized like version 1
+void dumpSegments(illFileSystem::File * openFile, float frameRate) {
+    uint16_t segmentFrames;
+    openFile->readL16(segmentFrames);
+
+    LOG_INFO("Segment length %u frames", segmentFrames);
+
+    uint16_t numBones;
+    openFile->readL16(numBones);
+
+    std::vector<uint16_t> bones(numBones);
+
+    for(uint16_t bone = 0; bone < numBones; bone++) {
+        openFile->readL16(bones[bone]);
+    }
+
+    LOG_INFO("%u bones\n", numBones);
+
+    uint32_t numSegments;
+    openFile->readL32(numSegments);
+
+    std::vector<uint32_t> offsets(numSegments + 1);
+
+    for(uint32_t segment = 0; segment <= numSegments; segment++) {
+        openFile->readL32(offsets[segment]);
+    }
+
+    LOG_INFO("%u segments, %u bytes total\n", numSegments, offsets[numSegments]);
+
+    for(uint32_t segment = 0; segment < numSegments; segment++) {
+        LOG_INFO("Segment %u at %u, %u bytes, starts at %f seconds\n", segment, offsets[segment], offsets[segment + 1] - offsets[segment],
+            segment * segmentFrames / frameRate);
+
+        for(uint16_t bone = 0; bone < numBones; bone++) {
+            LOG_INFO("Bone index %u\n", bones[bone]);
+
+            dumpQuantizedVectors(openFile, frameRate, "Position");
+            LOG_INFO("\n");
+
+            dumpQuantizedRotations(openFile, frameRate);
+            LOG_INFO("\n");
+
+            dumpQuantizedVectors(openFile, frameRate, "Scale");
+            LOG_INFO("\n");
+        }
+    }
+}
+
+void dumpAnimation(illFileSystem::File * openFile, unsigned int version) {
     //duration
     {
         float duration;
@@ -87,12 +479,35 @@ void dumpAnimation(illFileSystem::File * openFile) {
         LOG_INFO("Duration %f seconds", duration);
     }
 
+    float frameRate = 0.0f;
+
+    if(version >= 1) {
+        openFile->readLF(frameRate);
+
+        LOG_INFO("Frame rate %f", frameRate);
+
+        uint8_t flags;
+        openFile->read8(flags);
+
+        LOG_INFO("Keys are %s", (flags & 1) ? "relative to the bind pose" : "absolute");
+    }
+
+    if(version >= 3) {
+        dumpSegments(openFile, frameRate);
+        return;
+    }
+
     //num bones
     uint16_t numBones;
     openFile->readL16(numBones);
 
     LOG_INFO("%u bones\n", numBones);
 
+    if(version >= 2) {
+        dumpResampledFrames(openFile, numBones, frameRate);
+        return;
+    }
+
     for(uint16_t bone = 0; bone < numBones; bone++) {
         //bone index
         {
@@ -102,6 +517,19 @@ void dumpAnimation(illFileSystem::File * openFile) {
             LOG_INFO("Bone index %u\n", boneIndex);
         }
 
+        if(version >= 1) {
+            dumpQuantizedVectors(openFile, frameRate, "Position");
+            LOG_INFO("\n");
+
+            dumpQuantizedRotations(openFile, frameRate);
+            LOG_INFO("\n");
+
+            dumpQuantizedVectors(openFile, frameRate, "Scale");
+            LOG_INFO("\n");
+
+            continue;
+        }
+
         //position keys
         {
             uint16_t keys;
@@ -179,14 +607,22 @@ void dumpAnimation(illFileSystem::File * openFile) {
     LOG_INFO("End of animation file\n\n");
 }
 
-void dumpSkeleton(illFileSystem::File * openFile) {
+void dumpSkeleton(illFileSystem::File * openFile, unsigned int version) {
     //num bones
     uint16_t numBones;
     openFile->readL16(numBones);
 
     LOG_INFO("%u bones\n", numBones);
 
-    for(uint16_t bone = 0; bone < numBones; bone++) {
+    uint8_t flags = 0;
+
+    if(version >= 2) {
+        openFile->read8(flags);
+        LOG_INFO("Flags: %s%s\n", (flags & 1) ? "model space bind " : "", (flags & 2) ? "bone LODs" : "");
+    }
+
+    //version 2 has the bind data after the heirarchy
+    for(uint16_t bone = 0; bone < numBones && version < 2; bone++) {
         LOG_INFO("Bone: %u\n", bone);
 
         //bind pose
@@ -245,6 +681,97 @@ void dumpSkeleton(illFileSystem::File * openFile) {
         }
     }
 
+    //heirarchy levels
+    uint16_t numLevels = 0;
+
+    if(version >= 1) {
+        LOG_INFO("\n");
+
+        openFile->readL16(numLevels);
+
+        LOG_INFO("%u heirarchy levels\n", numLevels);
+
+        for(uint16_t level = 0; level < numLevels; level++) {
+            uint16_t begin;
+            openFile->readL16(begin);
+
+            uint16_t count;
+            openFile->readL16(count);
+
+            LOG_INFO("Level: %u Begin: %u Count: %u", level, begin, count);
+        }
+
+        LOG_INFO("\n");
+        LOG_INFO("Evaluation order\n");
+
+        for(uint16_t bone = 0; bone < numBones; bone++) {
+            uint16_t orderBone;
+            openFile->readL16(orderBone);
+
+            LOG_INFO("%u: Bone %u", bone, orderBone);
+        }
+    }
+
+    //bone LODs
+    uint8_t numLods = 0;
+
+    if(flags & 2) {
+        LOG_INFO("\n");
+
+        openFile->read8(numLods);
+
+        LOG_INFO("%u bone LODs\n", numLods);
+
+        for(uint8_t lod = 0; lod < numLods; lod++) {
+            uint16_t lodBones;
+            openFile->readL16(lodBones);
+
+            LOG_INFO("LOD: %u Bones: %u", lod, lodBones);
+        }
+    }
+
+    //compact bind data
+    if(version >= 2) {
+        //the arrays start 16 byte aligned
+        size_t headerSize = 8 + 2 + 1 + 2 * numBones + 2 + 4 * numLevels + 2 * numBones + (numLods ? 1 + 2 * numLods : 0);
+        openFile->seekAhead((16 - headerSize % 16) % 16);
+
+        LOG_INFO("\n");
+
+        for(unsigned int array = 0; array < ((flags & 1) ? 2u : 1u); array++) {
+            LOG_INFO(array == 0 ? "Inverse bind transforms (3x4)\n" : "Model space bind transforms (3x4)\n");
+
+            for(uint16_t bone = 0; bone < numBones; bone++) {
+                LOG_INFO("Bone: %u", bone);
+
+                for(unsigned int row = 0; row < 3; row++) {
+                    float data[4];
+
+                    for(unsigned int col = 0; col < 4; col++) {
+                        openFile->readLF(data[col]);
+                    }
+
+                    LOG_INFO("[%7.4f %7.4f %7.4f %7.4f]", data[0], data[1], data[2], data[3]);
+                }
+            }
+
+            LOG_INFO("\n");
+        }
+
+        LOG_INFO("Bind pose relative transforms\n");
+
+        for(uint16_t bone = 0; bone < numBones; bone++) {
+            float data[10];
+
+            for(unsigned int value = 0; value < 10; value++) {
+                openFile->readLF(data[value]);
+            }
+
+            LOG_INFO("Bone: %u Translation (%f, %f, %f) Rotation (%f, %f, %f, %f) Scale (%f, %f, %f)", bone,
+                data[0], data[1], data[2], data[3], data[4], data[5], data[6], data[7], data[8], data[9]);
+        }
+    }
+
     LOG_INFO("\n");
     LOG_INFO("End of skeleton file\n\n");
 }
@@ -462,4 +989,364 @@ void dumpMesh(illFileSystem::File * openFile) {
 
     LOG_INFO("\n");
     LOG_INFO("End of mesh file\n\n");
+}
+
+void dumpOccluder(illFileSystem::File * openFile) {
+    uint16_t numVerts;
+    openFile->readL16(numVerts);
+
+    LOG_INFO("%u Vertices", numVerts);
+
+    uint16_t numIndices;
+    openFile->readL16(numIndices);
+
+    LOG_INFO("%u Indices", numIndices);
+    LOG_INFO("\n");
+
+    for(uint16_t vertex = 0; vertex < numVerts; vertex++) {
+        glm::vec3 data;
+        openFile->readLF(data.x);
+        openFile->readLF(data.y);
+        openFile->readLF(data.z);
+
+        LOG_INFO("Vertex %u Position (%f, %f, %f)", vertex, data.x, data.y, data.z);
+    }
+
+    LOG_INFO("\n");
+
+    for(uint16_t index = 0; index < numIndices; index++) {
+        uint16_t data;
+        openFile->readL16(data);
+
+        LOG_INFO("Index %u %u", index, data);
+    }
+
+    LOG_INFO("\n");
+    LOG_INFO("End of occluder file\n\n");
+}
+
+void dumpCollision(illFileSystem::File * openFile) {
+    uint16_t numHulls;
+    openFile->readL16(numHulls);
+
+    LOG_INFO("%u Hulls", numHulls);
+    LOG_INFO("\n");
+
+    for(uint16_t hull = 0; hull < numHulls; hull++) {
+        uint16_t bone;
+        openFile->readL16(bone);
+
+        if(bone == 0xFFFF) {
+            LOG_INFO("Hull %u static", hull);
+        }
+        else {
+            LOG_INFO("Hull %u attached to bone %u", hull, bone);
+        }
+
+        uint16_t numVerts;
+        openFile->readL16(numVerts);
+
+        LOG_INFO("%u Vertices", numVerts);
+
+        for(uint16_t vertex = 0; vertex < numVerts; vertex++) {
+            glm::vec3 data;
+            openFile->readLF(data.x);
+            openFile->readLF(data.y);
+            openFile->readLF(data.z);
+
+            LOG_INFO("Vertex %u Position (%f, %f, %f)", vertex, data.x, data.y, data.z);
+        }
+
+        uint16_t numPlanes;
+        openFile->readL16(numPlanes);
+
+        LOG_INFO("%u Planes", numPlanes);
+
+        for(uint16_t plane = 0; plane < numPlanes; plane++) {
+            glm::vec3 normal;
+            openFile->readLF(normal.x);
+            openFile->readLF(normal.y);
+            openFile->readLF(normal.z);
+
+            float distance;
+            openFile->readLF(distance);
+
+            LOG_INFO("Plane %u Normal (%f, %f, %f) Distance %f", plane, normal.x, normal.y, normal.z, distance);
+        }
+
+        LOG_INFO("\n");
+    }
+
+    LOG_INFO("End of collision file\n\n");
+}
+
+void dumpMeshGroups(illFileSystem::File * openFile, unsigned int version) {
+    if(version >= 1) {
+        uint8_t flags;
+        openFile->read8(flags);
+
+        LOG_INFO("Vertices %s sorted by influence count", (flags & 1) ? "are" : "aren't");
+    }
+
+    uint16_t numGroups;
+    openFile->readL16(numGroups);
+
+    LOG_INFO("%u Groups", numGroups);
+    LOG_INFO("\n");
+
+    for(uint16_t group = 0; group < numGroups; group++) {
+        uint16_t bone;
+        openFile->readL16(bone);
+
+        if(bone == 0xFFFF) {
+            LOG_INFO("Group %u skinned", group);
+        }
+        else {
+            LOG_INFO("Group %u attached to bone %u", group, bone);
+        }
+
+        if(version >= 1) {
+            uint8_t maxInfluences;
+            openFile->read8(maxInfluences);
+
+            LOG_INFO("Group %u max influences %u", group, maxInfluences);
+        }
+    }
+
+    if(version >= 1) {
+        LOG_INFO("\n");
+
+        for(unsigned int influences = 0; influences <= 4; influences++) {
+            uint32_t numVertices;
+            openFile->readL32(numVertices);
+
+            LOG_INFO("%u vertices with %u influences", numVertices, influences);
+        }
+    }
+
+    LOG_INFO("\n");
+    LOG_INFO("End of mesh groups file\n\n");
+}
+
+void dumpMorphs(illFileSystem::File * openFile) {
+    uint32_t numVertices;
+    openFile->readL32(numVertices);
+
+    LOG_INFO("For a mesh with %u Vertices", numVertices);
+
+    uint16_t numTargets;
+    openFile->readL16(numTargets);
+
+    LOG_INFO("%u Targets", numTargets);
+    LOG_INFO("\n");
+
+    for(uint16_t target = 0; target < numTargets; target++) {
+        uint16_t numDeltas;
+        openFile->readL16(numDeltas);
+
+        uint8_t flags;
+        openFile->read8(flags);
+
+        LOG_INFO("Target %u moves %u vertices, %s normals", target, numDeltas, (flags & 1) ? "with" : "without");
+
+        if(numDeltas == 0) {
+            LOG_INFO("\n");
+            continue;
+        }
+
+        glm::vec3 minDelta;
+        glm::vec3 maxDelta;
+
+        openFile->readLF(minDelta.x);
+        openFile->readLF(minDelta.y);
+        openFile->readLF(minDelta.z);
+        openFile->readLF(maxDelta.x);
+        openFile->readLF(maxDelta.y);
+        openFile->readLF(maxDelta.z);
+
+        LOG_INFO("Delta Bounds (%f, %f, %f) to (%f, %f, %f)", minDelta.x, minDelta.y, minDelta.z, maxDelta.x, maxDelta.y, maxDelta.z);
+
+        std::vector<uint16_t> vertices(numDeltas);
+
+        for(uint16_t delta = 0; delta < numDeltas; delta++) {
+            openFile->readL16(vertices[delta]);
+        }
+
+        for(uint16_t delta = 0; delta < numDeltas; delta++) {
+            glm::vec3 position;
+
+            for(unsigned int component = 0; component < 3; component++) {
+                uint16_t quantized;
+                openFile->readL16(quantized);
+
+                position[component] = minDelta[component] + (maxDelta[component] - minDelta[component]) * quantized / 65535.0f;
+            }
+
+            LOG_INFO("Vertex %u Position Delta (%f, %f, %f)", vertices[delta], position.x, position.y, position.z);
+        }
+
+        if(flags & 1) {
+            for(uint16_t delta = 0; delta < numDeltas; delta++) {
+                glm::vec3 normal;
+
+                for(unsigned int component = 0; component < 3; component++) {
+                    uint8_t quantized;
+                    openFile->read8(quantized);
+
+                    normal[component] = (int8_t) quantized / 63.5f;
+                }
+
+                LOG_INFO("Vertex %u Normal Delta (%f, %f, %f)", vertices[delta], normal.x, normal.y, normal.z);
+            }
+        }
+
+        LOG_INFO("\n");
+    }
+
+    LOG_INFO("End of morph targets file\n\n");
+}
+
+//a smallest three rotation back to x, y, z, w
+glm::quat decodeBakedRotation(const uint16_t * components) {
+    unsigned int largest = ((components[0] >> 15) << 1) | (components[1] >> 15);
+
+    float rotation[4];
+    float sum = 0.0f;
+    unsigned int word = 0;
+
+    for(unsigned int component = 0; component < 4; component++) {
+        if(component == largest) {
+            continue;
+        }
+
+        rotation[component] = (components[word++] & SMALLEST_THREE_MASK) * 2.0f * SMALLEST_THREE_RANGE / SMALLEST_THREE_QUANTIZED_MAX - SMALLEST_THREE_RANGE;
+        sum += rotation[component] * rotation[component];
+    }
+
+    rotation[largest] = sqrt(std::max(0.0f, 1.0f - sum));
+
+    return glm::quat(rotation[3], rotation[0], rotation[1], rotation[2]);
+}
+
+void dumpBake(illFileSystem::File * openFile) {
+    uint8_t type;
+    openFile->read8(type);
+
+    uint32_t numItems;
+    openFile->readL32(numItems);
+
+    float frameRate;
+    openFile->readLF(frameRate);
+
+    float duration;
+    openFile->readLF(duration);
+
+    uint32_t numFrames;
+    openFile->readL32(numFrames);
+
+    uint32_t width;
+    openFile->readL32(width);
+
+    uint32_t height;
+    openFile->readL32(height);
+
+    uint32_t rowsPerFrame;
+    openFile->readL32(rowsPerFrame);
+
+    uint8_t bytesPerTexel;
+    openFile->read8(bytesPerTexel);
+
+    LOG_INFO("%u %s, %u Frames at %f FPS, Duration %f", numItems, type == 0 ? "Bones" : "Vertices", numFrames, frameRate, duration);
+    LOG_INFO("Texture %u by %u, %u Rows Per Frame, %u Bytes Per Texel", width, height, rowsPerFrame, bytesPerTexel);
+
+    glm::vec3 min;
+    glm::vec3 extent;
+
+    openFile->readLF(min.x);
+    openFile->readLF(min.y);
+    openFile->readLF(min.z);
+    openFile->readLF(extent.x);
+    openFile->readLF(extent.y);
+    openFile->readLF(extent.z);
+
+    LOG_INFO("%s Range (%f, %f, %f) to (%f, %f, %f)", type == 0 ? "Translation" : "Position",
+        min.x, min.y, min.z, min.x + extent.x, min.y + extent.y, min.z + extent.z);
+
+    float minScale = 0.0f;
+    float scaleExtent = 0.0f;
+
+    if(type == 0) {
+        openFile->readLF(minScale);
+        openFile->readLF(scaleExtent);
+
+        LOG_INFO("Scale Range %f to %f", minScale, minScale + scaleExtent);
+    }
+
+    LOG_INFO("\n");
+
+    for(uint32_t frame = 0; frame < numFrames; frame++) {
+        LOG_INFO("Frame %u", frame);
+
+        for(uint32_t item = 0; item < width * rowsPerFrame; item++) {
+            if(type == 0) {
+                uint32_t words[4];
+
+                for(unsigned int word = 0; word < 4; word++) {
+                    openFile->readL32(words[word]);
+                }
+
+                if(item >= numItems) {
+                    continue;
+                }
+
+                uint16_t rotationComponents[3] = {(uint16_t) words[0], (uint16_t) (words[0] >> 16), (uint16_t) words[1]};
+                glm::quat rotation = decodeBakedRotation(rotationComponents);
+
+                float scale = minScale + scaleExtent * (words[1] >> 16) / RANGE_QUANTIZED_MAX;
+                glm::vec3 translation(min.x + extent.x * (words[2] & 0xFFFF) / RANGE_QUANTIZED_MAX,
+                    min.y + extent.y * (words[2] >> 16) / RANGE_QUANTIZED_MAX,
+                    min.z + extent.z * (words[3] & 0xFFFF) / RANGE_QUANTIZED_MAX);
+
+                LOG_INFO("Bone %u Rotation (%f, %f, %f, %f) Scale %f Translation (%f, %f, %f)", item,
+                    rotation.x, rotation.y, rotation.z, rotation.w, scale, translation.x, translation.y, translation.z);
+            }
+            else {
+                uint16_t words[4];
+
+                for(unsigned int word = 0; word < 4; word++) {
+                    openFile->readL16(words[word]);
+                }
+
+                if(item >= numItems) {
+                    continue;
+                }
+
+                glm::vec3 position;
+
+                for(unsigned int component = 0; component < 3; component++) {
+                    position[component] = min[component] + extent[component] * words[component] / RANGE_QUANTIZED_MAX;
+                }
+
+                //unfold the octahedron
+                float x = (words[3] & 0xFF) / 255.0f * 2.0f - 1.0f;
+                float y = (words[3] >> 8) / 255.0f * 2.0f - 1.0f;
+                float z = 1.0f - fabs(x) - fabs(y);
+
+                if(z < 0.0f) {
+                    float unfoldedX = (1.0f - fabs(y)) * (x < 0.0f ? -1.0f : 1.0f);
+                    float unfoldedY = (1.0f - fabs(x)) * (y < 0.0f ? -1.0f : 1.0f);
+
+                    x = unfoldedX;
+                    y = unfoldedY;
+                }
+
+                glm::vec3 normal = glm::normalize(glm::vec3(x, y, z));
+
+                LOG_INFO("Vertex %u Position (%f, %f, %f) Normal (%f, %f, %f)", item,
+                    position.x, position.y, position.z, normal.x, normal.y, normal.z);
+            }
+        }
+
+        LOG_INFO("\n");
+    }
 }
\ No newline at end of file
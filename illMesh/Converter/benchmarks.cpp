@@ -0,0 +1,824 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <thread>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "benchmarks.h"
+#include "Animation.h"
+#include "KeyReducer.h"
+#include "MeshBuffer.h"
+#include "Skeleton.h"
+#include "parallel.h"
+
+#include "../Runtime/AnimationSampler.h"
+#include "../Runtime/AnimationSegment.h"
+#include "../Runtime/PoseBuffer.h"
+#include "../Runtime/Pose.h"
+#include "../Runtime/ResampledAnimation.h"
+#include "../Runtime/Skinning.h"
+
+#include "illEngine/FileSystem/FileSystem.h"
+#include "illEngine/FileSystem/File.h"
+
+#include "illEngine/Logging/logging.h"
+
+//vertices each thread skins at a time, a multiple of SIMD_WIDTH
+const uint32_t SKINNING_CHUNK_VERTICES = 1024;
+
+//3x4 row major from a glm matrix
+void toAffine(const glm::mat4& matrix, float * affine) {
+    for(unsigned int row = 0; row < 3; row++) {
+        for(unsigned int col = 0; col < 4; col++) {
+            affine[row * 4 + col] = matrix[col][row];
+        }
+    }
+}
+
+void SkinningBenchmark::run() {
+    std::vector<SkinningMesh> meshes;
+    meshes.reserve(m_meshPaths.size());
+
+    for(auto iter = m_meshPaths.cbegin(); iter != m_meshPaths.end(); iter++) {
+        MeshBuffer buffer;
+        buffer.load(iter->c_str());
+
+        if(!(buffer.m_features & MeshFeatures::MF_BLEND_DATA)) {
+            LOG_INFO("Warning: %s has no blend data, skipping", iter->c_str());
+            continue;
+        }
+
+        meshes.push_back(SkinningMesh());
+        meshes.back().setVertices(&buffer.m_vertices[0], buffer.m_vertexSize, buffer.m_numVertices, buffer.m_features);
+    }
+
+    if(meshes.empty()) {
+        LOG_FATAL_ERROR("No skinned meshes to benchmark");
+    }
+
+    uint16_t maxBone = 0;
+
+    for(auto iter = meshes.cbegin(); iter != meshes.end(); iter++) {
+        maxBone = std::max(maxBone, iter->m_maxBone);
+    }
+
+    //the palette of the bind pose, every transform should come out as identity
+    std::vector<float> palette;
+
+    if(!m_skeletonPath.empty()) {
+        Skeleton skeleton;
+        skeleton.load(m_skeletonPath.c_str(), NULL);
+
+        uint16_t numBones = (uint16_t) skeleton.m_bones.size();
+
+        if(maxBone >= numBones) {
+            LOG_FATAL_ERROR("The meshes use bone %u but the skeleton %s only has %u bones", maxBone, m_skeletonPath.c_str(), numBones);
+        }
+
+        PoseBuffer pose;
+        skeleton.getBindPose(pose);
+
+        std::vector<float> inverseBinds;
+        skeleton.getInverseBindTransforms(inverseBinds);
+
+        std::vector<float> localTransforms(numBones * AFFINE_FLOATS);
+        std::vector<float> modelTransforms(numBones * AFFINE_FLOATS);
+        palette.resize(numBones * AFFINE_FLOATS);
+
+        computeLocalTransforms(pose, numBones, &localTransforms[0]);
+        computeModelTransforms(&localTransforms[0], &skeleton.m_parents[0], numBones, &modelTransforms[0]);
+        computeSkinningPalette(&modelTransforms[0], &inverseBinds[0], numBones, &palette[0]);
+    }
+    else {
+        palette.resize((maxBone + 1) * AFFINE_FLOATS);
+
+        for(unsigned int bone = 0; bone <= maxBone; bone++) {
+            toAffine(glm::mat4(), &palette[bone * AFFINE_FLOATS]);
+        }
+    }
+
+    //split every mesh up into chunks so big meshes still spread across threads
+    struct Chunk {
+        size_t m_mesh;
+        uint32_t m_beginVertex;
+        uint32_t m_endVertex;
+    };
+
+    std::vector<Chunk> chunks;
+    std::vector<std::vector<float> > positions(meshes.size());
+    std::vector<std::vector<float> > normals(meshes.size());
+    uint64_t numVertices = 0;
+
+    for(size_t mesh = 0; mesh < meshes.size(); mesh++) {
+        positions[mesh].resize(meshes[mesh].m_numVertices * 3);
+        normals[mesh].resize(meshes[mesh].m_numVertices * 3);
+        numVertices += meshes[mesh].m_numVertices;
+
+        for(uint32_t vertex = 0; vertex < meshes[mesh].m_numVertices; vertex += SKINNING_CHUNK_VERTICES) {
+            Chunk chunk;
+            chunk.m_mesh = mesh;
+            chunk.m_beginVertex = vertex;
+            chunk.m_endVertex = std::min(vertex + SKINNING_CHUNK_VERTICES, meshes[mesh].m_numVertices);
+
+            chunks.push_back(chunk);
+        }
+    }
+
+    auto skinChunk = [&] (size_t chunk) {
+        const Chunk& currChunk = chunks[chunk];
+
+        skinVertices(meshes[currChunk.m_mesh], &palette[0], currChunk.m_beginVertex, currChunk.m_endVertex,
+            &positions[currChunk.m_mesh][0], &normals[currChunk.m_mesh][0]);
+    };
+
+    //warm up, and check the result
+    parallelFor(chunks.size(), m_numThreads, skinChunk);
+
+    float maxError = 0.0f;
+
+    for(size_t mesh = 0; mesh < meshes.size(); mesh++) {
+        for(uint32_t vertex = 0; vertex < meshes[mesh].m_numVertices; vertex++) {
+            for(unsigned int component = 0; component < 3; component++) {
+                float bindPosition = meshes[mesh].getChannel((SkinningMesh::Channel) (SkinningMesh::POSITION_X + component))[vertex];
+                maxError = std::max(maxError, std::abs(positions[mesh][vertex * 3 + component] - bindPosition));
+            }
+        }
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for(unsigned int iteration = 0; iteration < m_iterations; iteration++) {
+        parallelFor(chunks.size(), m_numThreads, skinChunk);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    unsigned int numThreads = m_numThreads ? m_numThreads : std::thread::hardware_concurrency();
+
+    LOG_INFO("Skinned %u meshes, %u vertices, %u times on %u threads, %u wide SIMD",
+        (unsigned int) meshes.size(), (unsigned int) numVertices, m_iterations, numThreads, (unsigned int) SIMD_WIDTH);
+    LOG_INFO("%.3f seconds, %.2f million vertices per second", seconds, (double) numVertices * m_iterations / seconds / 1000000.0);
+    LOG_INFO("Largest bind pose position error %g", maxError);
+}
+
+//largest difference between any channel of two poses
+float computePoseDifference(const PoseBuffer& left, const PoseBuffer& right) {
+    float difference = 0.0f;
+
+    for(unsigned int channel = 0; channel < PoseBuffer::NUM_CHANNELS; channel++) {
+        for(uint16_t bone = 0; bone < left.m_numBones; bone++) {
+            difference = std::max(difference, std::abs(left.getChannel((PoseBuffer::Channel) channel)[bone]
+                - right.getChannel((PoseBuffer::Channel) channel)[bone]));
+        }
+    }
+
+    return difference;
+}
+
+void AnimationSamplingBenchmark::run() {
+    enum Method {
+        METHOD_SEARCH,
+        METHOD_CURSOR,
+        METHOD_BATCH,
+
+        NUM_METHODS
+    };
+
+    double totalSeconds[NUM_METHODS] = {0.0, 0.0, 0.0};
+    uint64_t totalTrackSamples = 0;
+
+    for(auto iter = m_animationPaths.cbegin(); iter != m_animationPaths.end(); iter++) {
+        Animation animation;
+        animation.load(iter->c_str());
+
+        AnimationClip clip = animation.getClip();
+
+        if(clip.m_numTracks == 0) {
+            LOG_INFO("Warning: %s has no tracks, skipping", iter->c_str());
+            continue;
+        }
+
+        std::vector<PoseBuffer> poses[NUM_METHODS];
+        std::vector<AnimationCursor> cursors[NUM_METHODS];
+        std::vector<float> times(m_numInstances);
+
+        for(unsigned int method = 0; method < NUM_METHODS; method++) {
+            poses[method].resize(m_numInstances);
+            cursors[method].resize(m_numInstances);
+
+            for(unsigned int instance = 0; instance < m_numInstances; instance++) {
+                poses[method][instance].resize(clip.m_numBones);
+                cursors[method][instance].reset(clip);
+            }
+        }
+
+        //the instances start spread out over the clip and loop
+        auto computeTimes = [&] (unsigned int iteration) {
+            for(unsigned int instance = 0; instance < m_numInstances; instance++) {
+                float time = clip.m_duration * instance / m_numInstances + m_timeStep * iteration;
+                times[instance] = clip.m_duration > 0.0f ? fmod(time, clip.m_duration) : 0.0f;
+            }
+        };
+
+        double seconds[NUM_METHODS];
+
+        for(unsigned int method = 0; method < NUM_METHODS; method++) {
+            auto start = std::chrono::high_resolution_clock::now();
+
+            for(unsigned int iteration = 0; iteration < m_iterations; iteration++) {
+                computeTimes(iteration);
+
+                switch(method) {
+                case METHOD_SEARCH:
+                    for(unsigned int instance = 0; instance < m_numInstances; instance++) {
+                        sampleAnimationSearch(clip, times[instance], poses[method][instance]);
+                    }
+                    break;
+
+                case METHOD_CURSOR:
+                    for(unsigned int instance = 0; instance < m_numInstances; instance++) {
+                        sampleAnimation(clip, times[instance], cursors[method][instance], poses[method][instance]);
+                    }
+                    break;
+
+                case METHOD_BATCH:
+                    sampleAnimationBatch(clip, &times[0], &cursors[method][0], &poses[method][0], m_numInstances);
+                    break;
+                }
+            }
+
+            seconds[method] = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            totalSeconds[method] += seconds[method];
+        }
+
+        //the cursors have to land on the same keys the search does
+        float maxDifference = 0.0f;
+
+        for(unsigned int instance = 0; instance < m_numInstances; instance++) {
+            maxDifference = std::max(maxDifference, computePoseDifference(poses[METHOD_SEARCH][instance], poses[METHOD_CURSOR][instance]));
+            maxDifference = std::max(maxDifference, computePoseDifference(poses[METHOD_SEARCH][instance], poses[METHOD_BATCH][instance]));
+        }
+
+        uint64_t trackSamples = (uint64_t) clip.m_numTracks * m_numInstances * m_iterations;
+        totalTrackSamples += trackSamples;
+
+        size_t numKeys = animation.m_positions.size() + animation.m_rotations.size() + animation.m_scales.size();
+
+        LOG_INFO("%s: %u tracks, %u keys, %f seconds", iter->c_str(), (unsigned int) clip.m_numTracks, (unsigned int) numKeys, clip.m_duration);
+        LOG_INFO("    search %.1f ns, cursor %.1f ns, batched %.1f ns per track sample, largest difference %g",
+            seconds[METHOD_SEARCH] * 1.0e9 / trackSamples, seconds[METHOD_CURSOR] * 1.0e9 / trackSamples,
+            seconds[METHOD_BATCH] * 1.0e9 / trackSamples, maxDifference);
+    }
+
+    if(totalTrackSamples == 0) {
+        LOG_FATAL_ERROR("No animations to benchmark");
+    }
+
+    LOG_INFO("Sampled %u instances %u times at %f second steps", m_numInstances, m_iterations, m_timeStep);
+    LOG_INFO("Search %.1f ns, cursor %.1f ns (%.2f times faster), batched %.1f ns (%.2f times faster) per track sample",
+        totalSeconds[METHOD_SEARCH] * 1.0e9 / totalTrackSamples,
+        totalSeconds[METHOD_CURSOR] * 1.0e9 / totalTrackSamples, totalSeconds[METHOD_SEARCH] / totalSeconds[METHOD_CURSOR],
+        totalSeconds[METHOD_BATCH] * 1.0e9 / totalTrackSamples, totalSeconds[METHOD_SEARCH] / totalSeconds[METHOD_BATCH]);
+}
+
+//largest difference between two runs of floats, relative to the reference value once it's above 1
+float computeRelativeError(const float * values, const float * reference, size_t count) {
+    float error = 0.0f;
+
+    for(size_t value = 0; value < count; value++) {
+        error = std::max(error, std::abs(values[value] - reference[value]) / std::max(1.0f, std::abs(reference[value])));
+    }
+
+    return error;
+}
+
+void PoseCheck::run() {
+    std::mt19937 random(m_seed);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    auto randomPose = [&] (PoseBuffer& pose) {
+        pose.resize(m_numBones);
+
+        for(uint16_t bone = 0; bone < m_numBones; bone++) {
+            //kept close to 1 so scales down a deep chain don't blow up
+            glm::vec3 scale(1.0f + 0.2f * unit(random), 1.0f + 0.2f * unit(random), 1.0f + 0.2f * unit(random));
+            glm::quat rotation = glm::normalize(glm::quat(unit(random), unit(random), unit(random), unit(random)));
+
+            pose.setBone(bone, glm::vec3(unit(random), unit(random), unit(random)), rotation, scale);
+        }
+    };
+
+    auto referenceLocal = [] (const PoseBuffer& pose, uint16_t bone) {
+        glm::vec3 translation;
+        glm::quat rotation;
+        glm::vec3 scale;
+        pose.getBone(bone, translation, rotation, scale);
+
+        return glm::scale(glm::translate(glm::mat4(), translation) * glm::mat4_cast(rotation), scale);
+    };
+
+    enum Function {
+        FUNCTION_BLEND,
+        FUNCTION_LOCAL,
+        FUNCTION_MODEL,
+        FUNCTION_PALETTE,
+
+        NUM_FUNCTIONS
+    };
+
+    const char * functionNames[NUM_FUNCTIONS] = {"blendPoses", "computeLocalTransforms", "computeModelTransforms", "computeSkinningPalette"};
+    float maxErrors[NUM_FUNCTIONS] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+    std::vector<uint16_t> parents(m_numBones);
+    std::vector<float> localTransforms(m_numBones * AFFINE_FLOATS);
+    std::vector<float> modelTransforms(m_numBones * AFFINE_FLOATS);
+    std::vector<float> inverseBinds(m_numBones * AFFINE_FLOATS);
+    std::vector<float> palette(m_numBones * AFFINE_FLOATS);
+    std::vector<glm::mat4> referenceModels(m_numBones);
+    float expected[AFFINE_FLOATS];
+
+    PoseBuffer from;
+    PoseBuffer to;
+    PoseBuffer blended;
+
+    for(unsigned int trial = 0; trial < m_numTrials; trial++) {
+        //a new hierarchy every trial with a few extra roots, parents always before their children
+        for(uint16_t bone = 0; bone < m_numBones; bone++) {
+            parents[bone] = bone == 0 || random() % 8 == 0 ? bone : (uint16_t) (random() % bone);
+        }
+
+        randomPose(from);
+        randomPose(to);
+
+        float weight = (unit(random) + 1.0f) * 0.5f;
+        blendPoses(from, to, weight, blended);
+
+        for(uint16_t bone = 0; bone < m_numBones; bone++) {
+            glm::vec3 fromTranslation, toTranslation, translation;
+            glm::quat fromRotation, toRotation, rotation;
+            glm::vec3 fromScale, toScale, scale;
+
+            from.getBone(bone, fromTranslation, fromRotation, fromScale);
+            to.getBone(bone, toTranslation, toRotation, toScale);
+            blended.getBone(bone, translation, rotation, scale);
+
+            //nlerp the short way around
+            if(glm::dot(fromRotation, toRotation) < 0.0f) {
+                toRotation = -toRotation;
+            }
+
+            glm::quat expectedRotation = glm::normalize(fromRotation * (1.0f - weight) + toRotation * weight);
+            glm::vec3 expectedTranslation = fromTranslation + (toTranslation - fromTranslation) * weight;
+            glm::vec3 expectedScale = fromScale + (toScale - fromScale) * weight;
+
+            float values[10] = {translation.x, translation.y, translation.z, rotation.x, rotation.y, rotation.z, rotation.w, scale.x, scale.y, scale.z};
+            float reference[10] = {expectedTranslation.x, expectedTranslation.y, expectedTranslation.z,
+                expectedRotation.x, expectedRotation.y, expectedRotation.z, expectedRotation.w, expectedScale.x, expectedScale.y, expectedScale.z};
+
+            maxErrors[FUNCTION_BLEND] = std::max(maxErrors[FUNCTION_BLEND], computeRelativeError(values, reference, 10));
+        }
+
+        //the rest go from the blended pose, each checked against glm on the same input
+        computeLocalTransforms(blended, m_numBones, &localTransforms[0]);
+        computeModelTransforms(&localTransforms[0], &parents[0], m_numBones, &modelTransforms[0]);
+
+        for(uint16_t bone = 0; bone < m_numBones; bone++) {
+            glm::mat4 local = referenceLocal(blended, bone);
+            referenceModels[bone] = parents[bone] == bone ? local : referenceModels[parents[bone]] * local;
+
+            toAffine(local, expected);
+            maxErrors[FUNCTION_LOCAL] = std::max(maxErrors[FUNCTION_LOCAL],
+                computeRelativeError(&localTransforms[bone * AFFINE_FLOATS], expected, AFFINE_FLOATS));
+
+            toAffine(referenceModels[bone], expected);
+            maxErrors[FUNCTION_MODEL] = std::max(maxErrors[FUNCTION_MODEL],
+                computeRelativeError(&modelTransforms[bone * AFFINE_FLOATS], expected, AFFINE_FLOATS));
+        }
+
+        //random inverse binds, multiplied onto glm's model transforms so only the palette's own error shows
+        std::vector<glm::mat4> referenceInverseBinds(m_numBones);
+        PoseBuffer bindPose;
+        randomPose(bindPose);
+
+        for(uint16_t bone = 0; bone < m_numBones; bone++) {
+            referenceInverseBinds[bone] = glm::inverse(referenceLocal(bindPose, bone));
+            toAffine(referenceInverseBinds[bone], &inverseBinds[bone * AFFINE_FLOATS]);
+            toAffine(referenceModels[bone], &modelTransforms[bone * AFFINE_FLOATS]);
+        }
+
+        computeSkinningPalette(&modelTransforms[0], &inverseBinds[0], m_numBones, &palette[0]);
+
+        for(uint16_t bone = 0; bone < m_numBones; bone++) {
+            toAffine(referenceModels[bone] * referenceInverseBinds[bone], expected);
+            maxErrors[FUNCTION_PALETTE] = std::max(maxErrors[FUNCTION_PALETTE],
+                computeRelativeError(&palette[bone * AFFINE_FLOATS], expected, AFFINE_FLOATS));
+        }
+    }
+
+#if defined(ILL_SIMD_AVX2)
+    const char * simdPath = "AVX2";
+#elif defined(ILL_SIMD_SSE)
+    const char * simdPath = "SSE";
+#else
+    const char * simdPath = "scalar";
+#endif
+
+    LOG_INFO("Checked %u random poses of %u bones on the %s path, %u wide SIMD", m_numTrials, (unsigned int) m_numBones, simdPath, (unsigned int) SIMD_WIDTH);
+
+    bool passed = true;
+
+    for(unsigned int function = 0; function < NUM_FUNCTIONS; function++) {
+        bool functionPassed = maxErrors[function] <= m_tolerance;
+        passed = passed && functionPassed;
+
+        LOG_INFO("%s largest error %g, %s", functionNames[function], maxErrors[function], functionPassed ? "passed" : "FAILED");
+    }
+
+    if(!passed) {
+        LOG_FATAL_ERROR("Pose evaluation doesn't match glm within %g", m_tolerance);
+    }
+}
+
+//turns a pose of deltas from the bind pose into the actual pose, undoing Animation::makeBindRelative
+void applyBindPose(const PoseBuffer& bindPose, PoseBuffer& pose) {
+    for(uint16_t bone = 0; bone < bindPose.m_numBones; bone++) {
+        glm::vec3 bindTranslation, translation;
+        glm::quat bindRotation, rotation;
+        glm::vec3 bindScale, scale;
+
+        bindPose.getBone(bone, bindTranslation, bindRotation, bindScale);
+        pose.getBone(bone, translation, rotation, scale);
+
+        pose.setBone(bone, bindTranslation + translation, bindRotation * rotation, bindScale * scale);
+    }
+}
+
+/**
+Where the virtual points of every bone end up in model space for a pose.
+@param points Set to 3 points per bone, each m_pointOffset along one of the bone's axes, xyz each.
+*/
+void computeVirtualPoints(const PoseBuffer& pose, const Skeleton& skeleton, float pointOffset,
+        std::vector<float>& localTransforms, std::vector<float>& modelTransforms, float * points) {
+    uint16_t numBones = (uint16_t) skeleton.m_bones.size();
+
+    computeLocalTransforms(pose, numBones, &localTransforms[0]);
+    computeModelTransforms(&localTransforms[0], &skeleton.m_parents[0], numBones, &modelTransforms[0]);
+
+    for(uint16_t bone = 0; bone < numBones; bone++) {
+        const float * transform = &modelTransforms[bone * AFFINE_FLOATS];
+
+        for(unsigned int axis = 0; axis < 3; axis++) {
+            for(unsigned int row = 0; row < 3; row++) {
+                points[(bone * 3 + axis) * 3 + row] = transform[row * 4 + axis] * pointOffset + transform[row * 4 + 3];
+            }
+        }
+    }
+}
+
+/**
+The version 3 file as the runtime would stream it, decoding a segment whenever sampling moves into a different one.
+*/
+struct SegmentedPlayback {
+    void load(const char * path) {
+        illFileSystem::File * openFile = illFileSystem::fileSystem->openRead(path);
+
+        uint64_t magic;
+        openFile->readB64(magic);
+        openFile->readLF(m_duration);
+        openFile->readLF(m_frameRate);
+
+        uint8_t flags;
+        openFile->read8(flags);
+
+        uint16_t segmentFrames;
+        openFile->readL16(segmentFrames);
+        m_segmentLength = segmentFrames / m_frameRate;
+
+        uint16_t numTracks;
+        openFile->readL16(numTracks);
+        m_bones.resize(numTracks);
+
+        for(uint16_t track = 0; track < numTracks; track++) {
+            openFile->readL16(m_bones[track]);
+        }
+
+        uint32_t numSegments;
+        openFile->readL32(numSegments);
+        m_offsets.resize(numSegments + 1);
+
+        for(uint32_t segment = 0; segment <= numSegments; segment++) {
+            openFile->readL32(m_offsets[segment]);
+        }
+
+        //the segments, indexed by their offsets less the header
+        m_headerSize = m_offsets[0];
+        m_data.resize(openFile->getSize() - m_headerSize);
+
+        if(!m_data.empty()) {
+            openFile->read(&m_data[0], m_data.size());
+        }
+
+        delete openFile;
+
+        m_segment = numSegments;
+    }
+
+    void sample(float time, AnimationCursor& cursor, PoseBuffer& pose) {
+        uint32_t numSegments = (uint32_t) m_offsets.size() - 1;
+        uint32_t segment = findAnimationSegment(time, m_segmentLength, numSegments);
+
+        if(segment != m_segment) {
+            float beginTime = segment * m_segmentLength;
+
+            if(!m_decoded.decode(&m_data[m_offsets[segment] - m_headerSize], m_offsets[segment + 1] - m_offsets[segment],
+                    m_bones.empty() ? NULL : &m_bones[0], (uint16_t) m_bones.size(), m_frameRate, beginTime, std::min(beginTime + m_segmentLength, m_duration))) {
+                LOG_FATAL_ERROR("Segment %u of the version 3 animation is corrupt", segment);
+            }
+
+            m_clip = m_decoded.getClip();
+            cursor.reset(m_clip);
+            m_segment = segment;
+        }
+
+        sampleAnimation(m_clip, time, cursor, pose);
+    }
+
+    float m_duration;
+    float m_frameRate;
+    float m_segmentLength;
+    uint32_t m_headerSize;
+    std::vector<uint16_t> m_bones;
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint8_t> m_data;
+
+    uint32_t m_segment;
+    AnimationSegment m_decoded;
+    AnimationClip m_clip;
+};
+
+//reads a version 2 file back the way the runtime uses it
+void loadResampled(const char * path, ResampledAnimation& resampled) {
+    illFileSystem::File * openFile = illFileSystem::fileSystem->openRead(path);
+
+    uint64_t magic;
+    openFile->readB64(magic);
+
+    float duration;
+    openFile->readLF(duration);
+
+    float frameRate;
+    openFile->readLF(frameRate);
+
+    uint8_t flags;
+    openFile->read8(flags);
+
+    uint16_t numBones;
+    openFile->readL16(numBones);
+
+    uint32_t numFrames;
+    openFile->readL32(numFrames);
+
+    std::vector<float> frames((size_t) numFrames * ResampledAnimation::NUM_CHANNELS * numBones);
+
+    for(size_t value = 0; value < frames.size(); value++) {
+        openFile->readLF(frames[value]);
+    }
+
+    delete openFile;
+
+    resampled.setFrames(&frames[0], numBones, numFrames, frameRate, duration);
+}
+
+//a CSV field in quotes with any quotes in it doubled, so paths with commas or quotes stay one field
+std::string quoteCsvField(const std::string& field) {
+    std::string quoted = "\"";
+
+    for(auto iter = field.begin(); iter != field.end(); iter++) {
+        if(*iter == '"') {
+            quoted += '"';
+        }
+
+        quoted += *iter;
+    }
+
+    return quoted + "\"";
+}
+
+void AnimationCompressionBenchmark::run() {
+    const unsigned int NUM_VERSIONS = 4;
+
+    if(m_clips.empty()) {
+        LOG_FATAL_ERROR("No animations to benchmark");
+    }
+
+    std::string csv = "skeleton,animation,version,frame_rate,segment_length,model_space_tolerance,bytes,compression_ratio,"
+        "bone_samples_per_second,max_error,mean_error\n";
+
+    std::string skeletonPath;
+    Skeleton skeleton;
+
+    for(auto clipIter = m_clips.cbegin(); clipIter != m_clips.end(); clipIter++) {
+        if(clipIter->m_skeletonPath != skeletonPath) {
+            skeletonPath = clipIter->m_skeletonPath;
+            skeleton.load(skeletonPath.c_str(), NULL);
+        }
+
+        const char * path = clipIter->m_animationPath.c_str();
+        uint16_t numBones = (uint16_t) skeleton.m_bones.size();
+
+        Animation source;
+        source.load(path);
+
+        if(m_frameRate > 0.0f) {
+            source.m_frameRate = m_frameRate;
+        }
+
+        source.m_segmentLength = m_segmentLength;
+
+        AnimationClip sourceClip = source.getClip();
+
+        if(sourceClip.m_numBones > numBones) {
+            LOG_FATAL_ERROR("%s animates bone %u but the skeleton %s only has %u bones", path, sourceClip.m_numBones - 1, skeletonPath.c_str(), numBones);
+        }
+
+        //bones without tracks stay in the bind pose, or identity if the keys are deltas from it
+        PoseBuffer bindPose;
+        skeleton.getBindPose(bindPose);
+
+        PoseBuffer startPose;
+
+        if(source.m_bindRelative) {
+            startPose.resize(numBones);
+        }
+        else {
+            startPose = bindPose;
+        }
+
+        std::vector<float> times(m_numSamples);
+
+        for(unsigned int sample = 0; sample < m_numSamples; sample++) {
+            times[sample] = m_numSamples > 1 ? source.m_duration * sample / (m_numSamples - 1) : 0.0f;
+        }
+
+        std::vector<float> localTransforms(numBones * AFFINE_FLOATS);
+        std::vector<float> modelTransforms(numBones * AFFINE_FLOATS);
+        size_t pointFloats = (size_t) numBones * 3 * 3;
+
+        //the points of the clip as it was loaded
+        std::vector<float> referencePoints(m_numSamples * pointFloats);
+        PoseBuffer pose;
+
+        for(unsigned int sample = 0; sample < m_numSamples; sample++) {
+            pose = startPose;
+            sampleAnimationSearch(sourceClip, times[sample], pose);
+
+            if(source.m_bindRelative) {
+                applyBindPose(bindPose, pose);
+            }
+
+            computeVirtualPoints(pose, skeleton, m_pointOffset, localTransforms, modelTransforms, &referencePoints[sample * pointFloats]);
+        }
+
+        std::string scratchPath = clipIter->m_animationPath + ".benchanim";
+        size_t uncompressedSize = source.computeSaveSize(0);
+
+        for(unsigned int version = 0; version < NUM_VERSIONS; version++) {
+            if(version == 0 && source.m_bindRelative) {
+                LOG_INFO("Warning: %s has keys relative to the bind pose, skipping version 0", path);
+                continue;
+            }
+
+            Animation encoded = source;
+            encoded.m_version = version;
+
+            if(m_modelSpaceTolerance > 0.0f && version != 2) {
+                KeyReducer keyReducer;
+                keyReducer.m_modelSpaceTolerance = m_modelSpaceTolerance;
+                keyReducer.reduce(encoded, skeleton, path);
+            }
+
+            if(version == 2) {
+                encoded.resample(skeleton, path);
+            }
+
+            encoded.save(scratchPath.c_str());
+
+            size_t size;
+
+            {
+                illFileSystem::File * openFile = illFileSystem::fileSystem->openRead(scratchPath.c_str());
+                size = openFile->getSize();
+                delete openFile;
+            }
+
+            //decode the way the runtime would for the version
+            Animation decoded;
+            ResampledAnimation resampled;
+            SegmentedPlayback segmented;
+            AnimationClip clip;
+
+            switch(version) {
+            case 2:
+                loadResampled(scratchPath.c_str(), resampled);
+                break;
+
+            case 3:
+                segmented.load(scratchPath.c_str());
+                break;
+
+            default:
+                decoded.load(scratchPath.c_str());
+                clip = decoded.getClip();
+                break;
+            }
+
+            remove(scratchPath.c_str());
+
+            AnimationCursor cursor;
+
+            auto samplePose = [&] (float time) {
+                switch(version) {
+                case 2:
+                    resampled.sample(time, pose);
+                    break;
+
+                case 3:
+                    segmented.sample(time, cursor, pose);
+                    break;
+
+                default:
+                    sampleAnimation(clip, time, cursor, pose);
+                    break;
+                }
+            };
+
+            //playing through the clip in order, the pose is reused like it would be every frame
+            pose = startPose;
+
+            if(version <= 1) {
+                cursor.reset(clip);
+            }
+
+            auto start = std::chrono::high_resolution_clock::now();
+
+            for(unsigned int iteration = 0; iteration < m_iterations; iteration++) {
+                for(unsigned int sample = 0; sample < m_numSamples; sample++) {
+                    samplePose(times[sample]);
+                }
+            }
+
+            double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+            //error at the virtual points
+            std::vector<float> points(pointFloats);
+            double totalError = 0.0;
+            float maxError = 0.0f;
+
+            for(unsigned int sample = 0; sample < m_numSamples; sample++) {
+                pose = startPose;
+                samplePose(times[sample]);
+
+                if(source.m_bindRelative) {
+                    applyBindPose(bindPose, pose);
+                }
+
+                computeVirtualPoints(pose, skeleton, m_pointOffset, localTransforms, modelTransforms, &points[0]);
+
+                const float * referencePoint = &referencePoints[sample * pointFloats];
+
+                for(size_t point = 0; point < pointFloats; point += 3) {
+                    float error = glm::length(glm::vec3(points[point], points[point + 1], points[point + 2])
+                        - glm::vec3(referencePoint[point], referencePoint[point + 1], referencePoint[point + 2]));
+
+                    maxError = std::max(maxError, error);
+                    totalError += error;
+                }
+            }
+
+            double boneSamplesPerSecond = seconds > 0.0 ? (double) numBones * m_numSamples * m_iterations / seconds : 0.0;
+            double meanError = totalError / ((double) m_numSamples * numBones * 3);
+
+            char row[1024];
+            snprintf(row, sizeof(row), ",%u,%g,%g,%g,%u,%.3f,%.0f,%g,%g\n", version,
+                encoded.getSaveFrameRate(), version == 3 ? encoded.getSaveSegmentFrames() / encoded.getSaveFrameRate() : 0.0f,
+                m_modelSpaceTolerance, (unsigned int) size, (double) uncompressedSize / size, boneSamplesPerSecond, maxError, meanError);
+
+            csv += quoteCsvField(skeletonPath) + "," + quoteCsvField(path) + row;
+        }
+    }
+
+    if(m_csvPath.empty()) {
+        LOG_INFO("%s", csv.c_str());
+        return;
+    }
+
+    illFileSystem::File * openFile = illFileSystem::fileSystem->openWrite(m_csvPath.c_str());
+    openFile->write(csv.c_str(), csv.size());
+    delete openFile;
+
+    LOG_INFO("Wrote animation benchmark results for %u clips to %s", (unsigned int) m_clips.size(), m_csvPath.c_str());
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#ifndef ILL_CONVERTER_BENCHMARKS_H_
+#define ILL_CONVERTER_BENCHMARKS_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+Times the runtime CPU skinning on already exported ILLMESH1 files and reports vertices per second.
+Skins with the skeleton's bind pose if there is one, or identity transforms otherwise, so it also
+checks that the skinned positions come back where the mesh has them.
+*/
+class SkinningBenchmark {
+public:
+    SkinningBenchmark()
+        : m_numThreads(0),
+        m_iterations(100)
+    {}
+
+    std::vector<std::string> m_meshPaths;
+    std::string m_skeletonPath;             //optional
+    unsigned int m_numThreads;              //0 means use the hardware thread count
+    unsigned int m_iterations;
+
+    void run();
+};
+
+/**
+Times sampling already exported animations with the runtime sampler, with a binary search per track for every sample,
+with a cursor per instance, and with all the instances of a clip sampled together.
+The instances are spread out over the clip and play forward, looping back to the start at the end.
+*/
+class AnimationSamplingBenchmark {
+public:
+    AnimationSamplingBenchmark()
+        : m_numInstances(64),
+        m_iterations(1000),
+        m_timeStep(1.0f / 60.0f)
+    {}
+
+    std::vector<std::string> m_animationPaths;
+    unsigned int m_numInstances;
+    unsigned int m_iterations;      //how many times each instance is stepped forward and sampled
+    float m_timeStep;               //seconds between samples
+
+    void run();
+};
+
+/**
+Checks the runtime pose evaluation against the same math done with plain glm matrices and quaternions,
+on random poses of a random hierarchy, and fails if any result is further off than the tolerance.
+Builds with ILL_SIMD_SCALAR, SSE, or AVX2 check that SIMD path.
+*/
+class PoseCheck {
+public:
+    PoseCheck()
+        : m_numBones(67),
+        m_numTrials(100),
+        m_tolerance(0.0001f),
+        m_seed(1)
+    {}
+
+    uint16_t m_numBones;            //not a multiple of SIMD_WIDTH so the partial last group gets checked too
+    unsigned int m_numTrials;
+    float m_tolerance;              //relative to the size of the values compared, or absolute below 1
+    unsigned int m_seed;
+
+    void run();
+};
+
+/**
+Saves animations as every version and measures what each one costs, as CSV so runs can be compared over time.
+For each clip and version it reports the file size, how many bone samples per second the runtime gets out of it,
+and the largest and mean error in model space compared to the clip as it was loaded.
+
+The error is measured at virtual points offset from every bone along each of its axes after going through the skeleton hierarchy,
+so rotation errors count by how far they move things and errors up a chain show up on every bone below.
+*/
+class AnimationCompressionBenchmark {
+public:
+    AnimationCompressionBenchmark()
+        : m_numSamples(200),
+        m_iterations(20),
+        m_pointOffset(0.1f),
+        m_frameRate(0.0f),
+        m_segmentLength(0.0f),
+        m_modelSpaceTolerance(0.0f)
+    {}
+
+    //a clip and the skeleton it animates
+    struct Clip {
+        std::string m_skeletonPath;
+        std::string m_animationPath;
+    };
+
+    std::vector<Clip> m_clips;
+    std::string m_csvPath;          //logged if empty
+    unsigned int m_numSamples;      //times spread over each clip that the error is measured at
+    unsigned int m_iterations;      //how many times all the samples are decoded for the throughput
+    float m_pointOffset;            //distance of the virtual points from their bone
+    float m_frameRate;              //0 for what the clip has
+    float m_segmentLength;          //0 for the default
+    float m_modelSpaceTolerance;    //if above 0 keys are reduced to this before saving
+
+    void run();
+};
+
+#endif
\ No newline at end of file
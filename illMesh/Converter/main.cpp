@@ -1,5 +1,6 @@
 #include <iostream>
 #include <cstring>
+#include <cstdlib>
 #include <vector>
 
 #include "illEngine/Logging/serial/SerialLogger.h"
@@ -9,11 +10,20 @@
 #include "illEngine/Logging/logging.h"
 
 #include "MeshMerger.h"
+#include "Reoptimizer.h"
+#include "benchmarks.h"
 #include "Importer.h"
 #include "Skeleton.h"
 #include "Mesh.h"
+#include "Occluder.h"
+#include "CollisionMesh.h"
+#include "MorphTargets.h"
 #include "AnimSet.h"
 #include "Animation.h"
+#include "KeyReducer.h"
+#include "AnimationBaker.h"
+#include "AnimationDatabase.h"
+#include "MeshBuffer.h"
 
 #include "asciiDump.h"
 
@@ -75,9 +85,416 @@ int main(int argc, const char ** argv) {
 
             return 0;
         }
+        else if(strncmp(argv[1], "-reoptimize", 15) == 0) {
+            LOG_INFO("Performing Reoptimize");
+
+            int arg = 2;
+
+            Reoptimizer reoptimizer;
+
+            while(arg < argc) {
+                const char * currArg = argv[arg++];
+
+                if(strncmp(currArg, "-threads", 10) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a number after the -threads parameter");
+                    }
+
+                    reoptimizer.m_numThreads = (unsigned int) atoi(argv[arg++]);
+                }
+                else if(strncmp(currArg, "-noweld", 10) == 0) {
+                    reoptimizer.m_optimizer.m_weld = false;
+                }
+                else if(strncmp(currArg, "-weldepsilon", 15) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a number after the -weldepsilon parameter");
+                    }
+
+                    reoptimizer.m_optimizer.m_weldEpsilon = (float) atof(argv[arg++]);
+                }
+                else if(strncmp(currArg, "-nocache", 10) == 0) {
+                    reoptimizer.m_optimizer.m_optimizeVertexCache = false;
+                }
+                else if(strncmp(currArg, "-cachesize", 15) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a number after the -cachesize parameter");
+                    }
+
+                    reoptimizer.m_optimizer.m_cacheSize = (unsigned int) atoi(argv[arg++]);
+
+                    if(reoptimizer.m_optimizer.m_cacheSize <= 3) {
+                        LOG_FATAL_ERROR("-cachesize needs to be bigger than 3");
+                    }
+                }
+                else if(strncmp(currArg, "-nofetch", 10) == 0) {
+                    reoptimizer.m_optimizer.m_optimizeVertexFetch = false;
+                }
+                else {
+                    reoptimizer.m_paths.push_back(currArg);
+                }
+            }
+
+            reoptimizer.reoptimize();
+
+            return 0;
+        }
+        else if(strncmp(argv[1], "-benchskin", 15) == 0) {
+            LOG_INFO("Performing Skinning Benchmark");
+
+            int arg = 2;
+
+            SkinningBenchmark benchmark;
+
+            while(arg < argc) {
+                const char * currArg = argv[arg++];
+
+                if(strncmp(currArg, "-threads", 10) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a number after the -threads parameter");
+                    }
+
+                    benchmark.m_numThreads = (unsigned int) atoi(argv[arg++]);
+                }
+                else if(strncmp(currArg, "-iterations", 15) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a number after the -iterations parameter");
+                    }
+
+                    benchmark.m_iterations = (unsigned int) atoi(argv[arg++]);
+
+                    if(benchmark.m_iterations == 0) {
+                        LOG_FATAL_ERROR("-iterations needs to be at least 1");
+                    }
+                }
+                else if(strncmp(currArg, "-skel", 10) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a skeleton file after the -skel parameter");
+                    }
+
+                    benchmark.m_skeletonPath = argv[arg++];
+                }
+                else {
+                    benchmark.m_meshPaths.push_back(currArg);
+                }
+            }
+
+            benchmark.run();
+
+            return 0;
+        }
+        else if(strncmp(argv[1], "-benchsample", 15) == 0) {
+            LOG_INFO("Performing Animation Sampling Benchmark");
+
+            int arg = 2;
+
+            AnimationSamplingBenchmark benchmark;
+
+            while(arg < argc) {
+                const char * currArg = argv[arg++];
+
+                if(strncmp(currArg, "-instances", 15) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a number after the -instances parameter");
+                    }
+
+                    benchmark.m_numInstances = (unsigned int) atoi(argv[arg++]);
+
+                    if(benchmark.m_numInstances == 0) {
+                        LOG_FATAL_ERROR("-instances needs to be at least 1");
+                    }
+                }
+                else if(strncmp(currArg, "-iterations", 15) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a number after the -iterations parameter");
+                    }
+
+                    benchmark.m_iterations = (unsigned int) atoi(argv[arg++]);
+
+                    if(benchmark.m_iterations == 0) {
+                        LOG_FATAL_ERROR("-iterations needs to be at least 1");
+                    }
+                }
+                else if(strncmp(currArg, "-timestep", 15) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting seconds after the -timestep parameter");
+                    }
+
+                    benchmark.m_timeStep = (float) atof(argv[arg++]);
+                }
+                else {
+                    benchmark.m_animationPaths.push_back(currArg);
+                }
+            }
+
+            benchmark.run();
+
+            return 0;
+        }
+        else if(strncmp(argv[1], "-benchanim", 15) == 0) {
+            LOG_INFO("Performing Animation Compression Benchmark");
+
+            int arg = 2;
+
+            AnimationCompressionBenchmark benchmark;
+            std::string skeletonPath;
+
+            while(arg < argc) {
+                const char * currArg = argv[arg++];
+
+                if(strncmp(currArg, "-skel", 10) == 0) {    //skeleton of the animations after it
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a skeleton file after the -skel parameter");
+                    }
+
+                    skeletonPath = argv[arg++];
+                }
+                else if(strncmp(currArg, "-csv", 10) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a file name after the -csv parameter");
+                    }
+
+                    benchmark.m_csvPath = argv[arg++];
+                }
+                else if(strncmp(currArg, "-samples", 15) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a number after the -samples parameter");
+                    }
+
+                    benchmark.m_numSamples = (unsigned int) atoi(argv[arg++]);
+
+                    if(benchmark.m_numSamples == 0) {
+                        LOG_FATAL_ERROR("-samples needs to be at least 1");
+                    }
+                }
+                else if(strncmp(currArg, "-iterations", 15) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a number after the -iterations parameter");
+                    }
+
+                    benchmark.m_iterations = (unsigned int) atoi(argv[arg++]);
+
+                    if(benchmark.m_iterations == 0) {
+                        LOG_FATAL_ERROR("-iterations needs to be at least 1");
+                    }
+                }
+                else if(strncmp(currArg, "-pointoffset", 15) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a distance after the -pointoffset parameter");
+                    }
+
+                    benchmark.m_pointOffset = (float) atof(argv[arg++]);
+                }
+                else if(strncmp(currArg, "-fps", 10) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a frame rate after the -fps parameter");
+                    }
+
+                    benchmark.m_frameRate = (float) atof(argv[arg++]);
+
+                    if(benchmark.m_frameRate <= 0.0f) {
+                        LOG_FATAL_ERROR("The -fps frame rate needs to be above 0");
+                    }
+                }
+                else if(strncmp(currArg, "-segment", 10) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting seconds after the -segment parameter");
+                    }
+
+                    benchmark.m_segmentLength = (float) atof(argv[arg++]);
+
+                    if(benchmark.m_segmentLength <= 0.0f) {
+                        LOG_FATAL_ERROR("The -segment length needs to be above 0");
+                    }
+                }
+                else if(strncmp(currArg, "-reduce", 10) == 0) {    //reduce keys to within this distance in model space first
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a distance after the -reduce parameter");
+                    }
+
+                    benchmark.m_modelSpaceTolerance = (float) atof(argv[arg++]);
+                }
+                else {
+                    if(skeletonPath.empty()) {
+                        LOG_FATAL_ERROR("Animation %s needs a skeleton, specify one with -skel before it", currArg);
+                    }
+
+                    AnimationCompressionBenchmark::Clip clip;
+                    clip.m_skeletonPath = skeletonPath;
+                    clip.m_animationPath = currArg;
+
+                    benchmark.m_clips.push_back(clip);
+                }
+            }
+
+            benchmark.run();
+
+            return 0;
+        }
+        else if(strncmp(argv[1], "-checkpose", 15) == 0) {
+            LOG_INFO("Performing Pose Check");
+
+            int arg = 2;
+
+            PoseCheck check;
+
+            while(arg < argc) {
+                const char * currArg = argv[arg++];
+
+                if(strncmp(currArg, "-bones", 10) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a number after the -bones parameter");
+                    }
+
+                    int numBones = atoi(argv[arg++]);
+
+                    if(numBones < 1 || numBones > 0xFFFF) {
+                        LOG_FATAL_ERROR("-bones needs to be between 1 and 65535");
+                    }
+
+                    check.m_numBones = (uint16_t) numBones;
+                }
+                else if(strncmp(currArg, "-trials", 10) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a number after the -trials parameter");
+                    }
+
+                    check.m_numTrials = (unsigned int) atoi(argv[arg++]);
+
+                    if(check.m_numTrials == 0) {
+                        LOG_FATAL_ERROR("-trials needs to be at least 1");
+                    }
+                }
+                else if(strncmp(currArg, "-tolerance", 15) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a number after the -tolerance parameter");
+                    }
+
+                    check.m_tolerance = (float) atof(argv[arg++]);
+                }
+                else if(strncmp(currArg, "-seed", 10) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a number after the -seed parameter");
+                    }
+
+                    check.m_seed = (unsigned int) atoi(argv[arg++]);
+                }
+                else {
+                    LOG_FATAL_ERROR("Unknown -checkpose parameter %s", currArg);
+                }
+            }
+
+            check.run();
+
+            return 0;
+        }
+        else if(strncmp(argv[1], "-bake", 10) == 0) {
+            LOG_INFO("Performing Animation Bake");
+
+            int arg = 2;
+
+            AnimationBaker baker;
+            std::string skeletonPath;
+            std::vector<std::string> meshPaths;
+            std::vector<std::string> animationPaths;
+            float frameRate = 0.0f;
+
+            while(arg < argc) {
+                const char * currArg = argv[arg++];
+
+                if(strncmp(currArg, "-skel", 10) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a skeleton file after the -skel parameter");
+                    }
+
+                    skeletonPath = argv[arg++];
+                }
+                else if(strncmp(currArg, "-mesh", 10) == 0) {    //bake skinned vertices of this mesh instead of bones
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a mesh file after the -mesh parameter");
+                    }
+
+                    meshPaths.push_back(argv[arg++]);
+                }
+                else if(strncmp(currArg, "-fps", 10) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a frame rate after the -fps parameter");
+                    }
+
+                    frameRate = (float) atof(argv[arg++]);
+
+                    if(frameRate <= 0.0f) {
+                        LOG_FATAL_ERROR("The -fps frame rate needs to be above 0");
+                    }
+                }
+                else if(strncmp(currArg, "-maxwidth", 15) == 0) {
+                    if(arg >= argc) {
+                        LOG_FATAL_ERROR("Expecting a number after the -maxwidth parameter");
+                    }
+
+                    baker.m_maxWidth = (uint32_t) atoi(argv[arg++]);
+
+                    if(baker.m_maxWidth == 0) {
+                        LOG_FATAL_ERROR("-maxwidth needs to be at least 1");
+                    }
+                }
+                else {
+                    animationPaths.push_back(currArg);
+                }
+            }
+
+            if(skeletonPath.empty()) {
+                LOG_FATAL_ERROR("Baking needs a skeleton, specify one with -skel");
+            }
+
+            Skeleton skeleton;
+            skeleton.load(skeletonPath.c_str(), NULL);
+
+            std::vector<MeshBuffer> meshes(meshPaths.size());
+
+            for(size_t mesh = 0; mesh < meshPaths.size(); mesh++) {
+                meshes[mesh].load(meshPaths[mesh].c_str());
+            }
+
+            for(auto iter = animationPaths.cbegin(); iter != animationPaths.end(); iter++) {
+                Animation animation;
+                animation.load(iter->c_str());
+
+                if(frameRate > 0.0f) {
+                    animation.m_frameRate = frameRate;
+                }
+
+                //bones go next to the animation, vertices next to the mesh named after the animation
+                if(meshPaths.empty()) {
+                    baker.bakeBones(animation, skeleton, Importer::computeSidecarFileName(*iter, ".illbake").c_str());
+                }
+                else {
+                    std::string animationStem = Importer::computeSidecarFileName(iter->substr(iter->find_last_of("/\\") + 1), "");
+
+                    for(size_t mesh = 0; mesh < meshPaths.size(); mesh++) {
+                        baker.bakeVertices(animation, skeleton, meshes[mesh],
+                            Importer::computeSidecarFileName(meshPaths[mesh], ("_" + animationStem + ".illbake").c_str()).c_str());
+                    }
+                }
+            }
+
+            return 0;
+        }
 
     
         const char * asetFile = NULL;
+        unsigned int skeletonVersion = 0;
+        bool skeletonModelBind = false;
+        bool boneLodMeshes = false;
+        bool keyReduce = false;
+        unsigned int animationVersion = 0;
+        float animationFrameRate = 0.0f;
+        float animationSegmentLength = 0.0f;
+        bool animationBindRelative = false;
+        float bindPositionTolerance = 0.0001f;
+        float bindRotationTolerance = 0.01f;
+        float bindScaleTolerance = 0.0001f;
+        const char * animationDatabaseFile = NULL;
+        KeyReducer keyReducer;
     
         Importer importer;
         importer.m_mainSkeletonImport = 0;
@@ -107,6 +524,191 @@ int main(int argc, const char ** argv) {
 
                         asetFile = argv[arg++];
 		            }
+                    else if(strncmp(currArg, "-ansetversion", 15) == 0) {    //animset file format version
+                        if(arg >= argc) {
+                            LOG_FATAL_ERROR("Expecting a version number after the -ansetversion parameter");
+                        }
+
+                        importer.m_animSet.m_version = (unsigned int) atoi(argv[arg++]);
+
+                        if(importer.m_animSet.m_version > 1) {
+                            LOG_FATAL_ERROR("Animset version %u isn't supported, the latest is 1", importer.m_animSet.m_version);
+                        }
+
+                        LOG_INFO("Exporting the animset as version %u", importer.m_animSet.m_version);
+                    }
+                    else if(strncmp(currArg, "-skelversion", 15) == 0) {    //skeleton file format version
+                        if(arg >= argc) {
+                            LOG_FATAL_ERROR("Expecting a version number after the -skelversion parameter");
+                        }
+
+                        skeletonVersion = (unsigned int) atoi(argv[arg++]);
+
+                        if(skeletonVersion > 2) {
+                            LOG_FATAL_ERROR("Skeleton version %u isn't supported, the latest is 2", skeletonVersion);
+                        }
+
+                        LOG_INFO("Exporting skeletons as version %u", skeletonVersion);
+                    }
+                    else if(strncmp(currArg, "-prunebones", 15) == 0) {    //remove bones that aren't weighted or animated
+                        importer.m_animSet.m_pruneBones = true;
+                        LOG_INFO("Pruning bones with no mesh weights and no animation");
+                    }
+                    else if(strncmp(currArg, "-keepbone", 10) == 0) {    //bone that's never pruned
+                        if(arg >= argc) {
+                            LOG_FATAL_ERROR("Expecting a bone name after the -keepbone parameter");
+                        }
+
+                        importer.m_animSet.m_keepBones.insert(argv[arg]);
+                        LOG_INFO("Keeping bone %s when pruning", argv[arg++]);
+                    }
+                    else if(strncmp(currArg, "-bonelod", 10) == 0) {    //next bone LOD keeps bones up to this depth
+                        if(arg >= argc) {
+                            LOG_FATAL_ERROR("Expecting a depth after the -bonelod parameter");
+                        }
+
+                        importer.m_animSet.m_lodMaxDepths.push_back((unsigned int) atoi(argv[arg++]));
+
+                        LOG_INFO("Bone LOD %u keeps bones up to depth %u",
+                            (unsigned int) importer.m_animSet.m_lodMaxDepths.size(), importer.m_animSet.m_lodMaxDepths.back());
+                    }
+                    else if(strncmp(currArg, "-bonelodfile", 15) == 0) {    //bones to drop from bone LODs by name
+                        if(arg >= argc) {
+                            LOG_FATAL_ERROR("Expecting a file name after the -bonelodfile parameter");
+                        }
+
+                        if(!illFileSystem::fileSystem->fileExists(argv[arg])) {
+                            LOG_FATAL_ERROR("Bone LOD file %s doesn't exist", argv[arg]);
+                        }
+
+                        importer.m_animSet.loadLodFile(argv[arg]);
+                        LOG_INFO("Using bone LOD file %s", argv[arg++]);
+                    }
+                    else if(strncmp(currArg, "-bonelodmeshes", 15) == 0) {    //mesh versions with weights moved off the bones each LOD drops
+                        boneLodMeshes = true;
+                        LOG_INFO("Exporting a mesh for each bone LOD");
+                    }
+                    else if(strncmp(currArg, "-threads", 10) == 0) {    //threads for loading the imports
+                        if(arg >= argc) {
+                            LOG_FATAL_ERROR("Expecting a number after the -threads parameter");
+                        }
+
+                        importer.m_numThreads = (unsigned int) atoi(argv[arg++]);
+                    }
+                    else if(strncmp(currArg, "-animversion", 15) == 0) {    //animation file format version
+                        if(arg >= argc) {
+                            LOG_FATAL_ERROR("Expecting a version number after the -animversion parameter");
+                        }
+
+                        animationVersion = (unsigned int) atoi(argv[arg++]);
+
+                        if(animationVersion > 3) {
+                            LOG_FATAL_ERROR("Animation version %u isn't supported, the latest is 3", animationVersion);
+                        }
+
+                        LOG_INFO("Exporting animations as version %u", animationVersion);
+                    }
+                    else if(strncmp(currArg, "-animframerate", 15) == 0) {    //frame rate key times are snapped to in animation version 1
+                        if(arg >= argc) {
+                            LOG_FATAL_ERROR("Expecting frames per second after the -animframerate parameter");
+                        }
+
+                        animationFrameRate = (float) atof(argv[arg++]);
+
+                        if(animationFrameRate <= 0.0f) {
+                            LOG_FATAL_ERROR("The -animframerate needs to be above 0");
+                        }
+
+                        LOG_INFO("Saving animation key times at %f frames per second", animationFrameRate);
+                    }
+                    else if(strncmp(currArg, "-animresample", 15) == 0) {    //export animations as version 2 sampled at a fixed rate
+                        if(arg >= argc) {
+                            LOG_FATAL_ERROR("Expecting frames per second after the -animresample parameter");
+                        }
+
+                        animationVersion = 2;
+                        animationFrameRate = (float) atof(argv[arg++]);
+
+                        if(animationFrameRate <= 0.0f) {
+                            LOG_FATAL_ERROR("The -animresample rate needs to be above 0");
+                        }
+
+                        LOG_INFO("Exporting animations as version 2 resampled at %f frames per second", animationFrameRate);
+                    }
+                    else if(strncmp(currArg, "-animsegment", 15) == 0) {    //export animations as version 3 split into segments this long
+                        if(arg >= argc) {
+                            LOG_FATAL_ERROR("Expecting seconds after the -animsegment parameter");
+                        }
+
+                        animationVersion = 3;
+                        animationSegmentLength = (float) atof(argv[arg++]);
+
+                        if(animationSegmentLength <= 0.0f) {
+                            LOG_FATAL_ERROR("The -animsegment length needs to be above 0");
+                        }
+
+                        LOG_INFO("Exporting animations as version 3 in %f second segments", animationSegmentLength);
+                    }
+                    else if(strncmp(currArg, "-animdb", 10) == 0) {    //save all the animations together in one database file
+                        if(arg >= argc) {
+                            LOG_FATAL_ERROR("Expecting a file name after the -animdb parameter");
+                        }
+
+                        animationDatabaseFile = argv[arg++];
+                        LOG_INFO("Exporting all animations to the animation database %s", animationDatabaseFile);
+                    }
+                    else if(strncmp(currArg, "-animbindrelative", 20) == 0) {    //store animation keys as deltas from the bind pose
+                        animationBindRelative = true;
+                        LOG_INFO("Exporting animation keys relative to the bind pose");
+                    }
+                    else if(strncmp(currArg, "-animbindtolerance", 20) == 0) {    //how close to the bind pose a channel is dropped
+                        if(arg + 2 >= argc) {
+                            LOG_FATAL_ERROR("Expecting a position, rotation in degrees, and scale tolerance after the -animbindtolerance parameter");
+                        }
+
+                        animationBindRelative = true;
+                        bindPositionTolerance = (float) atof(argv[arg++]);
+                        bindRotationTolerance = (float) atof(argv[arg++]);
+                        bindScaleTolerance = (float) atof(argv[arg++]);
+
+                        LOG_INFO("Exporting animation keys relative to the bind pose, dropping channels within position %f, rotation %f degrees, scale %f of it",
+                            bindPositionTolerance, bindRotationTolerance, bindScaleTolerance);
+                    }
+                    else if(strncmp(currArg, "-keyreduce", 15) == 0) {    //remove animation keys interpolation gives back
+                        keyReduce = true;
+                        LOG_INFO("Reducing animation keys");
+                    }
+                    else if(strncmp(currArg, "-keytolerance", 15) == 0) {    //key reduction tolerance for each channel
+                        if(arg + 2 >= argc) {
+                            LOG_FATAL_ERROR("Expecting a position, rotation in degrees, and scale tolerance after the -keytolerance parameter");
+                        }
+
+                        keyReduce = true;
+                        keyReducer.m_positionTolerance = (float) atof(argv[arg++]);
+                        keyReducer.m_rotationTolerance = (float) atof(argv[arg++]);
+                        keyReducer.m_scaleTolerance = (float) atof(argv[arg++]);
+
+                        LOG_INFO("Reducing animation keys with tolerances position %f, rotation %f degrees, scale %f",
+                            keyReducer.m_positionTolerance, keyReducer.m_rotationTolerance, keyReducer.m_scaleTolerance);
+                    }
+                    else if(strncmp(currArg, "-keyerror", 10) == 0) {    //key reduction tolerance as a distance in model space
+                        if(arg >= argc) {
+                            LOG_FATAL_ERROR("Expecting a distance after the -keyerror parameter");
+                        }
+
+                        keyReduce = true;
+                        keyReducer.m_modelSpaceTolerance = (float) atof(argv[arg++]);
+
+                        if(keyReducer.m_modelSpaceTolerance <= 0.0f) {
+                            LOG_FATAL_ERROR("The -keyerror distance needs to be above 0");
+                        }
+
+                        LOG_INFO("Reducing animation keys to within %f in model space", keyReducer.m_modelSpaceTolerance);
+                    }
+                    else if(strncmp(currArg, "-skelmodelbind", 15) == 0) {    //precomputed model space bind pose in the skeleton
+                        skeletonModelBind = true;
+                        LOG_INFO("Exporting model space bind transforms in skeletons, needs -skelversion 2");
+                    }
                     else if(strncmp(currArg, "-main", 10) == 0) {
                         LOG_FATAL_ERROR("-main paramater needs to come after a filename");
                     }
@@ -122,6 +724,24 @@ int main(int argc, const char ** argv) {
                     else if(strncmp(currArg, "-skelin", 10) == 0) {
                         LOG_FATAL_ERROR("-skelin paramater needs to come after a filename");
                     }
+                    else if(strncmp(currArg, "-occluder", 10) == 0) {
+                        LOG_FATAL_ERROR("-occluder paramater needs to come after a filename");
+                    }
+                    else if(strncmp(currArg, "-collision", 11) == 0) {
+                        LOG_FATAL_ERROR("-collision paramater needs to come after a filename");
+                    }
+                    else if(strncmp(currArg, "-rigid", 10) == 0) {
+                        LOG_FATAL_ERROR("-rigid paramater needs to come after a filename");
+                    }
+                    else if(strncmp(currArg, "-morph", 10) == 0) {
+                        LOG_FATAL_ERROR("-morph paramater needs to come after a filename");
+                    }
+                    else if(strncmp(currArg, "-influencegroups", 20) == 0) {
+                        LOG_FATAL_ERROR("-influencegroups paramater needs to come after a filename");
+                    }
+                    else if(strncmp(currArg, "-weightoverflow", 20) == 0) {
+                        LOG_FATAL_ERROR("-weightoverflow paramater needs to come after a filename");
+                    }
                     else {
                         if(!illFileSystem::fileSystem->fileExists(currArg)) {
                             LOG_FATAL_ERROR("File %s doesn't exist for import", currArg);
@@ -238,6 +858,66 @@ int main(int argc, const char ** argv) {
                         importer.m_mainSkeletonImport = importer.m_importFiles.size() - 1;
                         mainSkeletonImportSet = true;
                     }
+                    else if(strncmp(currArg, "-occluder", 10) == 0) {    //occluder alongside each mesh
+                        if(arg >= argc) {
+                            LOG_FATAL_ERROR("Expecting a triangle budget after the -occluder parameter");
+                        }
+
+                        importer.m_importFiles.back().m_occluderTriangles = (unsigned int) atoi(argv[arg++]);
+
+                        if(importer.m_importFiles.back().m_occluderTriangles < 12) {
+                            LOG_FATAL_ERROR("The -occluder triangle budget needs to be at least 12, the occluder is built out of boxes");
+                        }
+
+                        LOG_INFO("Exporting occluders with up to %u triangles", importer.m_importFiles.back().m_occluderTriangles);
+                    }
+                    else if(strncmp(currArg, "-collision", 11) == 0) {    //convex collision hulls alongside each mesh
+                        if(arg >= argc) {
+                            LOG_FATAL_ERROR("Expecting a max number of hulls for static meshes after the -collision parameter");
+                        }
+
+                        importer.m_importFiles.back().m_collisionHulls = (unsigned int) atoi(argv[arg++]);
+
+                        if(importer.m_importFiles.back().m_collisionHulls < 1) {
+                            LOG_FATAL_ERROR("The -collision max number of hulls needs to be at least 1");
+                        }
+
+                        LOG_INFO("Exporting collision hulls, up to %u per static mesh", importer.m_importFiles.back().m_collisionHulls);
+                    }
+                    else if(strncmp(currArg, "-morph", 10) == 0) {    //blend shapes alongside each mesh
+                        importer.m_importFiles.back().m_morphTargets = true;
+                        LOG_INFO("Exporting morph targets of meshes that have them");
+                    }
+                    else if(strncmp(currArg, "-rigid", 10) == 0) {    //rigidly bound meshes as attachments
+                        importer.m_importFiles.back().m_detectRigid = true;
+                        LOG_INFO("Exporting rigidly bound meshes and mesh parts as bone attachments");
+                    }
+                    else if(strncmp(currArg, "-influencegroups", 20) == 0) {    //group by bone influence count for specialized skinning
+                        importer.m_importFiles.back().m_influenceGroups = true;
+                        LOG_INFO("Grouping mesh vertices and faces by bone influence count");
+                    }
+                    else if(strncmp(currArg, "-weightoverflow", 20) == 0) {    //what to do with more than 4 bone influences on a vertex
+                        if(arg >= argc) {
+                            LOG_FATAL_ERROR("Expecting renormalize, drop, or fail after the -weightoverflow parameter");
+                        }
+
+                        const char * policy = argv[arg++];
+
+                        if(strncmp(policy, "renormalize", 15) == 0) {
+                            importer.m_importFiles.back().m_weightOverflow = BoneInfluences::OverflowPolicy::RENORMALIZE;
+                        }
+                        else if(strncmp(policy, "drop", 10) == 0) {
+                            importer.m_importFiles.back().m_weightOverflow = BoneInfluences::OverflowPolicy::DROP;
+                        }
+                        else if(strncmp(policy, "fail", 10) == 0) {
+                            importer.m_importFiles.back().m_weightOverflow = BoneInfluences::OverflowPolicy::FAIL;
+                        }
+                        else {
+                            LOG_FATAL_ERROR("Unknown -weightoverflow policy %s, expecting renormalize, drop, or fail", policy);
+                        }
+
+                        LOG_INFO("Using the %s policy for vertices with too many bone influences", policy);
+                    }
                     //TODO: add an arg for remapping coord systems
                     else {
                         //go back to main state
@@ -279,6 +959,32 @@ int main(int argc, const char ** argv) {
             }
         }
 
+        if(skeletonModelBind && skeletonVersion < 2) {
+            LOG_FATAL_ERROR("-skelmodelbind needs -skelversion 2 or above");
+        }
+
+        //the database quantizes keys like version 1, which also lets them be bind relative
+        if(animationDatabaseFile) {
+            if(animationVersion > 1) {
+                LOG_INFO("Warning: -animversion %u is ignored with -animdb, the database always quantizes keys like version 1", animationVersion);
+            }
+
+            animationVersion = 1;
+        }
+
+        if(animationBindRelative && animationVersion < 1) {
+            LOG_FATAL_ERROR("-animbindrelative needs -animversion 1 or above");
+        }
+
+        if(keyReduce && animationVersion == 2) {
+            LOG_INFO("Warning: key reduction is skipped for animation version 2 since it keeps every frame");
+            keyReduce = false;
+        }
+
+        if(importer.m_animSet.getNumLods() > 1 && skeletonVersion < 2) {
+            LOG_INFO("Warning: bone LODs are only saved in skeletons with -skelversion 2 or above");
+        }
+
         //do the imports of all the scenes for real now, creating the meshes, skeletons, animations
         importer.doImports();
 
@@ -287,8 +993,12 @@ int main(int argc, const char ** argv) {
             importer.m_animSet.save(asetFile);
         }
 
+        AnimationDatabase animationDatabase;
+
         for(auto iter = importer.m_importFiles.begin(); iter != importer.m_importFiles.end(); iter++) {
             if(iter->m_skelOutFile) {
+                iter->m_skeletonOut->m_version = skeletonVersion;
+                iter->m_skeletonOut->m_saveModelBind = skeletonModelBind;
                 iter->m_skeletonOut->save(importer.computeSkeletonFileName(iter->m_skeletonOut, iter->m_skelOutFile).c_str(), &importer.m_animSet);
             }
 
@@ -297,6 +1007,14 @@ int main(int argc, const char ** argv) {
 
                 if(iter->m_mergeMesh) {
                     merger.m_exportPath = iter->m_meshOutFile;
+
+                    if(boneLodMeshes && importer.m_animSet.getNumLods() > 1) {
+                        LOG_INFO("Warning: bone LOD meshes aren't exported for merged mesh %s", iter->m_meshOutFile);
+                    }
+
+                    if(iter->m_morphTargets) {
+                        LOG_INFO("Warning: morph targets aren't exported for merged mesh %s", iter->m_meshOutFile);
+                    }
                 }
                 
                 for(auto saveIter = iter->m_meshOut.cbegin(); saveIter != iter->m_meshOut.end(); saveIter++) {
@@ -304,6 +1022,40 @@ int main(int argc, const char ** argv) {
 
                     (*saveIter)->save(computedMeshName.c_str());
 
+                    //the same mesh with the weights of dropped bones moved to the closest kept ancestor
+                    if(boneLodMeshes && !iter->m_mergeMesh && (*saveIter)->m_mesh->HasBones() && !(*saveIter)->isRigid()) {
+                        for(unsigned int lod = 1; lod < importer.m_animSet.getNumLods(); lod++) {
+                            BoneInfluences lodInfluences = (*saveIter)->m_boneInfluences;
+                            lodInfluences.remapBones(importer.m_animSet.computeLodBoneRemap(lod));
+
+                            (*saveIter)->save(importer.computeLodFileName(computedMeshName, lod).c_str(), lodInfluences);
+                        }
+                    }
+
+                    if((*saveIter)->hasGroupInfo()) {
+                        (*saveIter)->saveGroups(importer.computeSidecarFileName(computedMeshName, ".illmgrp").c_str());
+                    }
+
+                    if(iter->m_occluderTriangles) {
+                        Occluder occluder;
+                        occluder.m_triangleBudget = iter->m_occluderTriangles;
+                        occluder.import(*saveIter);
+                        occluder.save(importer.computeSidecarFileName(computedMeshName, ".illoccl").c_str());
+                    }
+
+                    if(iter->m_collisionHulls) {
+                        CollisionMesh collision;
+                        collision.m_maxStaticHulls = iter->m_collisionHulls;
+                        collision.import(*saveIter, &importer.m_animSet);
+                        collision.save(importer.computeSidecarFileName(computedMeshName, ".illcoll").c_str());
+                    }
+
+                    if(iter->m_morphTargets && !iter->m_mergeMesh && (*saveIter)->m_mesh->mNumAnimMeshes > 0) {
+                        MorphTargets morphs;
+                        morphs.import(*saveIter);
+                        morphs.save(importer.computeSidecarFileName(computedMeshName, ".illmrph").c_str());
+                    }
+
                     if(iter->m_mergeMesh) {
                         merger.m_paths.push_back(computedMeshName);
                     }
@@ -323,10 +1075,41 @@ int main(int argc, const char ** argv) {
 
             if(iter->m_animOutFile) {
                 for(auto saveIter = iter->m_animationOut.cbegin(); saveIter != iter->m_animationOut.end(); saveIter++) {
-                    (*saveIter)->save(importer.computeAnimationFileName(*saveIter, iter->m_animOutFile).c_str());
+                    std::string computedAnimationName = importer.computeAnimationFileName(*saveIter, iter->m_animOutFile);
+
+                    (*saveIter)->m_version = animationVersion;
+                    (*saveIter)->m_frameRate = animationFrameRate;
+                    (*saveIter)->m_segmentLength = animationSegmentLength;
+
+                    if(animationBindRelative) {
+                        (*saveIter)->makeBindRelative(*importer.m_importFiles.at(importer.m_mainSkeletonImport).m_skeletonOut,
+                            bindPositionTolerance, bindRotationTolerance, bindScaleTolerance, computedAnimationName.c_str());
+                    }
+
+                    if(keyReduce) {
+                        keyReducer.reduce(**saveIter, *importer.m_importFiles.at(importer.m_mainSkeletonImport).m_skeletonOut, computedAnimationName.c_str());
+                    }
+
+                    if(animationVersion == 2) {
+                        (*saveIter)->resample(*importer.m_importFiles.at(importer.m_mainSkeletonImport).m_skeletonOut, computedAnimationName.c_str());
+                    }
+
+                    //the clip name is the file name it would have had without the directory or extension
+                    if(animationDatabaseFile) {
+                        animationDatabase.add(*saveIter, Importer::computeSidecarFileName(
+                            computedAnimationName.substr(computedAnimationName.find_last_of("/\\") + 1), ""));
+
+                        continue;
+                    }
+
+                    (*saveIter)->save(computedAnimationName.c_str());
                 }
             }
         }
+
+        if(animationDatabaseFile) {
+            animationDatabase.save(animationDatabaseFile);
+        }
     }
     catch (...) {
         return 1;
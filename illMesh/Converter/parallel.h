@@ -0,0 +1,52 @@
+#ifndef ILL_CONVERTER_PARALLEL_H_
+#define ILL_CONVERTER_PARALLEL_H_
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/**
+Runs function(index) for every index in [0, count) spread across worker threads.
+Indices are handed out one at a time so uneven jobs still balance out.
+
+The function shouldn't let exceptions escape, a thread with an uncaught exception takes down the whole converter.
+
+@param numThreads How many threads to use, 0 means use the hardware thread count.
+*/
+template <typename Function>
+void parallelFor(size_t count, unsigned int numThreads, Function function) {
+    if(numThreads == 0) {
+        numThreads = std::thread::hardware_concurrency();
+    }
+
+    if(numThreads > count) {
+        numThreads = (unsigned int) count;
+    }
+
+    //not worth spinning up threads
+    if(numThreads <= 1) {
+        for(size_t index = 0; index < count; index++) {
+            function(index);
+        }
+
+        return;
+    }
+
+    std::atomic<size_t> nextIndex(0);
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads);
+
+    for(unsigned int thread = 0; thread < numThreads; thread++) {
+        threads.push_back(std::thread([&nextIndex, count, &function] () {
+            for(size_t index = nextIndex++; index < count; index = nextIndex++) {
+                function(index);
+            }
+        }));
+    }
+
+    for(auto iter = threads.begin(); iter != threads.end(); iter++) {
+        iter->join();
+    }
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "AnimationCodec.h"
+
+void decodeRange(const uint16_t * quantized, size_t count, float min, float extent, float * values) {
+    size_t paddedCount = simdRoundUp(count);
+
+    for(size_t key = 0; key < count; key++) {
+        values[key] = (float) quantized[key];
+    }
+
+    for(size_t key = count; key < paddedCount; key++) {
+        values[key] = 0.0f;
+    }
+
+    SimdFloat scale = simdSet(extent / RANGE_QUANTIZED_MAX);
+    SimdFloat offset = simdSet(min);
+
+    for(size_t key = 0; key < paddedCount; key += SIMD_WIDTH) {
+        simdStore(values + key, simdMad(simdLoad(values + key), scale, offset));
+    }
+}
+
+void decodeSmallestThree(const uint16_t * components, size_t count, float * rotations) {
+    size_t stride = simdRoundUp(count);
+
+    //the three stored components go in x, y, and z for now
+    for(unsigned int word = 0; word < 3; word++) {
+        float * values = rotations + word * stride;
+
+        for(size_t key = 0; key < count; key++) {
+            values[key] = (float) (components[word * count + key] & SMALLEST_THREE_MASK);
+        }
+
+        for(size_t key = count; key < stride; key++) {
+            values[key] = 0.0f;
+        }
+    }
+
+    SimdFloat scale = simdSet(2.0f * SMALLEST_THREE_RANGE / SMALLEST_THREE_QUANTIZED_MAX);
+    SimdFloat offset = simdSet(-SMALLEST_THREE_RANGE);
+    SimdFloat one = simdSet(1.0f);
+    SimdFloat zero = simdSet(0.0f);
+
+    //dequantize and compute the dropped component into w
+    for(size_t key = 0; key < stride; key += SIMD_WIDTH) {
+        SimdFloat a = simdMad(simdLoad(rotations + key), scale, offset);
+        SimdFloat b = simdMad(simdLoad(rotations + stride + key), scale, offset);
+        SimdFloat c = simdMad(simdLoad(rotations + 2 * stride + key), scale, offset);
+
+        simdStore(rotations + key, a);
+        simdStore(rotations + stride + key, b);
+        simdStore(rotations + 2 * stride + key, c);
+
+        //quantization can push the sum just over 1
+        simdStore(rotations + 3 * stride + key, simdSqrt(simdMax(zero, one - a * a - b * b - c * c)));
+    }
+
+    //move the components over to make room for the dropped one where it goes, nothing to do if it was w
+    for(size_t key = 0; key < count; key++) {
+        unsigned int largest = ((components[key] >> 15) << 1) | (components[count + key] >> 15);
+
+        if(largest == 3) {
+            continue;
+        }
+
+        float dropped = rotations[3 * stride + key];
+
+        for(unsigned int component = 3; component > largest; component--) {
+            rotations[component * stride + key] = rotations[(component - 1) * stride + key];
+        }
+
+        rotations[largest * stride + key] = dropped;
+    }
+}
\ No newline at end of file
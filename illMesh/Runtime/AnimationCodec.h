@@ -0,0 +1,79 @@
+#ifndef ILL_RUNTIME_ANIMATION_CODEC_H_
+#define ILL_RUNTIME_ANIMATION_CODEC_H_
+
+#include <stdint.h>
+#include <cmath>
+
+#include "simd.h"
+
+/**
+The quantized key encodings of ILLANIM1.
+Each track channel's keys are stored as structure of arrays, all the x components then all the y components and so on,
+so a whole channel decodes with SIMD a key per lane.
+
+Positions and scales are 16 bits per component within the track's range.
+Rotations are smallest three, the largest component is dropped since it can be computed from the others,
+and the other three get 15 bits each.  The top bits of the first two say which one was dropped.
+*/
+
+const float RANGE_QUANTIZED_MAX = 65535.0f;
+const float SMALLEST_THREE_QUANTIZED_MAX = 32767.0f;
+const uint16_t SMALLEST_THREE_MASK = 0x7FFF;
+
+//the components other than the largest are at most this big
+const float SMALLEST_THREE_RANGE = 0.707106781f;
+
+inline uint16_t encodeRange(float value, float min, float extent) {
+    float normalized = extent > 0.0f ? (value - min) / extent : 0.0f;
+    normalized = normalized < 0.0f ? 0.0f : (normalized > 1.0f ? 1.0f : normalized);
+
+    return (uint16_t) floor(normalized * RANGE_QUANTIZED_MAX + 0.5f);
+}
+
+/**
+Encodes a normalized quaternion.
+@param rotation x, y, z, w
+@param components The three 16 bit words.
+*/
+inline void encodeSmallestThree(const float * rotation, uint16_t * components) {
+    unsigned int largest = 0;
+
+    for(unsigned int component = 1; component < 4; component++) {
+        if(fabs(rotation[component]) > fabs(rotation[largest])) {
+            largest = component;
+        }
+    }
+
+    //q and -q are the same rotation, flip it so the dropped component is positive
+    float sign = rotation[largest] < 0.0f ? -1.0f : 1.0f;
+    unsigned int word = 0;
+
+    for(unsigned int component = 0; component < 4; component++) {
+        if(component == largest) {
+            continue;
+        }
+
+        float normalized = (sign * rotation[component] / SMALLEST_THREE_RANGE + 1.0f) * 0.5f;
+        normalized = normalized < 0.0f ? 0.0f : (normalized > 1.0f ? 1.0f : normalized);
+
+        components[word++] = (uint16_t) floor(normalized * SMALLEST_THREE_QUANTIZED_MAX + 0.5f);
+    }
+
+    components[0] |= (uint16_t) ((largest >> 1) << 15);
+    components[1] |= (uint16_t) ((largest & 1) << 15);
+}
+
+/**
+Decodes count range quantized values.
+@param values SIMD aligned with room for count rounded up to SIMD_WIDTH.
+*/
+void decodeRange(const uint16_t * quantized, size_t count, float min, float extent, float * values);
+
+/**
+Decodes count smallest three rotations.
+@param components The first words of all the keys, then the second words, then the third.
+@param rotations x, y, z, then w arrays, each SIMD aligned and simdRoundUp(count) long.
+*/
+void decodeSmallestThree(const uint16_t * components, size_t count, float * rotations);
+
+#endif
\ No newline at end of file
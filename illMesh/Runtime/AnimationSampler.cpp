@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "AnimationSampler.h"
+#include "PoseBuffer.h"
+
+//the key at or before time, or the first key if time is before all of them
+inline uint32_t searchKey(const float * times, uint32_t numKeys, float time) {
+    uint32_t next = (uint32_t) (std::upper_bound(times, times + numKeys, time) - times);
+
+    return next > 0 ? next - 1 : 0;
+}
+
+//moves a key forward to the one at or before time, searching again if time went backwards
+inline uint32_t advanceKey(const float * times, uint32_t numKeys, uint32_t key, float time) {
+    if(key >= numKeys || time < times[key]) {
+        return searchKey(times, numKeys, time);
+    }
+
+    while(key + 1 < numKeys && times[key + 1] <= time) {
+        key++;
+    }
+
+    return key;
+}
+
+//how far time is from the key to the one after, 0 on the last key and before the first
+inline float keyWeight(const float * times, uint32_t numKeys, uint32_t key, float time) {
+    if(key + 1 >= numKeys || time <= times[key]) {
+        return 0.0f;
+    }
+
+    return std::min((time - times[key]) / (times[key + 1] - times[key]), 1.0f);
+}
+
+//lerps the xyz of a key and the next into the pose channels starting at firstChannel
+inline void sampleVector(const float * values, uint32_t numKeys, uint32_t key, float weight, uint16_t bone,
+        PoseBuffer& pose, PoseBuffer::Channel firstChannel) {
+    const float * from = values + key * 3;
+    const float * to = key + 1 < numKeys ? from + 3 : from;
+
+    for(unsigned int component = 0; component < 3; component++) {
+        pose.getChannel((PoseBuffer::Channel) (firstChannel + component))[bone] = from[component] + (to[component] - from[component]) * weight;
+    }
+}
+
+//nlerps a rotation key and the next the short way around into the pose
+inline void sampleRotation(const float * values, uint32_t numKeys, uint32_t key, float weight, uint16_t bone, PoseBuffer& pose) {
+    const float * from = values + key * 4;
+    const float * to = key + 1 < numKeys ? from + 4 : from;
+
+    float dot = from[0] * to[0] + from[1] * to[1] + from[2] * to[2] + from[3] * to[3];
+    float toWeight = dot < 0.0f ? -weight : weight;
+    float fromWeight = 1.0f - weight;
+
+    float blended[4];
+    float lengthSquared = 0.0f;
+
+    for(unsigned int component = 0; component < 4; component++) {
+        blended[component] = from[component] * fromWeight + to[component] * toWeight;
+        lengthSquared += blended[component] * blended[component];
+    }
+
+    float invLength = 1.0f / sqrt(lengthSquared);
+
+    for(unsigned int component = 0; component < 4; component++) {
+        pose.getChannel((PoseBuffer::Channel) (PoseBuffer::ROTATION_X + component))[bone] = blended[component] * invLength;
+    }
+}
+
+/**
+Samples one track into a pose.
+@param keys The key each channel of the track is at, updated to the keys for time.
+*/
+inline void sampleTrack(const AnimationClip& clip, const AnimationTrack& track, float time, uint32_t * keys, PoseBuffer& pose) {
+    for(unsigned int channel = 0; channel < NUM_ANIMATION_CHANNELS; channel++) {
+        uint32_t numKeys = track.m_numKeys[channel];
+
+        if(numKeys == 0) {
+            continue;
+        }
+
+        const float * times = clip.m_times[channel] + track.m_beginKey[channel];
+
+        keys[channel] = advanceKey(times, numKeys, keys[channel], time);
+        float weight = keyWeight(times, numKeys, keys[channel], time);
+
+        switch(channel) {
+        case ANIMATION_POSITION:
+            sampleVector(clip.m_positions + track.m_beginKey[channel] * 3, numKeys, keys[channel], weight, track.m_bone, pose, PoseBuffer::TRANSLATION_X);
+            break;
+
+        case ANIMATION_ROTATION:
+            sampleRotation(clip.m_rotations + track.m_beginKey[channel] * 4, numKeys, keys[channel], weight, track.m_bone, pose);
+            break;
+
+        case ANIMATION_SCALE:
+            sampleVector(clip.m_scales + track.m_beginKey[channel] * 3, numKeys, keys[channel], weight, track.m_bone, pose, PoseBuffer::SCALE_X);
+            break;
+        }
+    }
+}
+
+void AnimationCursor::reset(const AnimationClip& clip) {
+    m_keys.assign(clip.m_numTracks * NUM_ANIMATION_CHANNELS, 0);
+}
+
+void sampleAnimation(const AnimationClip& clip, float time, AnimationCursor& cursor, PoseBuffer& pose) {
+    assert(cursor.m_keys.size() == clip.m_numTracks * NUM_ANIMATION_CHANNELS);
+    assert(pose.m_numBones >= clip.m_numBones);
+
+    for(uint16_t track = 0; track < clip.m_numTracks; track++) {
+        sampleTrack(clip, clip.m_tracks[track], time, &cursor.m_keys[track * NUM_ANIMATION_CHANNELS], pose);
+    }
+}
+
+void sampleAnimationBatch(const AnimationClip& clip, const float * times, AnimationCursor * cursors, PoseBuffer * poses, size_t numInstances) {
+    for(uint16_t track = 0; track < clip.m_numTracks; track++) {
+        for(size_t instance = 0; instance < numInstances; instance++) {
+            assert(cursors[instance].m_keys.size() == clip.m_numTracks * NUM_ANIMATION_CHANNELS);
+            assert(poses[instance].m_numBones >= clip.m_numBones);
+
+            sampleTrack(clip, clip.m_tracks[track], times[instance], &cursors[instance].m_keys[track * NUM_ANIMATION_CHANNELS], poses[instance]);
+        }
+    }
+}
+
+void sampleAnimationSearch(const AnimationClip& clip, float time, PoseBuffer& pose) {
+    assert(pose.m_numBones >= clip.m_numBones);
+
+    for(uint16_t track = 0; track < clip.m_numTracks; track++) {
+        const AnimationTrack& currTrack = clip.m_tracks[track];
+
+        //keys past the end always search
+        uint32_t keys[NUM_ANIMATION_CHANNELS] = {
+            currTrack.m_numKeys[ANIMATION_POSITION],
+            currTrack.m_numKeys[ANIMATION_ROTATION],
+            currTrack.m_numKeys[ANIMATION_SCALE]
+        };
+
+        sampleTrack(clip, currTrack, time, keys, pose);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#ifndef ILL_RUNTIME_ANIMATION_SAMPLER_H_
+#define ILL_RUNTIME_ANIMATION_SAMPLER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+class PoseBuffer;
+
+/**
+Samples keyed animations, laid out the way the converter keeps them with each channel's keys in one array for all the tracks.
+Each playing instance has a cursor that remembers the key every track channel was at,
+so playing forward only ever steps a key or two ahead instead of searching.  Going back in time searches again.
+
+Only the bones with tracks are written to the pose, the others keep what was already there, usually the bind pose.
+*/
+
+enum AnimationChannel {
+    ANIMATION_POSITION,
+    ANIMATION_ROTATION,
+    ANIMATION_SCALE,
+
+    NUM_ANIMATION_CHANNELS
+};
+
+//the keys of one bone, for each channel a range of the key arrays that's sorted by time with no repeated times
+struct AnimationTrack {
+    uint16_t m_bone;
+    uint32_t m_beginKey[NUM_ANIMATION_CHANNELS];
+    uint32_t m_numKeys[NUM_ANIMATION_CHANNELS];
+};
+
+//points at the key arrays of an animation, nothing is copied
+struct AnimationClip {
+    const AnimationTrack * m_tracks;
+    uint16_t m_numTracks;
+    uint16_t m_numBones;        //one more than the highest bone of any track, how big the poses need to be
+
+    const float * m_times[NUM_ANIMATION_CHANNELS];
+    const float * m_positions;  //xyz for each key
+    const float * m_rotations;  //quaternion xyzw for each key
+    const float * m_scales;     //xyz for each key
+
+    float m_duration;
+};
+
+class AnimationCursor {
+public:
+    //starts over at the first keys of a clip
+    void reset(const AnimationClip& clip);
+
+    std::vector<uint32_t> m_keys;   //for each track each channel's key at or before the last time sampled
+};
+
+//samples a clip into a pose with a cursor that was reset for the clip
+void sampleAnimation(const AnimationClip& clip, float time, AnimationCursor& cursor, PoseBuffer& pose);
+
+/**
+Samples numInstances instances of the same clip, each at its own time with its own cursor and pose.
+Goes through the tracks once for all the instances so each track's keys only need to be brought into cache once.
+*/
+void sampleAnimationBatch(const AnimationClip& clip, const float * times, AnimationCursor * cursors, PoseBuffer * poses, size_t numInstances);
+
+//samples with a binary search through every track channel's keys, no cursor
+void sampleAnimationSearch(const AnimationClip& clip, float time, PoseBuffer& pose);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,195 @@
+#include <cstring>
+
+#include "AnimationSegment.h"
+#include "AnimationCodec.h"
+
+//the files are little endian
+inline uint16_t readSegment16(const uint8_t *& data) {
+    uint16_t value = (uint16_t) (data[0] | (data[1] << 8));
+    data += 2;
+
+    return value;
+}
+
+inline float readSegmentFloat(const uint8_t *& data) {
+    uint32_t bits = (uint32_t) data[0] | ((uint32_t) data[1] << 8) | ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24);
+    data += 4;
+
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+//bytes of a channel's keys after its number of keys, positions and scales have their bounds then frames and xyz, rotations frames and 3 words
+inline size_t computeSegmentChannelSize(unsigned int channel, uint16_t numKeys) {
+    return channel == ANIMATION_ROTATION ? (size_t) numKeys * 8 : 24 + (size_t) numKeys * 8;
+}
+
+//reads the frames of a channel's keys as times
+inline void readSegmentFrames(const uint8_t *& data, uint16_t numKeys, float frameRate, float beginTime, std::vector<float>& times) {
+    for(uint16_t key = 0; key < numKeys; key++) {
+        times.push_back(beginTime + readSegment16(data) / frameRate);
+    }
+}
+
+//decodes a position or scale channel, appending xyz for each key
+void decodeSegmentVectors(const uint8_t *& data, uint16_t numKeys, float frameRate, float beginTime,
+        std::vector<float>& times, std::vector<float>& values, std::vector<uint16_t>& quantized, std::vector<float>& decodeBuffer) {
+    float min[3];
+    float extent[3];
+
+    for(unsigned int component = 0; component < 3; component++) {
+        min[component] = readSegmentFloat(data);
+    }
+
+    for(unsigned int component = 0; component < 3; component++) {
+        extent[component] = readSegmentFloat(data);
+    }
+
+    readSegmentFrames(data, numKeys, frameRate, beginTime, times);
+
+    size_t beginValue = values.size();
+    values.resize(beginValue + numKeys * 3);
+
+    quantized.resize(numKeys);
+    decodeBuffer.resize(simdRoundUp(numKeys) + SIMD_WIDTH);
+    float * decoded = simdAlign(&decodeBuffer[0]);
+
+    for(unsigned int component = 0; component < 3; component++) {
+        for(uint16_t key = 0; key < numKeys; key++) {
+            quantized[key] = readSegment16(data);
+        }
+
+        decodeRange(&quantized[0], numKeys, min[component], extent[component], decoded);
+
+        for(uint16_t key = 0; key < numKeys; key++) {
+            values[beginValue + key * 3 + component] = decoded[key];
+        }
+    }
+}
+
+//decodes a rotation channel, appending xyzw for each key
+void decodeSegmentRotations(const uint8_t *& data, uint16_t numKeys, float frameRate, float beginTime,
+        std::vector<float>& times, std::vector<float>& values, std::vector<uint16_t>& quantized, std::vector<float>& decodeBuffer) {
+    readSegmentFrames(data, numKeys, frameRate, beginTime, times);
+
+    quantized.resize(numKeys * 3);
+
+    for(size_t word = 0; word < quantized.size(); word++) {
+        quantized[word] = readSegment16(data);
+    }
+
+    size_t stride = simdRoundUp(numKeys);
+    decodeBuffer.resize(stride * 4 + SIMD_WIDTH);
+    float * decoded = simdAlign(&decodeBuffer[0]);
+
+    decodeSmallestThree(&quantized[0], numKeys, decoded);
+
+    size_t beginValue = values.size();
+    values.resize(beginValue + numKeys * 4);
+
+    for(uint16_t key = 0; key < numKeys; key++) {
+        for(unsigned int component = 0; component < 4; component++) {
+            values[beginValue + key * 4 + component] = decoded[component * stride + key];
+        }
+    }
+}
+
+bool AnimationSegment::decode(const uint8_t * data, size_t size, const uint16_t * bones, uint16_t numTracks, float frameRate, float beginTime, float endTime) {
+    const uint8_t * end = data + size;
+
+    clear();
+
+    m_beginTime = beginTime;
+    m_endTime = endTime;
+    m_tracks.resize(numTracks);
+
+    std::vector<uint16_t> quantized;
+    std::vector<float> decodeBuffer;
+
+    for(uint16_t track = 0; track < numTracks; track++) {
+        AnimationTrack& currTrack = m_tracks[track];
+        currTrack.m_bone = bones[track];
+
+        for(unsigned int channel = 0; channel < NUM_ANIMATION_CHANNELS; channel++) {
+            //the bytes may be memory mapped straight out of a file, so the key counts can't be trusted to stay inside them
+            if(end - data < 2) {
+                clear();
+                return false;
+            }
+
+            uint16_t numKeys = readSegment16(data);
+
+            currTrack.m_beginKey[channel] = (uint32_t) m_times[channel].size();
+            currTrack.m_numKeys[channel] = numKeys;
+
+            if(numKeys == 0) {
+                continue;
+            }
+
+            if((size_t) (end - data) < computeSegmentChannelSize(channel, numKeys)) {
+                clear();
+                return false;
+            }
+
+            switch(channel) {
+            case ANIMATION_POSITION:
+                decodeSegmentVectors(data, numKeys, frameRate, beginTime, m_times[channel], m_positions, quantized, decodeBuffer);
+                break;
+
+            case ANIMATION_ROTATION:
+                decodeSegmentRotations(data, numKeys, frameRate, beginTime, m_times[channel], m_rotations, quantized, decodeBuffer);
+                break;
+
+            case ANIMATION_SCALE:
+                decodeSegmentVectors(data, numKeys, frameRate, beginTime, m_times[channel], m_scales, quantized, decodeBuffer);
+                break;
+            }
+        }
+    }
+
+    if(data != end) {
+        clear();
+        return false;
+    }
+
+    return true;
+}
+
+void AnimationSegment::clear() {
+    m_beginTime = 0.0f;
+    m_endTime = 0.0f;
+    m_tracks.clear();
+
+    for(unsigned int channel = 0; channel < NUM_ANIMATION_CHANNELS; channel++) {
+        m_times[channel].clear();
+    }
+
+    m_positions.clear();
+    m_rotations.clear();
+    m_scales.clear();
+}
+
+AnimationClip AnimationSegment::getClip() const {
+    AnimationClip clip;
+
+    clip.m_tracks = m_tracks.empty() ? NULL : &m_tracks[0];
+    clip.m_numTracks = (uint16_t) m_tracks.size();
+    clip.m_numBones = 0;
+
+    for(auto iter = m_tracks.cbegin(); iter != m_tracks.end(); iter++) {
+        clip.m_numBones = iter->m_bone + 1 > clip.m_numBones ? (uint16_t) (iter->m_bone + 1) : clip.m_numBones;
+    }
+
+    for(unsigned int channel = 0; channel < NUM_ANIMATION_CHANNELS; channel++) {
+        clip.m_times[channel] = m_times[channel].empty() ? NULL : &m_times[channel][0];
+    }
+
+    clip.m_positions = m_positions.empty() ? NULL : &m_positions[0];
+    clip.m_rotations = m_rotations.empty() ? NULL : &m_rotations[0];
+    clip.m_scales = m_scales.empty() ? NULL : &m_scales[0];
+    clip.m_duration = m_endTime;
+
+    return clip;
+}
\ No newline at end of file
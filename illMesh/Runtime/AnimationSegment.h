@@ -0,0 +1,62 @@
+#ifndef ILL_RUNTIME_ANIMATION_SEGMENT_H_
+#define ILL_RUNTIME_ANIMATION_SEGMENT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "AnimationSampler.h"
+
+/**
+One time segment of an ILLANIM3 animation.
+The header has the segment length, the bone of each track, and the file offset of every segment,
+so finding the segment for a time and reading just its bytes doesn't depend on how long the clip is.
+Only the segments around the playback time need to be loaded, streaming the next one in ahead of time.
+
+Every segment has the keys of all the tracks in its window as quantized ILLANIM1 channels,
+with keys added at both ends of the window so it samples without the segments around it.
+Cursors need to be reset when moving to a different segment since the key ranges are different.
+*/
+class AnimationSegment {
+public:
+    AnimationSegment()
+        : m_beginTime(0.0f),
+        m_endTime(0.0f)
+    {}
+
+    /**
+    Decodes the bytes of a segment as they are in the file.
+    @param bones The bone of each track from the header.
+    @param beginTime When the segment starts, key times in the segment are relative to it.
+    @return False if the keys don't exactly fill the bytes, the segment is left empty.
+    */
+    bool decode(const uint8_t * data, size_t size, const uint16_t * bones, uint16_t numTracks, float frameRate, float beginTime, float endTime);
+
+    //no tracks or keys
+    void clear();
+
+    //the decoded keys for the sampler, only good until the next decode
+    AnimationClip getClip() const;
+
+    float m_beginTime;
+    float m_endTime;
+
+    std::vector<AnimationTrack> m_tracks;
+    std::vector<float> m_times[NUM_ANIMATION_CHANNELS];
+    std::vector<float> m_positions;
+    std::vector<float> m_rotations;
+    std::vector<float> m_scales;
+};
+
+//which segment a time is in, times outside the clip are in the first or last one
+inline uint32_t findAnimationSegment(float time, float segmentLength, uint32_t numSegments) {
+    if(time <= 0.0f) {
+        return 0;
+    }
+
+    uint32_t segment = (uint32_t) (time / segmentLength);
+
+    return segment < numSegments ? segment : numSegments - 1;
+}
+
+#endif
\ No newline at end of file
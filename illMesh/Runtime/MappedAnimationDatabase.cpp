@@ -0,0 +1,139 @@
+#include <cstring>
+#include <vector>
+
+#include "MappedAnimationDatabase.h"
+#include "AnimationSegment.h"
+
+//bytes of each clip's directory entry: name hash, offset, size, duration, frame rate, flags, and number of tracks
+const size_t DATABASE_ENTRY_SIZE = 24;
+
+const uint16_t DATABASE_FLAG_BIND_RELATIVE = 1 << 0;
+
+//the files are little endian
+inline uint16_t readDatabase16(const uint8_t * data) {
+    return (uint16_t) (data[0] | (data[1] << 8));
+}
+
+inline uint32_t readDatabase32(const uint8_t * data) {
+    return (uint32_t) data[0] | ((uint32_t) data[1] << 8) | ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24);
+}
+
+inline float readDatabaseFloat(const uint8_t * data) {
+    uint32_t bits = readDatabase32(data);
+
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+bool MappedAnimationDatabase::open(const uint8_t * data, size_t size) {
+    //magic, alignment, and number of descriptors
+    if(size < 12 || memcmp(data, "ILLANDB0", 8) != 0) {
+        return false;
+    }
+
+    uint16_t numDescriptors = readDatabase16(data + 10);
+
+    //number of clips and where the names start, names are only for tools
+    size_t directoryOffset = 12 + (size_t) numDescriptors * 2 + 8;
+
+    if(directoryOffset > size) {
+        return false;
+    }
+
+    uint32_t numClips = readDatabase32(data + directoryOffset - 8);
+
+    if((uint64_t) numClips * DATABASE_ENTRY_SIZE > size - directoryOffset) {
+        return false;
+    }
+
+    //every clip's keys need to be inside the file with room for the mask of its tracks
+    size_t maskSize = (numDescriptors + 7) / 8;
+
+    for(uint32_t clip = 0; clip < numClips; clip++) {
+        const uint8_t * entry = data + directoryOffset + clip * DATABASE_ENTRY_SIZE;
+
+        uint32_t clipOffset = readDatabase32(entry + 4);
+        uint32_t clipSize = readDatabase32(entry + 8);
+
+        if(clipSize < maskSize || clipOffset > size || clipSize > size - clipOffset) {
+            return false;
+        }
+    }
+
+    m_data = data;
+    m_size = size;
+
+    m_numDescriptors = numDescriptors;
+    m_descriptors = data + 12;
+
+    m_numClips = numClips;
+    m_directory = data + directoryOffset;
+
+    return true;
+}
+
+int32_t MappedAnimationDatabase::findClip(uint32_t nameHash) const {
+    uint32_t begin = 0;
+    uint32_t end = m_numClips;
+
+    while(begin < end) {
+        uint32_t middle = begin + (end - begin) / 2;
+        uint32_t middleHash = readDatabase32(m_directory + middle * DATABASE_ENTRY_SIZE);
+
+        if(middleHash == nameHash) {
+            return (int32_t) middle;
+        }
+
+        if(middleHash < nameHash) {
+            begin = middle + 1;
+        }
+        else {
+            end = middle;
+        }
+    }
+
+    return -1;
+}
+
+float MappedAnimationDatabase::getDuration(uint32_t clip) const {
+    return readDatabaseFloat(m_directory + clip * DATABASE_ENTRY_SIZE + 12);
+}
+
+float MappedAnimationDatabase::getFrameRate(uint32_t clip) const {
+    return readDatabaseFloat(m_directory + clip * DATABASE_ENTRY_SIZE + 16);
+}
+
+bool MappedAnimationDatabase::isBindRelative(uint32_t clip) const {
+    return (readDatabase16(m_directory + clip * DATABASE_ENTRY_SIZE + 20) & DATABASE_FLAG_BIND_RELATIVE) != 0;
+}
+
+bool MappedAnimationDatabase::decodeClip(uint32_t clip, AnimationSegment& decoded) const {
+    const uint8_t * entry = m_directory + clip * DATABASE_ENTRY_SIZE;
+
+    const uint8_t * payload = m_data + readDatabase32(entry + 4);
+    size_t payloadSize = readDatabase32(entry + 8);
+    uint16_t numTracks = readDatabase16(entry + 22);
+
+    //the bones of the clip's tracks from the descriptors it has bits set for
+    std::vector<uint16_t> bones;
+    bones.reserve(numTracks);
+
+    for(uint16_t descriptor = 0; descriptor < m_numDescriptors; descriptor++) {
+        if(payload[descriptor >> 3] & (1 << (descriptor & 7))) {
+            bones.push_back(readDatabase16(m_descriptors + descriptor * 2));
+        }
+    }
+
+    size_t maskSize = (m_numDescriptors + 7) / 8;
+
+    //the keys are laid out for the tracks in the mask, if the entry disagrees they can't be read
+    if(bones.size() != numTracks) {
+        decoded.clear();
+        return false;
+    }
+
+    return decoded.decode(payload + maskSize, payloadSize - maskSize, bones.empty() ? NULL : &bones[0], numTracks,
+        getFrameRate(clip), 0.0f, getDuration(clip));
+}
\ No newline at end of file
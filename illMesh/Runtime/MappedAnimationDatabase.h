@@ -0,0 +1,70 @@
+#ifndef ILL_RUNTIME_MAPPED_ANIMATION_DATABASE_H_
+#define ILL_RUNTIME_MAPPED_ANIMATION_DATABASE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+class AnimationSegment;
+
+/**
+All the clips of an animset in one ILLANDB0 file, read straight out of the file's bytes so the whole thing can be memory mapped.
+
+The header has a table of track descriptors, the bone of every track any clip has in bone index order,
+then the clip directory sorted by name hash so finding a clip is a binary search.
+Each clip's keys start on an alignment boundary with a bit per descriptor saying which tracks the clip has,
+then the channels of those tracks quantized like ILLANIM1 with their key times as frames from the start of the clip.
+*/
+class MappedAnimationDatabase {
+public:
+    MappedAnimationDatabase()
+        : m_data(NULL),
+        m_size(0),
+        m_numDescriptors(0),
+        m_descriptors(NULL),
+        m_numClips(0),
+        m_directory(NULL)
+    {}
+
+    /**
+    Points at the bytes of an ILLANDB0 file, which need to stay around as long as the database is used.
+    @return False if the bytes aren't an ILLANDB0 file, or its directory or any clip's keys run past the end of them.
+    */
+    bool open(const uint8_t * data, size_t size);
+
+    //the directory index of a clip, or -1 if there's no clip with the name hash
+    int32_t findClip(uint32_t nameHash) const;
+
+    float getDuration(uint32_t clip) const;
+    float getFrameRate(uint32_t clip) const;
+
+    //whether the clip's keys are deltas from the bind pose
+    bool isBindRelative(uint32_t clip) const;
+
+    /**
+    Decodes the keys of a clip into a segment that covers the whole clip.
+    @return False if the clip's number of tracks doesn't match its track mask or its keys don't fit in its bytes, the segment is left empty.
+    */
+    bool decodeClip(uint32_t clip, AnimationSegment& decoded) const;
+
+    const uint8_t * m_data;
+    size_t m_size;
+
+    uint16_t m_numDescriptors;
+    const uint8_t * m_descriptors;      //the bone of each descriptor, 16 bit little endian
+
+    uint32_t m_numClips;
+    const uint8_t * m_directory;
+};
+
+//FNV-1a of a clip name, what the directory is sorted by
+inline uint32_t hashAnimationName(const char * name) {
+    uint32_t hash = 2166136261u;
+
+    for(; *name != '\0'; name++) {
+        hash = (hash ^ (uint8_t) *name) * 16777619u;
+    }
+
+    return hash;
+}
+
+#endif
\ No newline at end of file
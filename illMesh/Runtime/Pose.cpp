@@ -0,0 +1,179 @@
+#include <cassert>
+#include <cstring>
+
+#include "Pose.h"
+#include "PoseBuffer.h"
+
+//the channels that blend linearly
+const PoseBuffer::Channel LERP_CHANNELS[] = {
+    PoseBuffer::TRANSLATION_X,
+    PoseBuffer::TRANSLATION_Y,
+    PoseBuffer::TRANSLATION_Z,
+    PoseBuffer::SCALE_X,
+    PoseBuffer::SCALE_Y,
+    PoseBuffer::SCALE_Z
+};
+
+void blendPoses(const PoseBuffer& from, const PoseBuffer& to, float weight, PoseBuffer& result) {
+    assert(from.m_numBones == to.m_numBones);
+
+    if(result.m_numBones != from.m_numBones) {
+        result.resize(from.m_numBones);
+    }
+
+    SimdFloat blendWeight = simdSet(weight);
+
+    for(size_t bone = 0; bone < from.m_stride; bone += SIMD_WIDTH) {
+        //translation and scale
+        for(unsigned int channel = 0; channel < sizeof(LERP_CHANNELS) / sizeof(LERP_CHANNELS[0]); channel++) {
+            SimdFloat fromValue = simdLoad(from.getChannel(LERP_CHANNELS[channel]) + bone);
+            SimdFloat toValue = simdLoad(to.getChannel(LERP_CHANNELS[channel]) + bone);
+
+            simdStore(result.getChannel(LERP_CHANNELS[channel]) + bone, simdMad(toValue - fromValue, blendWeight, fromValue));
+        }
+
+        //rotation
+        SimdFloat fromRotation[4];
+        SimdFloat toRotation[4];
+
+        for(unsigned int component = 0; component < 4; component++) {
+            fromRotation[component] = simdLoad(from.getChannel((PoseBuffer::Channel) (PoseBuffer::ROTATION_X + component)) + bone);
+            toRotation[component] = simdLoad(to.getChannel((PoseBuffer::Channel) (PoseBuffer::ROTATION_X + component)) + bone);
+        }
+
+        //q and -q are the same rotation, flip to so it's on the same side as from and the blend goes the short way
+        SimdFloat dot = fromRotation[0] * toRotation[0];
+
+        for(unsigned int component = 1; component < 4; component++) {
+            dot = simdMad(fromRotation[component], toRotation[component], dot);
+        }
+
+        SimdFloat sign = simdCopySign(simdSet(1.0f), dot);
+        SimdFloat blended[4];
+
+        for(unsigned int component = 0; component < 4; component++) {
+            blended[component] = simdMad(toRotation[component] * sign - fromRotation[component], blendWeight, fromRotation[component]);
+        }
+
+        SimdFloat lengthSquared = blended[0] * blended[0];
+
+        for(unsigned int component = 1; component < 4; component++) {
+            lengthSquared = simdMad(blended[component], blended[component], lengthSquared);
+        }
+
+        SimdFloat invLength = simdSet(1.0f) / simdSqrt(lengthSquared);
+
+        for(unsigned int component = 0; component < 4; component++) {
+            simdStore(result.getChannel((PoseBuffer::Channel) (PoseBuffer::ROTATION_X + component)) + bone, blended[component] * invLength);
+        }
+    }
+}
+
+void computeLocalTransforms(const PoseBuffer& pose, uint16_t numBones, float * localTransforms) {
+    assert(numBones <= pose.m_numBones);
+
+    SimdFloat one = simdSet(1.0f);
+    SimdFloat two = simdSet(2.0f);
+
+    //one SIMD_WIDTH group of transforms as structure of arrays before they get spread out to the bones
+    float transposeBuffer[AFFINE_FLOATS * SIMD_WIDTH + SIMD_WIDTH];
+    float * transposed = simdAlign(transposeBuffer);
+
+    for(size_t firstBone = 0; firstBone < numBones; firstBone += SIMD_WIDTH) {
+        SimdFloat x = simdLoad(pose.getChannel(PoseBuffer::ROTATION_X) + firstBone);
+        SimdFloat y = simdLoad(pose.getChannel(PoseBuffer::ROTATION_Y) + firstBone);
+        SimdFloat z = simdLoad(pose.getChannel(PoseBuffer::ROTATION_Z) + firstBone);
+        SimdFloat w = simdLoad(pose.getChannel(PoseBuffer::ROTATION_W) + firstBone);
+
+        SimdFloat scaleX = simdLoad(pose.getChannel(PoseBuffer::SCALE_X) + firstBone);
+        SimdFloat scaleY = simdLoad(pose.getChannel(PoseBuffer::SCALE_Y) + firstBone);
+        SimdFloat scaleZ = simdLoad(pose.getChannel(PoseBuffer::SCALE_Z) + firstBone);
+
+        SimdFloat xx = x * x * two;
+        SimdFloat yy = y * y * two;
+        SimdFloat zz = z * z * two;
+        SimdFloat xy = x * y * two;
+        SimdFloat xz = x * z * two;
+        SimdFloat yz = y * z * two;
+        SimdFloat wx = w * x * two;
+        SimdFloat wy = w * y * two;
+        SimdFloat wz = w * z * two;
+
+        //rotation matrix with the columns scaled, then the translation
+        simdStore(transposed + 0 * SIMD_WIDTH, (one - yy - zz) * scaleX);
+        simdStore(transposed + 1 * SIMD_WIDTH, (xy - wz) * scaleY);
+        simdStore(transposed + 2 * SIMD_WIDTH, (xz + wy) * scaleZ);
+        simdStore(transposed + 3 * SIMD_WIDTH, simdLoad(pose.getChannel(PoseBuffer::TRANSLATION_X) + firstBone));
+
+        simdStore(transposed + 4 * SIMD_WIDTH, (xy + wz) * scaleX);
+        simdStore(transposed + 5 * SIMD_WIDTH, (one - xx - zz) * scaleY);
+        simdStore(transposed + 6 * SIMD_WIDTH, (yz - wx) * scaleZ);
+        simdStore(transposed + 7 * SIMD_WIDTH, simdLoad(pose.getChannel(PoseBuffer::TRANSLATION_Y) + firstBone));
+
+        simdStore(transposed + 8 * SIMD_WIDTH, (xz - wy) * scaleX);
+        simdStore(transposed + 9 * SIMD_WIDTH, (yz + wx) * scaleY);
+        simdStore(transposed + 10 * SIMD_WIDTH, (one - xx - yy) * scaleZ);
+        simdStore(transposed + 11 * SIMD_WIDTH, simdLoad(pose.getChannel(PoseBuffer::TRANSLATION_Z) + firstBone));
+
+        size_t groupBones = numBones - firstBone < SIMD_WIDTH ? numBones - firstBone : SIMD_WIDTH;
+
+        for(size_t lane = 0; lane < groupBones; lane++) {
+            float * transform = localTransforms + (firstBone + lane) * AFFINE_FLOATS;
+
+            for(unsigned int element = 0; element < AFFINE_FLOATS; element++) {
+                transform[element] = transposed[element * SIMD_WIDTH + lane];
+            }
+        }
+    }
+}
+
+void multiplyAffine(const float * left, const float * right, float * result) {
+#ifdef ILL_SIMD_SCALAR
+    for(unsigned int row = 0; row < 3; row++) {
+        for(unsigned int col = 0; col < 4; col++) {
+            result[row * 4 + col] = left[row * 4] * right[col]
+                + left[row * 4 + 1] * right[4 + col]
+                + left[row * 4 + 2] * right[8 + col]
+                + (col == 3 ? left[row * 4 + 3] : 0.0f);
+        }
+    }
+#else
+    //each result row is a weighted sum of the right rows, plus the left translation for the implied 0 0 0 1 bottom row
+    __m128 right0 = _mm_loadu_ps(right);
+    __m128 right1 = _mm_loadu_ps(right + 4);
+    __m128 right2 = _mm_loadu_ps(right + 8);
+    __m128 translationMask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+
+    for(unsigned int row = 0; row < 3; row++) {
+        const float * leftRow = left + row * 4;
+
+        __m128 res = _mm_mul_ps(_mm_set1_ps(leftRow[0]), right0);
+        res = _mm_add_ps(res, _mm_mul_ps(_mm_set1_ps(leftRow[1]), right1));
+        res = _mm_add_ps(res, _mm_mul_ps(_mm_set1_ps(leftRow[2]), right2));
+        res = _mm_add_ps(res, _mm_and_ps(_mm_set1_ps(leftRow[3]), translationMask));
+
+        _mm_storeu_ps(result + row * 4, res);
+    }
+#endif
+}
+
+void computeModelTransforms(const float * localTransforms, const uint16_t * parents, uint16_t numBones, float * modelTransforms) {
+    for(uint16_t bone = 0; bone < numBones; bone++) {
+        const float * local = localTransforms + bone * AFFINE_FLOATS;
+        float * model = modelTransforms + bone * AFFINE_FLOATS;
+
+        if(parents[bone] == bone) {
+            memcpy(model, local, AFFINE_FLOATS * sizeof(float));
+        }
+        else {
+            assert(parents[bone] < bone);
+            multiplyAffine(modelTransforms + parents[bone] * AFFINE_FLOATS, local, model);
+        }
+    }
+}
+
+void computeSkinningPalette(const float * modelTransforms, const float * inverseBinds, uint16_t numBones, float * palette) {
+    for(uint16_t bone = 0; bone < numBones; bone++) {
+        multiplyAffine(modelTransforms + bone * AFFINE_FLOATS, inverseBinds + bone * AFFINE_FLOATS, palette + bone * AFFINE_FLOATS);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef ILL_RUNTIME_POSE_H_
+#define ILL_RUNTIME_POSE_H_
+
+#include <stdint.h>
+
+class PoseBuffer;
+
+/**
+Pose evaluation, from local TRS poses to the skinning palette.
+Transforms outside of PoseBuffer are 3x4 row major affine matrices, 12 floats per bone, the same as the ILLSKEL2 bind arrays.
+The bone counts can be less than the skeleton has to only evaluate the bones of a bone LOD.
+*/
+
+//how many floats each 3x4 transform takes
+const unsigned int AFFINE_FLOATS = 12;
+
+/**
+Blends two poses, lerping translation and scale and nlerping rotation the short way around.
+The poses need the same number of bones.  result can be from or to.
+@param weight 0 gives from, 1 gives to.
+*/
+void blendPoses(const PoseBuffer& from, const PoseBuffer& to, float weight, PoseBuffer& result);
+
+//turns the local TRS of the bones into transforms, SIMD_WIDTH bones at a time
+void computeLocalTransforms(const PoseBuffer& pose, uint16_t numBones, float * localTransforms);
+
+/**
+Model space transforms from the local ones going through the bones in index order.
+Every parent has to come before its children, which the converter makes sure of.  Roots are their own parent.
+*/
+void computeModelTransforms(const float * localTransforms, const uint16_t * parents, uint16_t numBones, float * modelTransforms);
+
+//model transform times inverse bind transform for each bone, the matrices skinning uses
+void computeSkinningPalette(const float * modelTransforms, const float * inverseBinds, uint16_t numBones, float * palette);
+
+//result = left * right for 3x4 transforms, result can't be left or right
+void multiplyAffine(const float * left, const float * right, float * result);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include <algorithm>
+
+#include "PoseBuffer.h"
+
+void PoseBuffer::resize(uint16_t numBones) {
+    m_numBones = numBones;
+    m_stride = simdRoundUp(numBones);
+
+    m_storage.assign(NUM_CHANNELS * m_stride, 0.0f);
+
+    std::fill(getChannel(ROTATION_W), getChannel(ROTATION_W) + m_stride, 1.0f);
+    std::fill(getChannel(SCALE_X), getChannel(SCALE_X) + 3 * m_stride, 1.0f);
+}
+
+void PoseBuffer::setTrs(const float * trs) {
+    for(uint16_t bone = 0; bone < m_numBones; bone++) {
+        for(unsigned int channel = 0; channel < NUM_CHANNELS; channel++) {
+            getChannel((Channel) channel)[bone] = trs[bone * NUM_CHANNELS + channel];
+        }
+    }
+}
+
+void PoseBuffer::setBone(uint16_t bone, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale) {
+    getChannel(TRANSLATION_X)[bone] = translation.x;
+    getChannel(TRANSLATION_Y)[bone] = translation.y;
+    getChannel(TRANSLATION_Z)[bone] = translation.z;
+
+    getChannel(ROTATION_X)[bone] = rotation.x;
+    getChannel(ROTATION_Y)[bone] = rotation.y;
+    getChannel(ROTATION_Z)[bone] = rotation.z;
+    getChannel(ROTATION_W)[bone] = rotation.w;
+
+    getChannel(SCALE_X)[bone] = scale.x;
+    getChannel(SCALE_Y)[bone] = scale.y;
+    getChannel(SCALE_Z)[bone] = scale.z;
+}
+
+void PoseBuffer::getBone(uint16_t bone, glm::vec3& translation, glm::quat& rotation, glm::vec3& scale) const {
+    translation.x = getChannel(TRANSLATION_X)[bone];
+    translation.y = getChannel(TRANSLATION_Y)[bone];
+    translation.z = getChannel(TRANSLATION_Z)[bone];
+
+    rotation.x = getChannel(ROTATION_X)[bone];
+    rotation.y = getChannel(ROTATION_Y)[bone];
+    rotation.z = getChannel(ROTATION_Z)[bone];
+    rotation.w = getChannel(ROTATION_W)[bone];
+
+    scale.x = getChannel(SCALE_X)[bone];
+    scale.y = getChannel(SCALE_Y)[bone];
+    scale.z = getChannel(SCALE_Z)[bone];
+}
\ No newline at end of file
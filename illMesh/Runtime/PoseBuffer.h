@@ -0,0 +1,60 @@
+#ifndef ILL_RUNTIME_POSE_BUFFER_H_
+#define ILL_RUNTIME_POSE_BUFFER_H_
+
+#include <stdint.h>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "simd.h"
+
+/**
+The local transforms of the bones in a pose as structure of arrays, one array for each translation, rotation, and scale component,
+so SIMD_WIDTH bones can be worked on at a time.
+Every array is SIMD aligned and padded to a multiple of SIMD_WIDTH with identity transforms.
+*/
+class PoseBuffer {
+public:
+    enum Channel {
+        TRANSLATION_X,
+        TRANSLATION_Y,
+        TRANSLATION_Z,
+        ROTATION_X,
+        ROTATION_Y,
+        ROTATION_Z,
+        ROTATION_W,
+        SCALE_X,
+        SCALE_Y,
+        SCALE_Z,
+
+        NUM_CHANNELS
+    };
+
+    PoseBuffer()
+        : m_numBones(0),
+        m_stride(0)
+    {}
+
+    //makes room for the bones and sets all of them to identity
+    void resize(uint16_t numBones);
+
+    //sets all the bones from 10 floats per bone, translation xyz, rotation quaternion xyzw, scale xyz, same as the ILLSKEL2 bind poses
+    void setTrs(const float * trs);
+
+    void setBone(uint16_t bone, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale);
+    void getBone(uint16_t bone, glm::vec3& translation, glm::quat& rotation, glm::vec3& scale) const;
+
+    inline float * getChannel(Channel channel) {
+        return m_storage.data() + channel * m_stride;
+    }
+
+    inline const float * getChannel(Channel channel) const {
+        return m_storage.data() + channel * m_stride;
+    }
+
+    uint16_t m_numBones;
+    size_t m_stride;                //floats in each channel, m_numBones rounded up to SIMD_WIDTH
+    SimdFloatVector m_storage;      //the channels one after the other
+};
+
+#endif
\ No newline at end of file
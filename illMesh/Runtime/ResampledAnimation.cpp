@@ -0,0 +1,104 @@
+#include <cassert>
+
+#include "ResampledAnimation.h"
+#include "PoseBuffer.h"
+
+//where each frame channel goes in the pose
+const PoseBuffer::Channel POSE_CHANNELS[ResampledAnimation::NUM_CHANNELS] = {
+    PoseBuffer::ROTATION_X,
+    PoseBuffer::ROTATION_Y,
+    PoseBuffer::ROTATION_Z,
+    PoseBuffer::ROTATION_W,
+    PoseBuffer::TRANSLATION_X,
+    PoseBuffer::TRANSLATION_Y,
+    PoseBuffer::TRANSLATION_Z,
+    PoseBuffer::SCALE_X,
+    PoseBuffer::SCALE_Y,
+    PoseBuffer::SCALE_Z
+};
+
+void ResampledAnimation::setFrames(const float * frames, uint16_t numBones, uint32_t numFrames, float frameRate, float duration) {
+    assert(numFrames > 0);
+
+    m_numBones = numBones;
+    m_numFrames = numFrames;
+    m_frameRate = frameRate;
+    m_duration = duration;
+    m_stride = simdRoundUp(numBones);
+
+    //padding lanes are identity rotations so the nlerp doesn't divide by 0
+    m_storage.assign(numFrames * NUM_CHANNELS * m_stride, 0.0f);
+
+    for(uint32_t frame = 0; frame < numFrames; frame++) {
+        float * destination = m_storage.data() + frame * NUM_CHANNELS * m_stride;
+
+        for(unsigned int channel = 0; channel < NUM_CHANNELS; channel++) {
+            float * channelDestination = destination + channel * m_stride;
+            const float * channelSource = frames + (frame * NUM_CHANNELS + channel) * numBones;
+
+            for(uint16_t bone = 0; bone < numBones; bone++) {
+                channelDestination[bone] = channelSource[bone];
+            }
+
+            if(channel == ROTATION_W) {
+                for(size_t bone = numBones; bone < m_stride; bone++) {
+                    channelDestination[bone] = 1.0f;
+                }
+            }
+        }
+    }
+}
+
+void ResampledAnimation::sample(float time, PoseBuffer& pose) const {
+    if(pose.m_numBones != m_numBones) {
+        pose.resize(m_numBones);
+    }
+
+    //find the frames around the time, the last frame is at the duration so the interval before it can be shorter than the others
+    float lastFrame = (float) (m_numFrames - 1);
+    float lastFrameTime = m_duration * m_frameRate < lastFrame ? m_duration * m_frameRate : lastFrame;
+    float frameTime = time * m_frameRate;
+    frameTime = frameTime < 0.0f ? 0.0f : (frameTime > lastFrameTime ? lastFrameTime : frameTime);
+
+    uint32_t fromFrame = (uint32_t) frameTime;
+    fromFrame = fromFrame < m_numFrames ? fromFrame : m_numFrames - 1;
+    uint32_t toFrame = fromFrame + 1 < m_numFrames ? fromFrame + 1 : fromFrame;
+
+    float interval = (toFrame + 1 == m_numFrames ? lastFrameTime : (float) toFrame) - (float) fromFrame;
+
+    const float * from = getFrame(fromFrame);
+    const float * to = getFrame(toFrame);
+    SimdFloat weight = simdSet(interval > 0.0f ? (frameTime - (float) fromFrame) / interval : 0.0f);
+
+    for(size_t bone = 0; bone < m_stride; bone += SIMD_WIDTH) {
+        //translation and scale
+        for(unsigned int channel = TRANSLATION_X; channel < NUM_CHANNELS; channel++) {
+            SimdFloat fromValue = simdLoad(from + channel * m_stride + bone);
+            SimdFloat toValue = simdLoad(to + channel * m_stride + bone);
+
+            simdStore(pose.getChannel(POSE_CHANNELS[channel]) + bone, simdMad(toValue - fromValue, weight, fromValue));
+        }
+
+        //rotation, neighboring frames are already on the same side
+        SimdFloat blended[4];
+
+        for(unsigned int component = 0; component < 4; component++) {
+            SimdFloat fromValue = simdLoad(from + (ROTATION_X + component) * m_stride + bone);
+            SimdFloat toValue = simdLoad(to + (ROTATION_X + component) * m_stride + bone);
+
+            blended[component] = simdMad(toValue - fromValue, weight, fromValue);
+        }
+
+        SimdFloat lengthSquared = blended[0] * blended[0];
+
+        for(unsigned int component = 1; component < 4; component++) {
+            lengthSquared = simdMad(blended[component], blended[component], lengthSquared);
+        }
+
+        SimdFloat invLength = simdSet(1.0f) / simdSqrt(lengthSquared);
+
+        for(unsigned int component = 0; component < 4; component++) {
+            simdStore(pose.getChannel(POSE_CHANNELS[ROTATION_X + component]) + bone, blended[component] * invLength);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#ifndef ILL_RUNTIME_RESAMPLED_ANIMATION_H_
+#define ILL_RUNTIME_RESAMPLED_ANIMATION_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "simd.h"
+
+class PoseBuffer;
+
+/**
+An animation sampled at a fixed frame rate, the layout of ILLANIM2.
+Every frame has all the bones of the skeleton, as structure of arrays with a channel for each rotation, translation, and scale component,
+so sampling is finding the two frames around the time and blending all the bones SIMD_WIDTH at a time, no searching through keys.
+Frames are 1 / m_frameRate apart except the last one, which is at m_duration, so the interval before it can be shorter.
+
+The converter flips rotations so each one is on the same side as the one in the frame before it,
+which lets the blend nlerp without checking for the short way around.
+*/
+class ResampledAnimation {
+public:
+    //the order of the channels in a frame
+    enum Channel {
+        ROTATION_X,
+        ROTATION_Y,
+        ROTATION_Z,
+        ROTATION_W,
+        TRANSLATION_X,
+        TRANSLATION_Y,
+        TRANSLATION_Z,
+        SCALE_X,
+        SCALE_Y,
+        SCALE_Z,
+
+        NUM_CHANNELS
+    };
+
+    ResampledAnimation()
+        : m_numBones(0),
+        m_numFrames(0),
+        m_frameRate(0.0f),
+        m_duration(0.0f),
+        m_stride(0)
+    {}
+
+    /**
+    Copies in the frames as they're stored in the file.
+    @param frames For each frame, each channel's numBones floats one after the other.
+    */
+    void setFrames(const float * frames, uint16_t numBones, uint32_t numFrames, float frameRate, float duration);
+
+    /**
+    Blends the two frames around a time into the pose, times outside the animation are clamped to it.
+    The pose is resized to the animation's bones if it doesn't match.
+    */
+    void sample(float time, PoseBuffer& pose) const;
+
+    inline const float * getFrame(uint32_t frame) const {
+        return m_storage.data() + frame * NUM_CHANNELS * m_stride;
+    }
+
+    uint16_t m_numBones;
+    uint32_t m_numFrames;
+    float m_frameRate;
+    float m_duration;
+    size_t m_stride;                //floats in each channel of a frame, m_numBones rounded up to SIMD_WIDTH
+    SimdFloatVector m_storage;      //the frames one after the other
+};
+
+#endif
\ No newline at end of file
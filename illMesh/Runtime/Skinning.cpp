@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <cassert>
+
+#include "Skinning.h"
+#include "Pose.h"
+
+void SkinningMesh::setVertices(const float * vertices, size_t vertexSize, uint32_t numVertices, FeaturesMask features) {
+    m_numVertices = numVertices;
+    m_stride = simdRoundUp(numVertices);
+    m_hasNormals = (features & MeshFeatures::MF_NORMAL) != 0;
+    m_maxBone = 0;
+
+    m_storage.assign(NUM_CHANNELS * m_stride, 0.0f);
+    m_bones.assign(numVertices * MAX_INFLUENCES, 0);
+    m_weights.assign(numVertices * MAX_INFLUENCES, 0.0f);
+
+    //where everything is in a vertex, in the order Mesh::save writes it
+    size_t positionOffset = 0;
+    size_t normalOffset = positionOffset + ((features & MeshFeatures::MF_POSITION) ? 3 : 0);
+    size_t blendOffset = normalOffset + (m_hasNormals ? 3 : 0) + ((features & MeshFeatures::MF_TANGENT) ? 6 : 0);
+
+    for(uint32_t vertex = 0; vertex < numVertices; vertex++) {
+        const float * currVertex = vertices + vertex * vertexSize;
+
+        if(features & MeshFeatures::MF_POSITION) {
+            getChannel(POSITION_X)[vertex] = currVertex[positionOffset];
+            getChannel(POSITION_Y)[vertex] = currVertex[positionOffset + 1];
+            getChannel(POSITION_Z)[vertex] = currVertex[positionOffset + 2];
+        }
+
+        if(m_hasNormals) {
+            getChannel(NORMAL_X)[vertex] = currVertex[normalOffset];
+            getChannel(NORMAL_Y)[vertex] = currVertex[normalOffset + 1];
+            getChannel(NORMAL_Z)[vertex] = currVertex[normalOffset + 2];
+        }
+
+        //bone indices are saved as floats, then the weights
+        if(features & MeshFeatures::MF_BLEND_DATA) {
+            for(unsigned int slot = 0; slot < MAX_INFLUENCES; slot++) {
+                m_weights[vertex * MAX_INFLUENCES + slot] = currVertex[blendOffset + MAX_INFLUENCES + slot];
+
+                if(m_weights[vertex * MAX_INFLUENCES + slot] > 0.0f) {
+                    m_bones[vertex * MAX_INFLUENCES + slot] = (uint16_t) currVertex[blendOffset + slot];
+                    m_maxBone = std::max(m_maxBone, m_bones[vertex * MAX_INFLUENCES + slot]);
+                }
+            }
+        }
+    }
+}
+
+//weighted sum of the palette transforms of a vertex's bones, reading whole rows so there are no gathers
+inline void blendPalette(const float * palette, const uint16_t * bones, const float * weights, float * blended) {
+    //no weights, leave the vertex where it is
+    if(weights[0] <= 0.0f) {
+        for(unsigned int element = 0; element < AFFINE_FLOATS; element++) {
+            blended[element] = (element % 5 == 0) ? 1.0f : 0.0f;
+        }
+
+        return;
+    }
+
+#ifdef ILL_SIMD_SCALAR
+    for(unsigned int element = 0; element < AFFINE_FLOATS; element++) {
+        blended[element] = weights[0] * palette[bones[0] * AFFINE_FLOATS + element];
+    }
+
+    for(unsigned int slot = 1; slot < SkinningMesh::MAX_INFLUENCES && weights[slot] > 0.0f; slot++) {
+        for(unsigned int element = 0; element < AFFINE_FLOATS; element++) {
+            blended[element] += weights[slot] * palette[bones[slot] * AFFINE_FLOATS + element];
+        }
+    }
+#else
+    const float * transform = palette + bones[0] * AFFINE_FLOATS;
+    __m128 weight = _mm_set1_ps(weights[0]);
+
+    __m128 row0 = _mm_mul_ps(weight, _mm_loadu_ps(transform));
+    __m128 row1 = _mm_mul_ps(weight, _mm_loadu_ps(transform + 4));
+    __m128 row2 = _mm_mul_ps(weight, _mm_loadu_ps(transform + 8));
+
+    //the weights are strongest first so the first empty slot ends it
+    for(unsigned int slot = 1; slot < SkinningMesh::MAX_INFLUENCES && weights[slot] > 0.0f; slot++) {
+        transform = palette + bones[slot] * AFFINE_FLOATS;
+        weight = _mm_set1_ps(weights[slot]);
+
+        row0 = _mm_add_ps(row0, _mm_mul_ps(weight, _mm_loadu_ps(transform)));
+        row1 = _mm_add_ps(row1, _mm_mul_ps(weight, _mm_loadu_ps(transform + 4)));
+        row2 = _mm_add_ps(row2, _mm_mul_ps(weight, _mm_loadu_ps(transform + 8)));
+    }
+
+    _mm_storeu_ps(blended, row0);
+    _mm_storeu_ps(blended + 4, row1);
+    _mm_storeu_ps(blended + 8, row2);
+#endif
+}
+
+void skinVertices(const SkinningMesh& mesh, const float * palette, uint32_t beginVertex, uint32_t endVertex, float * positions, float * normals) {
+    assert(beginVertex % SIMD_WIDTH == 0);
+    assert(endVertex <= mesh.m_numVertices);
+
+    if(!mesh.m_hasNormals) {
+        normals = NULL;
+    }
+
+    //the blended transforms of SIMD_WIDTH vertices as structure of arrays, then the skinned results the same way
+    float blockBuffer[(AFFINE_FLOATS + 6) * SIMD_WIDTH + SIMD_WIDTH];
+    float * transforms = simdAlign(blockBuffer);
+    float * results = transforms + AFFINE_FLOATS * SIMD_WIDTH;
+
+    for(uint32_t firstVertex = beginVertex; firstVertex < endVertex; firstVertex += SIMD_WIDTH) {
+        uint32_t blockVertices = std::min((uint32_t) SIMD_WIDTH, endVertex - firstVertex);
+
+        for(uint32_t lane = 0; lane < SIMD_WIDTH; lane++) {
+            float blended[AFFINE_FLOATS];
+
+            if(lane < blockVertices) {
+                uint32_t vertex = firstVertex + lane;
+
+                blendPalette(palette,
+                    &mesh.m_bones[vertex * SkinningMesh::MAX_INFLUENCES],
+                    &mesh.m_weights[vertex * SkinningMesh::MAX_INFLUENCES],
+                    blended);
+            }
+            else {
+                std::fill(blended, blended + AFFINE_FLOATS, 0.0f);
+            }
+
+            for(unsigned int element = 0; element < AFFINE_FLOATS; element++) {
+                transforms[element * SIMD_WIDTH + lane] = blended[element];
+            }
+        }
+
+        SimdFloat matrix[AFFINE_FLOATS];
+
+        for(unsigned int element = 0; element < AFFINE_FLOATS; element++) {
+            matrix[element] = simdLoad(transforms + element * SIMD_WIDTH);
+        }
+
+        //positions get the full transform
+        {
+            SimdFloat x = simdLoad(mesh.getChannel(SkinningMesh::POSITION_X) + firstVertex);
+            SimdFloat y = simdLoad(mesh.getChannel(SkinningMesh::POSITION_Y) + firstVertex);
+            SimdFloat z = simdLoad(mesh.getChannel(SkinningMesh::POSITION_Z) + firstVertex);
+
+            for(unsigned int row = 0; row < 3; row++) {
+                simdStore(results + row * SIMD_WIDTH,
+                    simdMad(matrix[row * 4], x, simdMad(matrix[row * 4 + 1], y, simdMad(matrix[row * 4 + 2], z, matrix[row * 4 + 3]))));
+            }
+        }
+
+        //normals only get the 3x3 part, the inverse transpose is skipped like linear blend skinning usually does
+        if(normals) {
+            SimdFloat x = simdLoad(mesh.getChannel(SkinningMesh::NORMAL_X) + firstVertex);
+            SimdFloat y = simdLoad(mesh.getChannel(SkinningMesh::NORMAL_Y) + firstVertex);
+            SimdFloat z = simdLoad(mesh.getChannel(SkinningMesh::NORMAL_Z) + firstVertex);
+
+            SimdFloat normal[3];
+
+            for(unsigned int row = 0; row < 3; row++) {
+                normal[row] = simdMad(matrix[row * 4], x, simdMad(matrix[row * 4 + 1], y, matrix[row * 4 + 2] * z));
+            }
+
+            //padding lanes have all zero transforms, keep them from dividing by 0
+            SimdFloat invLength = simdSet(1.0f) / simdSqrt(simdMad(normal[0], normal[0], simdMad(normal[1], normal[1], simdMad(normal[2], normal[2], simdSet(1e-20f)))));
+
+            for(unsigned int row = 0; row < 3; row++) {
+                simdStore(results + (3 + row) * SIMD_WIDTH, normal[row] * invLength);
+            }
+        }
+
+        //back to 3 floats per vertex
+        for(uint32_t lane = 0; lane < blockVertices; lane++) {
+            float * position = positions + (firstVertex + lane) * 3;
+
+            for(unsigned int component = 0; component < 3; component++) {
+                position[component] = results[component * SIMD_WIDTH + lane];
+            }
+
+            if(normals) {
+                float * normal = normals + (firstVertex + lane) * 3;
+
+                for(unsigned int component = 0; component < 3; component++) {
+                    normal[component] = results[(3 + component) * SIMD_WIDTH + lane];
+                }
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef ILL_RUNTIME_SKINNING_H_
+#define ILL_RUNTIME_SKINNING_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "illEngine/Util/Geometry/MeshData.h"
+
+#include "simd.h"
+
+/**
+The parts of a mesh CPU skinning needs, pulled out of the interleaved vertices once.
+Positions and normals are structure of arrays, SIMD aligned and padded to a multiple of SIMD_WIDTH.
+The influences stay per vertex since each vertex reads whole palette rows for its own bones.
+*/
+class SkinningMesh {
+public:
+    enum Channel {
+        POSITION_X,
+        POSITION_Y,
+        POSITION_Z,
+        NORMAL_X,
+        NORMAL_Y,
+        NORMAL_Z,
+
+        NUM_CHANNELS
+    };
+
+    static const unsigned int MAX_INFLUENCES = 4;
+
+    SkinningMesh()
+        : m_numVertices(0),
+        m_stride(0),
+        m_hasNormals(false),
+        m_maxBone(0)
+    {}
+
+    /**
+    Takes the positions, normals, and blend data out of interleaved vertices laid out the way Mesh::save writes them.
+    @param vertexSize Floats per vertex.
+    */
+    void setVertices(const float * vertices, size_t vertexSize, uint32_t numVertices, FeaturesMask features);
+
+    inline float * getChannel(Channel channel) {
+        return m_storage.data() + channel * m_stride;
+    }
+
+    inline const float * getChannel(Channel channel) const {
+        return m_storage.data() + channel * m_stride;
+    }
+
+    uint32_t m_numVertices;
+    size_t m_stride;                //floats in each channel, m_numVertices rounded up to SIMD_WIDTH
+    bool m_hasNormals;
+
+    SimdFloatVector m_storage;      //the channels one after the other
+
+    std::vector<uint16_t> m_bones;  //MAX_INFLUENCES per vertex
+    std::vector<float> m_weights;   //MAX_INFLUENCES per vertex, strongest first, 0 for unused slots
+    uint16_t m_maxBone;             //highest bone index used, the palette needs at least this many bones plus 1
+};
+
+/**
+Linear blend skins a range of the vertices with a skinning palette from computeSkinningPalette.
+Vertices without any weight keep their bind position.  Normals are renormalized after blending.
+The output is 3 floats per vertex indexed by vertex, so threads can each skin their own range into the same arrays.
+@param beginVertex Has to be a multiple of SIMD_WIDTH.
+@param normals Can be NULL to only skin positions.
+*/
+void skinVertices(const SkinningMesh& mesh, const float * palette, uint32_t beginVertex, uint32_t endVertex, float * positions, float * normals);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,290 @@
+#ifndef ILL_RUNTIME_SIMD_H_
+#define ILL_RUNTIME_SIMD_H_
+
+/**
+A thin wrapper over the SIMD float vectors used by the runtime pose and skinning code.
+AVX2 builds work on 8 floats at a time, SSE builds on 4, and anything else falls back to 4 plain floats.
+Define ILL_SIMD_SCALAR to force the fallback, useful for checking the SIMD paths against it.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#if !defined(ILL_SIMD_SCALAR) && defined(__AVX2__)
+#define ILL_SIMD_AVX2
+#include <immintrin.h>
+#elif !defined(ILL_SIMD_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define ILL_SIMD_SSE
+#include <emmintrin.h>
+#else
+#ifndef ILL_SIMD_SCALAR
+#define ILL_SIMD_SCALAR
+#endif
+#include <cmath>
+#endif
+
+#ifdef ILL_SIMD_AVX2
+const size_t SIMD_WIDTH = 8;
+#else
+const size_t SIMD_WIDTH = 4;
+#endif
+
+//alignment in bytes that simdLoad and simdStore need
+const size_t SIMD_ALIGNMENT = SIMD_WIDTH * sizeof(float);
+
+//first SIMD aligned float at or after data
+inline float * simdAlign(float * data) {
+    return (float *) (((uintptr_t) data + SIMD_ALIGNMENT - 1) & ~(uintptr_t) (SIMD_ALIGNMENT - 1));
+}
+
+inline const float * simdAlign(const float * data) {
+    return simdAlign((float *) data);
+}
+
+//count rounded up to a multiple of SIMD_WIDTH
+inline size_t simdRoundUp(size_t count) {
+    return (count + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+}
+
+/**
+Allocates SIMD aligned memory for std::vector, so the data of a copy is aligned the same as the original.
+The pointer malloc gave is kept just before the aligned block.
+*/
+template <typename T>
+class SimdAllocator {
+public:
+    typedef T value_type;
+    typedef T * pointer;
+    typedef const T * const_pointer;
+    typedef T & reference;
+    typedef const T & const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <typename Other>
+    struct rebind {
+        typedef SimdAllocator<Other> other;
+    };
+
+    SimdAllocator() {}
+
+    template <typename Other>
+    SimdAllocator(const SimdAllocator<Other>&) {}
+
+    pointer address(reference value) const {
+        return &value;
+    }
+
+    const_pointer address(const_reference value) const {
+        return &value;
+    }
+
+    pointer allocate(size_type count, const void * = NULL) {
+        void * block = malloc(count * sizeof(T) + SIMD_ALIGNMENT + sizeof(void *));
+
+        if(!block) {
+            throw std::bad_alloc();
+        }
+
+        uintptr_t aligned = ((uintptr_t) block + sizeof(void *) + SIMD_ALIGNMENT - 1) & ~(uintptr_t) (SIMD_ALIGNMENT - 1);
+        ((void **) aligned)[-1] = block;
+
+        return (pointer) aligned;
+    }
+
+    void deallocate(pointer data, size_type) {
+        if(data) {
+            free(((void **) data)[-1]);
+        }
+    }
+
+    size_type max_size() const {
+        return ((size_type) -1 - SIMD_ALIGNMENT - sizeof(void *)) / sizeof(T);
+    }
+
+    void construct(pointer data, const T& value) {
+        new ((void *) data) T(value);
+    }
+
+    void destroy(pointer data) {
+        data->~T();
+    }
+};
+
+template <typename Left, typename Right>
+inline bool operator==(const SimdAllocator<Left>&, const SimdAllocator<Right>&) {
+    return true;
+}
+
+template <typename Left, typename Right>
+inline bool operator!=(const SimdAllocator<Left>&, const SimdAllocator<Right>&) {
+    return false;
+}
+
+//floats whose first element is always SIMD aligned, copies included
+typedef std::vector<float, SimdAllocator<float> > SimdFloatVector;
+
+struct SimdFloat {
+#if defined(ILL_SIMD_AVX2)
+    __m256 m_value;
+#elif defined(ILL_SIMD_SSE)
+    __m128 m_value;
+#else
+    float m_value[SIMD_WIDTH];
+#endif
+};
+
+#if defined(ILL_SIMD_AVX2)
+
+inline SimdFloat simdMake(__m256 value) {
+    SimdFloat res;
+    res.m_value = value;
+    return res;
+}
+
+inline SimdFloat simdLoad(const float * data) { return simdMake(_mm256_load_ps(data)); }
+inline void simdStore(float * data, SimdFloat value) { _mm256_store_ps(data, value.m_value); }
+inline SimdFloat simdSet(float value) { return simdMake(_mm256_set1_ps(value)); }
+
+inline SimdFloat operator+(SimdFloat left, SimdFloat right) { return simdMake(_mm256_add_ps(left.m_value, right.m_value)); }
+inline SimdFloat operator-(SimdFloat left, SimdFloat right) { return simdMake(_mm256_sub_ps(left.m_value, right.m_value)); }
+inline SimdFloat operator*(SimdFloat left, SimdFloat right) { return simdMake(_mm256_mul_ps(left.m_value, right.m_value)); }
+inline SimdFloat operator/(SimdFloat left, SimdFloat right) { return simdMake(_mm256_div_ps(left.m_value, right.m_value)); }
+
+//mul * add + plus
+inline SimdFloat simdMad(SimdFloat mul, SimdFloat add, SimdFloat plus) {
+#ifdef __FMA__
+    return simdMake(_mm256_fmadd_ps(mul.m_value, add.m_value, plus.m_value));
+#else
+    return simdMake(_mm256_add_ps(_mm256_mul_ps(mul.m_value, add.m_value), plus.m_value));
+#endif
+}
+
+inline SimdFloat simdSqrt(SimdFloat value) { return simdMake(_mm256_sqrt_ps(value.m_value)); }
+inline SimdFloat simdMax(SimdFloat left, SimdFloat right) { return simdMake(_mm256_max_ps(left.m_value, right.m_value)); }
+
+//magnitude with the sign of sign
+inline SimdFloat simdCopySign(SimdFloat magnitude, SimdFloat sign) {
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+    return simdMake(_mm256_or_ps(_mm256_andnot_ps(signMask, magnitude.m_value), _mm256_and_ps(signMask, sign.m_value)));
+}
+
+#elif defined(ILL_SIMD_SSE)
+
+inline SimdFloat simdMake(__m128 value) {
+    SimdFloat res;
+    res.m_value = value;
+    return res;
+}
+
+inline SimdFloat simdLoad(const float * data) { return simdMake(_mm_load_ps(data)); }
+inline void simdStore(float * data, SimdFloat value) { _mm_store_ps(data, value.m_value); }
+inline SimdFloat simdSet(float value) { return simdMake(_mm_set1_ps(value)); }
+
+inline SimdFloat operator+(SimdFloat left, SimdFloat right) { return simdMake(_mm_add_ps(left.m_value, right.m_value)); }
+inline SimdFloat operator-(SimdFloat left, SimdFloat right) { return simdMake(_mm_sub_ps(left.m_value, right.m_value)); }
+inline SimdFloat operator*(SimdFloat left, SimdFloat right) { return simdMake(_mm_mul_ps(left.m_value, right.m_value)); }
+inline SimdFloat operator/(SimdFloat left, SimdFloat right) { return simdMake(_mm_div_ps(left.m_value, right.m_value)); }
+
+//mul * add + plus
+inline SimdFloat simdMad(SimdFloat mul, SimdFloat add, SimdFloat plus) {
+    return simdMake(_mm_add_ps(_mm_mul_ps(mul.m_value, add.m_value), plus.m_value));
+}
+
+inline SimdFloat simdSqrt(SimdFloat value) { return simdMake(_mm_sqrt_ps(value.m_value)); }
+inline SimdFloat simdMax(SimdFloat left, SimdFloat right) { return simdMake(_mm_max_ps(left.m_value, right.m_value)); }
+
+//magnitude with the sign of sign
+inline SimdFloat simdCopySign(SimdFloat magnitude, SimdFloat sign) {
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+
+    return simdMake(_mm_or_ps(_mm_andnot_ps(signMask, magnitude.m_value), _mm_and_ps(signMask, sign.m_value)));
+}
+
+#else
+
+inline SimdFloat simdLoad(const float * data) {
+    SimdFloat res;
+
+    for(size_t lane = 0; lane < SIMD_WIDTH; lane++) {
+        res.m_value[lane] = data[lane];
+    }
+
+    return res;
+}
+
+inline void simdStore(float * data, SimdFloat value) {
+    for(size_t lane = 0; lane < SIMD_WIDTH; lane++) {
+        data[lane] = value.m_value[lane];
+    }
+}
+
+inline SimdFloat simdSet(float value) {
+    SimdFloat res;
+
+    for(size_t lane = 0; lane < SIMD_WIDTH; lane++) {
+        res.m_value[lane] = value;
+    }
+
+    return res;
+}
+
+#define ILL_SIMD_SCALAR_OPERATOR(op) \
+    inline SimdFloat operator op(SimdFloat left, SimdFloat right) { \
+        SimdFloat res; \
+        for(size_t lane = 0; lane < SIMD_WIDTH; lane++) { \
+            res.m_value[lane] = left.m_value[lane] op right.m_value[lane]; \
+        } \
+        return res; \
+    }
+
+ILL_SIMD_SCALAR_OPERATOR(+)
+ILL_SIMD_SCALAR_OPERATOR(-)
+ILL_SIMD_SCALAR_OPERATOR(*)
+ILL_SIMD_SCALAR_OPERATOR(/)
+
+#undef ILL_SIMD_SCALAR_OPERATOR
+
+//mul * add + plus
+inline SimdFloat simdMad(SimdFloat mul, SimdFloat add, SimdFloat plus) {
+    return mul * add + plus;
+}
+
+inline SimdFloat simdSqrt(SimdFloat value) {
+    SimdFloat res;
+
+    for(size_t lane = 0; lane < SIMD_WIDTH; lane++) {
+        res.m_value[lane] = sqrtf(value.m_value[lane]);
+    }
+
+    return res;
+}
+
+inline SimdFloat simdMax(SimdFloat left, SimdFloat right) {
+    SimdFloat res;
+
+    for(size_t lane = 0; lane < SIMD_WIDTH; lane++) {
+        res.m_value[lane] = left.m_value[lane] > right.m_value[lane] ? left.m_value[lane] : right.m_value[lane];
+    }
+
+    return res;
+}
+
+//magnitude with the sign of sign
+inline SimdFloat simdCopySign(SimdFloat magnitude, SimdFloat sign) {
+    SimdFloat res;
+
+    for(size_t lane = 0; lane < SIMD_WIDTH; lane++) {
+        res.m_value[lane] = sign.m_value[lane] < 0.0f ? -fabsf(magnitude.m_value[lane]) : fabsf(magnitude.m_value[lane]);
+    }
+
+    return res;
+}
+
+#endif
+
+#endif
\ No newline at end of file